@@ -0,0 +1,216 @@
+#include "bench.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <vector>
+
+#include "interpreter.hpp"
+#include "parse.hpp"
+
+// every allocation made by the benchmarks executable is counted, and each
+// block is preceded by its size so that the bytes still held are known
+static std::atomic<std::size_t> allocationCount(0);
+static std::atomic<std::size_t> allocatedBytes(0);
+static std::atomic<std::size_t> liveBytes(0);
+
+static const std::size_t BLOCK_HEADER = alignof(std::max_align_t);
+
+void * operator new(std::size_t size) {
+  ++allocationCount;
+  allocatedBytes += size;
+  liveBytes += size;
+  char * p = static_cast<char *>(std::malloc(size + BLOCK_HEADER));
+  if (p == nullptr)
+    throw std::bad_alloc();
+  *reinterpret_cast<std::size_t *>(p) = size;
+  return p + BLOCK_HEADER;
+}
+
+void operator delete(void * p) noexcept {
+  if (p == nullptr)
+    return;
+  char * block = static_cast<char *>(p) - BLOCK_HEADER;
+  liveBytes -= *reinterpret_cast<std::size_t *>(block);
+  std::free(block);
+}
+
+// the number of nodes in the parsed program
+static std::size_t countNodes(const Expression & exp) {
+
+  std::size_t count = 1;
+  for (auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e)
+    count += countNodes(*e);
+  return count;
+}
+
+static const char * PROGRAMS[][2] = {
+  {"arithmetic", "(+ (* 2 3) (- 7 1) (/ 8 2) (^ 2 10) (sqrt 16))"},
+  {"list building", "(join (list 1 2 3 (list 4 5 (list 6 7))) (rest (range 0 20 1)))"},
+  {"lambda calls", "(begin (define f (lambda (x y) (+ (* x x) y))) (f (f 1 2) (f 3 4)))"},
+  {"map over list", "(begin (define sq (lambda (x) (* x x))) (map sq (range 0 50 1)))"},
+  {"properties", "(get-property \"note\" (set-property \"note\" (list 1 2) (list 3 4 5)))"},
+  {"discrete plot", "(discrete-plot (list (list -1 -1) (list 1 1) (list 2 4)) (list (list \"title\" \"t\")))"}
+};
+
+// heap allocations made while evaluating an already parsed program,
+// normalized by the size of the program
+BENCHMARK_CASE(allocations_per_node) {
+
+  for (auto & program : PROGRAMS) {
+    std::istringstream source(program[1]);
+    std::size_t nodes = countNodes(parse(tokenize(source)));
+
+    Interpreter interp;
+    std::istringstream iss(program[1]);
+    interp.parseStream(iss);
+
+    const std::size_t iterations = 200;
+    std::size_t before = allocationCount;
+    for (std::size_t i = 0; i < iterations; ++i)
+      doNotOptimize(interp.evaluate());
+    std::size_t allocations = allocationCount - before;
+
+    bench.report(std::string(program[0]) + ", allocations/node",
+                 double(allocations) / iterations / nodes, "allocs");
+  }
+}
+
+static Expression evaluate(Interpreter & interp, const std::string & program) {
+
+  std::istringstream iss(program);
+  interp.parseStream(iss);
+  return interp.evaluate();
+}
+
+// bytes allocated passing a 100k element list through ten nested procedure
+// calls, in units of the bytes allocated to build the list
+BENCHMARK_CASE(list_through_calls) {
+
+  Interpreter interp;
+  evaluate(interp, "(define f0 (lambda (x) (first (list x))))");
+  for (int i = 1; i < 10; ++i) {
+    evaluate(interp, "(define f" + std::to_string(i) + " (lambda (x) (f"
+             + std::to_string(i - 1) + " x)))");
+  }
+
+  std::size_t before = allocatedBytes;
+  evaluate(interp, "(define l (range 0 99999 1))");
+  double listBytes = allocatedBytes - before;
+
+  before = allocatedBytes;
+  Expression result = evaluate(interp, "(f9 l)");
+  double callBytes = allocatedBytes - before;
+
+  bench.report("list size", listBytes / 1024, "KiB");
+  bench.report("allocated by 10 calls", callBytes / 1024, "KiB");
+  bench.report("allocated by 10 calls / list size", callBytes / listBytes, "lists");
+}
+
+// parse and evaluate a discrete plot of many points, with and without arenas
+BENCHMARK_CASE(arena_plot) {
+
+  std::string program = "(discrete-plot (list";
+  for (int i = 0; i < 2000; ++i)
+    program += " (list " + std::to_string(i) + " " + std::to_string((i * 7919) % 1000 - 500) + ")";
+  program += ") (list (list \"title\" \"arena\") (list \"text-scale\" 2)))";
+
+  for (bool arenas : {false, true}) {
+    Interpreter interp;
+    interp.useArenas(arenas);
+    std::string label = arenas ? "arenas" : "heap";
+
+    const std::size_t iterations = 20;
+    std::size_t before = allocationCount;
+    bench.run("parse and evaluate, " + label, iterations, [&] {
+      std::istringstream iss(program);
+      interp.parseStream(iss);
+      doNotOptimize(interp.evaluate());
+    });
+    bench.report("allocations per run, " + label,
+                 double(allocationCount - before) / iterations, "allocs");
+  }
+}
+
+// the bytes a node takes, and those allocated for the properties of a
+// graphic primitive built property by property, on the heap
+BENCHMARK_CASE(property_memory) {
+
+  bench.report("sizeof(Expression)", sizeof(Expression), "bytes");
+
+  const std::size_t count = 10000;
+  std::vector<Expression> nodes;
+  nodes.reserve(count);
+
+  Atom text("text");
+  text.setStringLiteral();
+  Atom point("point");
+  point.setStringLiteral();
+
+  std::size_t before = allocatedBytes, allocations = allocationCount;
+  for (std::size_t i = 0; i < count; ++i) {
+    Expression p{Atom(double(i))};
+    p.setProperty("object-name", Expression(point));
+    p.setProperty("size", Expression(1.0));
+    nodes.push_back(std::move(p));
+  }
+  bench.report("point properties, bytes/node", double(allocatedBytes - before) / count, "bytes");
+  bench.report("point properties, allocations/node", double(allocationCount - allocations) / count, "allocs");
+  nodes.clear();
+
+  before = allocatedBytes;
+  allocations = allocationCount;
+  for (std::size_t i = 0; i < count; ++i) {
+    Expression t{Atom(double(i))};
+    t.setProperty("object-name", Expression(text));
+    t.setProperty("position", Expression(Atom(0.0)));
+    t.setProperty("text-scale", Expression(1.0));
+    t.setProperty("text-rotation", Expression(0.0));
+    nodes.push_back(std::move(t));
+  }
+  bench.report("text properties, bytes/node", double(allocatedBytes - before) / count, "bytes");
+  bench.report("text properties, allocations/node", double(allocationCount - allocations) / count, "allocs");
+  nodes.clear();
+
+  before = allocatedBytes;
+  allocations = allocationCount;
+  for (std::size_t i = 0; i < count; ++i) {
+    Expression n{Atom(double(i))};
+    n.setProperty("note", Expression(1.0));
+    nodes.push_back(std::move(n));
+  }
+  bench.report("one other property, bytes/node", double(allocatedBytes - before) / count, "bytes");
+
+  const std::size_t reads = 1000000;
+  Expression t(Atom(1.0));
+  t.setProperty("object-name", Expression(text));
+  t.setProperty("text-scale", Expression(2.0));
+  bench.run("get object-name and text-scale", reads, [&] {
+    doNotOptimize(t.get_property("object-name"));
+    doNotOptimize(t.get_property("text-scale"));
+  });
+}
+
+// the bytes held by a list of a million numbers, and the time to build it
+BENCHMARK_CASE(range_memory) {
+
+  bench.report("sizeof(Atom)", sizeof(Atom), "bytes");
+  bench.report("sizeof(Expression)", sizeof(Expression), "bytes");
+
+  // without folding, the program would hold a second copy of the list
+  Interpreter interp;
+  interp.useFolding(false);
+  const std::string program = "(range 0 1000000 1)";
+
+  std::size_t before = liveBytes;
+  Expression list = evaluate(interp, program);
+  double held = double(liveBytes - before);
+  bench.report("held by the list", held / (1 << 20), "MiB");
+  bench.report("held per element", held / list.listLength(), "bytes");
+
+  bench.run("evaluate " + program, 10, [&] {
+    doNotOptimize(evaluate(interp, program));
+  });
+}
@@ -0,0 +1,74 @@
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+// chunk sizes grow geometrically between these bounds
+static const std::size_t FIRST_CHUNK_SIZE = 4096;
+static const std::size_t MAX_CHUNK_SIZE = 1 << 20;
+
+// every allocation is aligned for any type
+static const std::size_t ALIGNMENT = alignof(std::max_align_t);
+
+Arena::~Arena() {
+
+  for (auto & chunk : m_chunks)
+    ::operator delete(chunk.begin);
+}
+
+void * Arena::allocate(std::size_t size) {
+
+  size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+  if (static_cast<std::size_t>(m_end - m_next) < size) {
+    std::size_t chunkSize = m_chunks.empty() ? FIRST_CHUNK_SIZE
+      : std::min(2 * m_chunks.back().size, MAX_CHUNK_SIZE);
+    chunkSize = std::max(chunkSize, size);
+
+    char * begin = static_cast<char *>(::operator new(chunkSize));
+    m_chunks.push_back(Chunk{begin, chunkSize});
+    m_next = begin;
+    m_end = begin + chunkSize;
+  }
+
+  void * result = m_next;
+  m_next += size;
+  m_allocated += size;
+  return result;
+}
+
+bool Arena::owns(const void * p) const noexcept {
+
+  // newest first: what is freed during an evaluation was mostly allocated
+  // recently
+  std::uintptr_t address = reinterpret_cast<std::uintptr_t>(p);
+  for (auto chunk = m_chunks.rbegin(); chunk != m_chunks.rend(); ++chunk) {
+    std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(chunk->begin);
+    if (address >= begin && address < begin + chunk->size)
+      return true;
+  }
+  return false;
+}
+
+std::size_t Arena::bytesAllocated() const noexcept {
+  return m_allocated;
+}
+
+std::shared_ptr<Arena> & Arena::currentSlot() noexcept {
+  static thread_local std::shared_ptr<Arena> current;
+  return current;
+}
+
+const std::shared_ptr<Arena> & Arena::current() noexcept {
+  return currentSlot();
+}
+
+ArenaScope::ArenaScope(std::shared_ptr<Arena> arena):
+  m_previous(std::move(Arena::currentSlot())) {
+
+  Arena::currentSlot() = std::move(arena);
+}
+
+ArenaScope::~ArenaScope() {
+  Arena::currentSlot() = std::move(m_previous);
+}
@@ -0,0 +1,139 @@
+/*! \file arena.hpp
+Defines the Arena bump allocator backing the expressions built during one
+parse or one evaluation, and the standard allocator drawing from it.
+
+The Interpreter makes a fresh Arena current for each parse and each
+evaluation. Expression tails and property maps allocated while it is
+current are carved out of a few large chunks, and freeing them costs
+nothing. Each allocation keeps its Arena alive, so the chunks are released
+in one shot when the last expression using them goes away: at the end of
+the evaluation for temporaries, or when the consumer drops the result.
+ */
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+/*! \class Arena
+\brief A bump allocator releasing all its memory at once when destroyed.
+
+Allocation is not thread-safe: an Arena is only allocated from by the thread
+it is current in (see ArenaScope).
+ */
+class Arena {
+public:
+
+  Arena() = default;
+  Arena(const Arena &) = delete;
+  Arena & operator=(const Arena &) = delete;
+
+  /// free all chunks
+  ~Arena();
+
+  /*! Allocate memory aligned for any type.
+    \param size the number of bytes
+    \return the memory, valid until the Arena is destroyed
+   */
+  void * allocate(std::size_t size);
+
+  /// true if p points into memory allocated by this arena
+  bool owns(const void * p) const noexcept;
+
+  /// the number of bytes handed out so far
+  std::size_t bytesAllocated() const noexcept;
+
+  /// the arena current in this thread, or nullptr
+  static const std::shared_ptr<Arena> & current() noexcept;
+
+private:
+
+  friend class ArenaScope;
+
+  struct Chunk {
+    char * begin;
+    std::size_t size;
+  };
+
+  std::vector<Chunk> m_chunks;
+  char * m_next = nullptr;
+  char * m_end = nullptr;
+  std::size_t m_allocated = 0;
+
+  static std::shared_ptr<Arena> & currentSlot() noexcept;
+};
+
+/*! \class ArenaScope
+\brief Makes an Arena current in this thread for the lifetime of the scope.
+ */
+class ArenaScope {
+public:
+
+  /// make arena (possibly nullptr, for the heap) current
+  explicit ArenaScope(std::shared_ptr<Arena> arena);
+
+  /// restore the previously current arena
+  ~ArenaScope();
+
+  ArenaScope(const ArenaScope &) = delete;
+  ArenaScope & operator=(const ArenaScope &) = delete;
+
+private:
+  std::shared_ptr<Arena> m_previous;
+};
+
+/*! \class ArenaAllocator
+\brief A standard allocator drawing from the Arena current at its
+       construction, or from the heap when there is none.
+
+Once its Arena is no longer current (the evaluation that made it is over)
+further allocations go to the heap, so containers allocated in an arena
+can keep growing safely from any thread.
+ */
+template<typename T>
+class ArenaAllocator {
+public:
+  typedef T value_type;
+
+  /// allocate from the current arena
+  ArenaAllocator() noexcept: m_arena(Arena::current()) {}
+
+  /// allocate from the given arena, or the heap if nullptr
+  explicit ArenaAllocator(std::shared_ptr<Arena> arena) noexcept: m_arena(std::move(arena)) {}
+
+  template<typename U>
+  ArenaAllocator(const ArenaAllocator<U> & other) noexcept: m_arena(other.arena()) {}
+
+  T * allocate(std::size_t n) {
+    if (m_arena && m_arena == Arena::current())
+      return static_cast<T *>(m_arena->allocate(n * sizeof(T)));
+    return static_cast<T *>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T * p, std::size_t) noexcept {
+    // arena memory is released with the arena
+    if (!m_arena || !m_arena->owns(p))
+      ::operator delete(p);
+  }
+
+  /// the arena allocated from, nullptr for the heap
+  const std::shared_ptr<Arena> & arena() const noexcept { return m_arena; }
+
+private:
+  std::shared_ptr<Arena> m_arena;
+};
+
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T> & a, const ArenaAllocator<U> & b) noexcept {
+  return a.arena() == b.arena();
+}
+
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T> & a, const ArenaAllocator<U> & b) noexcept {
+  return !(a == b);
+}
+
+#endif
@@ -0,0 +1,106 @@
+#include "catch.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+
+#include "arena.hpp"
+#include "environment.hpp"
+#include "expression.hpp"
+#include "interpreter.hpp"
+
+TEST_CASE( "Test arena allocation", "[arena]" ) {
+
+  Arena arena;
+  void * a = arena.allocate(24);
+  void * b = arena.allocate(100000);
+
+  REQUIRE(a != b);
+  REQUIRE(arena.owns(a));
+  REQUIRE(arena.owns(b));
+  REQUIRE(arena.bytesAllocated() >= 100024);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(a) % alignof(std::max_align_t) == 0);
+
+  int local;
+  REQUIRE(!arena.owns(&local));
+}
+
+TEST_CASE( "Test arena scope", "[arena]" ) {
+
+  REQUIRE(Arena::current() == nullptr);
+
+  auto outer = std::make_shared<Arena>();
+  {
+    ArenaScope scope(outer);
+    REQUIRE(Arena::current() == outer);
+    {
+      ArenaScope heap(nullptr);
+      REQUIRE(Arena::current() == nullptr);
+    }
+    REQUIRE(Arena::current() == outer);
+
+    ArenaAllocator<int> alloc;
+    int * p = alloc.allocate(4);
+    REQUIRE(outer->owns(p));
+    alloc.deallocate(p, 4);
+  }
+  REQUIRE(Arena::current() == nullptr);
+
+  INFO("an allocator whose arena is no longer current uses the heap");
+  ArenaAllocator<int> stale(outer);
+  int * q = stale.allocate(4);
+  REQUIRE(!outer->owns(q));
+  stale.deallocate(q, 4);
+}
+
+TEST_CASE( "Test expressions in an arena", "[arena]" ) {
+
+  std::weak_ptr<Arena> watch;
+  Expression kept, copied;
+  {
+    auto arena = std::make_shared<Arena>();
+    watch = arena;
+    ArenaScope scope(arena);
+
+    Expression exp(Atom("list"));
+    exp.append(Atom(1.0));
+    exp.append(Atom(2.0));
+    exp.setProperty("note", Expression(Atom(3.0)));
+
+    kept = exp;
+    copied = exp.heapCopy();
+  }
+
+  INFO("an expression keeps its arena alive");
+  REQUIRE(!watch.expired());
+  REQUIRE(kept == copied);
+  REQUIRE(copied.get_property("note").second == Expression(3.0));
+
+  INFO("the heap copy does not");
+  kept = Expression();
+  REQUIRE(watch.expired());
+  REQUIRE(copied.listLength() == 2);
+}
+
+TEST_CASE( "Test top-level definitions leave the arena", "[arena]" ) {
+
+  Interpreter interp;
+  std::istringstream iss("(begin (define l (list 1 (list 2 3))) (define f (lambda (x) (+ x 1))) (f 1))");
+  REQUIRE(interp.parseStream(iss));
+  REQUIRE(interp.evaluate() == Expression(2.));
+
+  Environment env;
+  std::weak_ptr<Arena> watch;
+  {
+    auto arena = std::make_shared<Arena>();
+    watch = arena;
+    ArenaScope scope(arena);
+
+    Expression l(Atom("list"));
+    l.append(Atom(1.0));
+    env.add_exp(Atom("l"), l);
+  }
+  REQUIRE(watch.expired());
+  REQUIRE(env.get_exp(Atom("l")).listLength() == 1);
+}
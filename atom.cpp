@@ -1,204 +1,347 @@
 #include "atom.hpp"
 
 #include <sstream>
+#include <atomic>
 #include <cctype>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <limits>
+#include <locale>
+#include <utility>
 
-Atom::Atom(): m_type(NoneKind) {}
+// the asSymbol/asStringLiteral result for Atoms of other types
+static const std::string EMPTY_STRING;
 
-Atom::Atom(double value){
+struct Atom::StringData {
+  std::atomic<std::size_t> refs;
+  const std::string text;
 
-  setNumber(value);
-}
+  explicit StringData(const std::string & value): refs(1), text(value) {}
+};
 
-Atom::Atom(std::complex<double> value) {
+// how much of a token scanNumber read as a number
+enum NumberScan {
+  NotNumber,    // no number at the start of the token
+  NumberPrefix, // a number followed by other characters
+  WholeNumber   // a number and nothing else
+};
 
-	setComplexNumber(value);
+// the white space skipped before a number, as in the "C" locale
+static bool isNumberSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
 }
 
-Atom::Atom(const Token & token): Atom(){
-  
-  // is token a number?
-  double temp;
-  std::istringstream iss(token.asString());
-  if(iss >> temp){
-    // check for trailing characters if >> succeeds
-    if(iss.rdbuf()->in_avail() == 0){
-      setNumber(temp);
+static bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+/* Read a decimal floating point number at the start of text, accepting
+   exactly what std::istream >> double accepts: leading white space, an
+   optional sign, digits with an optional decimal point, and an optional
+   exponent. No hexadecimal, inf or nan; a value too large for a double is
+   no number at all.
+
+   Numbers with at most 19 significant digits whose value and power of ten
+   are both exact in a double (most data) are converted with a single
+   correctly rounded multiplication or division. Others go through a stream
+   in the classic locale. Neither depends on the global locale. */
+static NumberScan scanNumber(StringSpan text, double & value) {
+
+  static const double POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  const char * p = text.begin();
+  const char * end = text.end();
+
+  while (p != end && isNumberSpace(*p))
+    ++p;
+  const char * start = p;
+
+  bool negative = false;
+  if (p != end && (*p == '+' || *p == '-')) {
+    negative = (*p == '-');
+    ++p;
+  }
+
+  // mantissa digits, accumulated while they fit
+  std::uint64_t mantissa = 0;
+  int digits = 0;         // significant digits in mantissa
+  int exponent = 0;       // decimal exponent of mantissa
+  bool anyDigit = false;
+  bool exact = true;      // mantissa holds every significant digit
+
+  for (bool point = false; p != end; ++p) {
+    if (isDigit(*p)) {
+      anyDigit = true;
+      if (mantissa == 0 && *p == '0') {
+        // leading zero
+      }
+      else if (digits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        ++digits;
+      }
+      else {
+        exact = false;
+      }
+      if (point)
+        --exponent;
+    }
+    else if (*p == '.' && !point) {
+      point = true;
+    }
+    else {
+      break;
     }
   }
-  else{ // else assume symbol
-    // make sure does not start with number
-    if(!std::isdigit(token.asString()[0])){
-      setSymbol(token.asString());
+  if (!anyDigit)
+    return NotNumber;
+
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool negativeExponent = false;
+    if (p != end && (*p == '+' || *p == '-')) {
+      negativeExponent = (*p == '-');
+      ++p;
     }
+    if (p == end || !isDigit(*p))
+      return NotNumber;
+
+    int e = 0;
+    for (; p != end && isDigit(*p); ++p) {
+      if (e < 100000)
+        e = e * 10 + (*p - '0');
+    }
+    exponent += negativeExponent ? -e : e;
   }
+
+  NumberScan scan = (p == end) ? WholeNumber : NumberPrefix;
+
+  if (exact && mantissa <= (std::uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+    value = static_cast<double>(mantissa);
+    value = (exponent < 0) ? value / POWERS_OF_TEN[-exponent] : value * POWERS_OF_TEN[exponent];
+    if (negative)
+      value = -value;
+    return scan;
+  }
+
+  std::istringstream iss(std::string(start, p));
+  iss.imbue(std::locale::classic());
+  if (!(iss >> value))
+    return NotNumber;
+  return scan;
 }
 
+Atom::Atom(): m_bits(BOXED | NoneKind), numberValue(0) {}
+
+Atom::Atom(double value): Atom(){
+
+  setNumber(value);
+}
+
+Atom::Atom(std::complex<double> value): Atom() {
+
+	setComplexNumber(value);
+}
+
+Atom::Atom(const Token & token): Atom(fromText(token.asString())){}
+
 Atom::Atom(const std::string & value): Atom() {
   
   setSymbol(value);
 }
 
-Atom::Atom(const Atom & x): Atom(){
-  if(x.isNumber()){
-    setNumber(x.numberValue);
-  }
-  else if(x.isSymbol()){
-    setSymbol(x.stringValue);
-  }
-  else if (x.isStringLiteral()) {
-	  setString(x.stringValue);
-  }
-  else if (x.isComplexNumber()) {
-	  setComplexNumber(x.complexValue);
-  }
+Atom Atom::fromSymbolId(SymbolId id) {
 
+  Atom result;
+  result.setSymbolId(id);
+  return result;
 }
 
-Atom & Atom::operator=(const Atom & x){
-
-  if(this != &x){
-	  if (x.m_type == NoneKind) {
-		  m_type = NoneKind;
-	  }
-	  else if (x.m_type == NumberKind) {
-		  setNumber(x.numberValue);
-	  }
-	  else if (x.m_type == SymbolKind) {
-		  setSymbol(x.stringValue);
-	  }
-	  else if (x.m_type == ComplexKind) {
-		  setComplexNumber(x.complexValue);
-	  }
-	  else if (x.m_type == StringKind)
-	  {
-		  m_type = StringKind;
-		  new (&stringValue) std::string(x.stringValue);
-	  }
+Atom Atom::fromText(StringSpan text) {
+
+  Atom result;
+
+  // is token a number?
+  double temp;
+  switch(scanNumber(text, temp)){
+  case WholeNumber:
+    result.setNumber(temp);
+    break;
+  case NumberPrefix:
+    // trailing characters
+    break;
+  case NotNumber:
+    // assume symbol, but make sure does not start with number
+    if(!std::isdigit(static_cast<unsigned char>(text[0]))){
+      result.setSymbol(text.str());
+    }
+    break;
   }
-  return *this;
+  return result;
+}
+
+Atom Atom::fromString(const std::string & text) {
+
+  Atom result;
+  result.setString(text);
+  return result;
 }
-  
-Atom::~Atom(){
 
-  // we need to ensure the destructor of the symbol string is called
-  if(m_type == SymbolKind || m_type == StringKind){
-    stringValue.~basic_string();
+Atom Atom::fromStringLiteral(const Token & token) {
+
+  return fromStringLiteral(StringSpan(token.asString()));
+}
+
+Atom Atom::fromStringLiteral(StringSpan text) {
+
+  // same acceptance as Atom(token)
+  double temp;
+  switch (scanNumber(text, temp)) {
+  case WholeNumber:
+    return Atom(temp);
+  case NumberPrefix:
+    return Atom();
+  case NotNumber:
+    break;
   }
+
+  Atom result;
+  if (!std::isdigit(static_cast<unsigned char>(text[0])))
+    result.setString(text.str());
+  return result;
 }
 
 bool Atom::isNone() const noexcept{
-  return m_type == NoneKind;
+  return type() == NoneKind;
 }
 
 bool Atom::isNumber() const noexcept{
-  return m_type == NumberKind;
+  return type() == NumberKind;
 }
 
 bool Atom::isComplexNumber() const noexcept {
-	return m_type == ComplexKind;
+	return type() == ComplexKind;
 }
 
 bool Atom::isSymbol() const noexcept{
-  return m_type == SymbolKind;
+  return type() == SymbolKind;
 }  
 
 bool Atom::isStringLiteral() const noexcept {
-	return m_type == StringKind;
+	return type() == StringKind;
 }
 
 
 void Atom::setNumber(double value){
 
-  m_type = NumberKind;
+  setType(NumberKind);
   numberValue = value;
 }
 
 void Atom::setComplexNumber(std::complex<double> value) {
 
-	m_type = ComplexKind;
-	complexValue = value;
+	double real = value.real();
+	std::memcpy(&m_bits, &real, sizeof(m_bits));
+
+	// a NaN real part that looks boxed becomes the default NaN
+	if ((m_bits & ~TYPE_MASK) == BOXED) {
+		real = std::numeric_limits<double>::quiet_NaN();
+		std::memcpy(&m_bits, &real, sizeof(m_bits));
+	}
+	imagValue = value.imag();
 }
 
 void Atom::setSymbol(const std::string & value){
 
-  // we need to ensure the destructor of the symbol string is called
-  if(m_type == SymbolKind){
-    stringValue.~basic_string();
-  }
-    
-  m_type = SymbolKind;
+  setSymbolId(SymbolTable::getInstance().intern(value));
+}
 
-  // copy construct in place
-  new (&stringValue) std::string(value);
+void Atom::setSymbolId(SymbolId value) {
+
+  setType(SymbolKind);
+  numberValue = 0;
+  symbolValue = value;
 }
 
 void Atom::setString(const std::string & value) {
 
-	// we need to ensure the destructor of the symbol string is called
-	if (m_type == SymbolKind) {
-		stringValue.~basic_string();
-	}
+	StringData * text = new StringData(value);
+	release();
+	setType(StringKind);
+	numberValue = 0;
+	stringValue = text;
+}
 
-	m_type = StringKind;
+void Atom::setStringLiteral() {
 
-	// copy construct in place
-	new (&stringValue) std::string(value);
+	if (type() == SymbolKind)
+		setString(SymbolTable::getInstance().name(symbolValue));
 }
 
+void Atom::retainString() const noexcept {
 
+	stringValue->refs.fetch_add(1, std::memory_order_relaxed);
+}
 
-void Atom::setStringLiteral() {
+void Atom::releaseString() noexcept {
 
-	m_type = StringKind;
+	if (stringValue->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		delete stringValue;
 }
 
 double Atom::asNumber() const noexcept{
 
-  return (m_type == NumberKind) ? numberValue : 0.0;  
+  return (type() == NumberKind) ? numberValue : 0.0;  
 }
 
 std::complex<double> Atom::asComplexNumber() const noexcept {
 
-	return (m_type == ComplexKind) ? complexValue : 0.0;
-}
+	if (type() != ComplexKind)
+		return 0.0;
 
-std::string Atom::asSymbol() const noexcept{
+	double real;
+	std::memcpy(&real, &m_bits, sizeof(real));
+	return std::complex<double>(real, imagValue);
+}
 
-  std::string result;
+const std::string & Atom::asSymbol() const noexcept{
 
-  if(m_type == SymbolKind){
-    result = stringValue;
+  if(type() == SymbolKind){
+    return SymbolTable::getInstance().name(symbolValue);
   }
 
-  return result;
+  return EMPTY_STRING;
 }
 
-std::string Atom::asStringLiteral() const noexcept {
+SymbolId Atom::symbolId() const noexcept {
+
+  return (type() == SymbolKind) ? symbolValue : Symbols::None;
+}
 
-	std::string result;
+const std::string & Atom::asStringLiteral() const noexcept {
 
-	if (m_type == StringKind)
-		result = stringValue;
+	if (type() == StringKind)
+		return stringValue->text;
 
-	return result;
+	return EMPTY_STRING;
 }
 
 bool Atom::operator==(const Atom & right) const noexcept{
   
-  if(m_type != right.m_type) return false;
+  const Type kind = type();
+  if(kind != right.type()) return false;
 
-  switch(m_type){
+  switch(kind){
   case NoneKind:
-    if(right.m_type != NoneKind) return false;
     break;
   case NumberKind:
     {
-      if(right.m_type != NumberKind) return false;
       double dleft = numberValue;
       double dright = right.numberValue;
+      if(dleft == dright) return true;
       double diff = fabs(dleft - dright);
       if(std::isnan(diff) ||
 	 (diff > std::numeric_limits<double>::epsilon())) return false;
@@ -206,21 +349,18 @@ bool Atom::operator==(const Atom & right) const noexcept{
     break;
   case ComplexKind:
   {
-	  if (right.m_type != ComplexKind) return false;
-	  std::complex<double> cdleft = complexValue;
-	  std::complex<double> cdright = right.complexValue;
+	  std::complex<double> cdleft = asComplexNumber();
+	  std::complex<double> cdright = right.asComplexNumber();
 	  double cdiff = abs(cdleft - cdright);
 	  if (std::isnan(cdiff) || (cdiff > std::numeric_limits<double>::epsilon()))
 		return false;
   }
   break;
   case SymbolKind:
-    {
-      if(right.m_type != SymbolKind) return false;
-
-      return stringValue == right.stringValue;
-    }
-    break;
+    // interned, equal names have equal ids
+    return symbolValue == right.symbolValue;
+  case StringKind:
+    return stringValue == right.stringValue || stringValue->text == right.stringValue->text;
   default:
     return false;
   }
@@ -5,12 +5,20 @@ Defines the Atom type and associated functions.
 #define ATOM_HPP
 
 #include "token.hpp"
+#include "symbol.hpp"
 #include <complex>
+#include <cstdint>
+#include <cstring>
+#include <string>
 
 /*! \class Atom
 \brief A variant type that may be a Number or Symbol or the default type None.
 
-This class provides value semantics.
+This class provides value semantics. Symbols are stored by their interned
+SymbolId, see symbol.hpp. String Literals share their text between copies,
+counting references to it, and free it with the last one; they are not
+interned, as a program may make any number of them. An Atom is 16 bytes
+whatever its type.
 */
 class Atom {
 public:
@@ -30,14 +38,63 @@ public:
   /// Construct an Atom directly from a Token
   Atom(const Token & token);
 
+  /// Construct an Atom of type Symbol from an already interned id
+  static Atom fromSymbolId(SymbolId id);
+
+  /*! Construct an Atom of type String Literal from the Token between two
+    quotes. Tokens that would not make a valid Atom outside of quotes are
+    rejected the same way (None), numbers stay numbers.
+  */
+  static Atom fromStringLiteral(const Token & token);
+
+  /// Construct an Atom from the text of a token, as Atom(token) does
+  static Atom fromText(StringSpan text);
+
+  /// Construct a String Literal Atom from the text of a token, as
+  /// fromStringLiteral(token) does
+  static Atom fromStringLiteral(StringSpan text);
+
+  /// Construct an Atom of type String Literal holding text as it is
+  static Atom fromString(const std::string & text);
+
   /// Copy-construct an Atom
-  Atom(const Atom & x);
+  Atom(const Atom & x) noexcept: m_bits(x.m_bits) {
+    copyValue(x);
+    retain();
+  }
 
-  /// Assign an Atom
-  Atom & operator=(const Atom & x);
+  /// Move-construct an Atom, leaving x None
+  Atom(Atom && x) noexcept: m_bits(x.m_bits) {
+    copyValue(x);
+    x.forget();
+  }
 
-  /// Atom destructor
-  ~Atom();
+  /// Assign an Atom
+  Atom & operator=(const Atom & x) noexcept {
+    if (this != &x) {
+      x.retain();
+      release();
+      m_bits = x.m_bits;
+      copyValue(x);
+    }
+    return *this;
+  }
+
+  /// Move-assign an Atom, leaving x None
+  Atom & operator=(Atom && x) noexcept {
+    if (this != &x) {
+      release();
+      m_bits = x.m_bits;
+      copyValue(x);
+      x.forget();
+    }
+    return *this;
+  }
+
+  /// Destroy an Atom, freeing the text of the last copy of a String Literal
+  ~Atom() {
+    release();
+  }
 
   /// predicate to determine if an Atom is of type None
   bool isNone() const noexcept;
@@ -61,32 +118,76 @@ public:
   std::complex<double> asComplexNumber() const noexcept;
 
   /// value of Atom as a number, returns empty-string if not a Symbol
-  std::string asSymbol() const noexcept;
+  const std::string & asSymbol() const noexcept;
+
+  /// interned id of the Symbol, returns Symbols::None if not a Symbol
+  SymbolId symbolId() const noexcept;
 
   /// value of Atom as a number, returns empty-string if not a String Literal
-  std::string asStringLiteral() const noexcept;
+  const std::string & asStringLiteral() const noexcept;
 
   /// equality comparison based on type and value
   bool operator==(const Atom & right) const noexcept;
 
+  /// turn a Symbol into a String Literal of the same name
   void setStringLiteral();
 
 private:
 
+  // the text of a String Literal and the number of Atoms sharing it
+  struct StringData;
+
   // internal enum of known types
   enum Type {NoneKind, NumberKind, SymbolKind, ComplexKind, StringKind};
 
-  // track the type
-  Type m_type;
+  // A complex number keeps the bits of its real part in m_bits and its
+  // imaginary part in the union. The other types are boxed: m_bits holds
+  // BOXED, a NaN that arithmetic never produces, with the Type in its low
+  // bits, and the value is in the union.
+  static const std::uint64_t BOXED = 0x7ff4a7a700000000u;
+  static const std::uint64_t TYPE_MASK = 7;
+
+  std::uint64_t m_bits;
 
-  // values for the known types. Note the use of a union requires care
-  // when setting non POD values (see setSymbol)
   union {
     double numberValue;
-    std::string stringValue;
-	std::complex<double> complexValue;
+    SymbolId symbolValue;
+    double imagValue;
+    StringData * stringValue;
   };
 
+  // the type of the value
+  Type type() const noexcept {
+    return (m_bits & ~TYPE_MASK) == BOXED ? static_cast<Type>(m_bits & TYPE_MASK) : ComplexKind;
+  }
+
+  // helper to box a value of type
+  void setType(Type type) noexcept { m_bits = BOXED | type; }
+
+  // helper to become None, leaving the current value to another Atom
+  void forget() noexcept {
+    setType(NoneKind);
+    numberValue = 0;
+  }
+
+  // helper to copy the value of x, whatever its type
+  void copyValue(const Atom & x) noexcept {
+    std::memcpy(&numberValue, &x.numberValue, sizeof(numberValue));
+  }
+
+  // helpers to count a reference to the text of a String Literal, and to
+  // drop one, freeing the text with the last
+  void retain() const noexcept {
+    if (type() == StringKind)
+      retainString();
+  }
+  void release() noexcept {
+    if (type() == StringKind)
+      releaseString();
+  }
+  void retainString() const noexcept;
+  void releaseString() noexcept;
+
   // helper to set type and value of Number
   void setNumber(double value);
 
@@ -96,6 +197,9 @@ private:
   // helper to set type and value of Symbol
   void setSymbol(const std::string & value);
 
+  // helper to set type and value of an interned Symbol
+  void setSymbolId(SymbolId value);
+
   // helper to set type and value of string
   void setString(const std::string & value);
 };
@@ -1,5 +1,11 @@
 #include "catch.hpp"
 
+#include <cmath>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "atom.hpp"
 
 TEST_CASE( "Test constructors", "[atom]" ) {
@@ -412,3 +418,162 @@ TEST_CASE( "test comparison", "[atom]" ) {
 
 
 
+
+TEST_CASE( "Test interned symbols", "[atom]" ) {
+
+  Atom a("hi");
+  Atom b("hi");
+  Atom c("bye");
+
+  REQUIRE(a.symbolId() == b.symbolId());
+  REQUIRE(a.symbolId() != c.symbolId());
+  REQUIRE(Atom(1.0).symbolId() == Symbols::None);
+
+  REQUIRE(Atom::fromSymbolId(a.symbolId()) == a);
+  REQUIRE(Atom::fromSymbolId(Symbols::List).asSymbol() == "list");
+  REQUIRE(Atom("lambda").symbolId() == Symbols::Lambda);
+
+  Atom d("foo");
+  d.setStringLiteral();
+  REQUIRE(d.isStringLiteral());
+  REQUIRE(d.asSymbol() == "");
+  REQUIRE(d.symbolId() == Symbols::None);
+}
+
+TEST_CASE( "Test move atom", "[atom]" ) {
+
+  Atom a("text");
+  a.setStringLiteral();
+
+  Atom b(std::move(a));
+  REQUIRE(b.isStringLiteral());
+  REQUIRE(b.asStringLiteral() == "text");
+  REQUIRE(a.isNone());
+
+  Atom c(1.0);
+  c = std::move(b);
+  REQUIRE(c.isStringLiteral());
+  REQUIRE(c.asStringLiteral() == "text");
+  REQUIRE(b.isNone());
+
+  Atom d("sym");
+  c = std::move(d);
+  REQUIRE(c.isSymbol());
+  REQUIRE(c.asSymbol() == "sym");
+}
+
+TEST_CASE( "Test number tokens", "[atom]" ) {
+
+  {
+    INFO("Accepted forms");
+    REQUIRE(Atom(Token("42")).asNumber() == 42);
+    REQUIRE(Atom(Token("-0.125")).asNumber() == -0.125);
+    REQUIRE(Atom(Token("+1e+0")).asNumber() == 1);
+    REQUIRE(Atom(Token(".5")).asNumber() == 0.5);
+    REQUIRE(Atom(Token("5.")).asNumber() == 5);
+    REQUIRE(Atom(Token("1.5E-3")).asNumber() == 1.5e-3);
+    REQUIRE(Atom(Token("0.1")).asNumber() == 0.1);
+    REQUIRE(Atom(Token("3.141592653589793238462643")).asNumber() == 3.141592653589793);
+    REQUIRE(Atom(Token("1e-400")).asNumber() == 0);
+  }
+
+  {
+    INFO("Numbers with trailing characters are rejected");
+    REQUIRE(Atom(Token("1abc")).isNone());
+    REQUIRE(Atom(Token("-1abc")).isNone());
+    REQUIRE(Atom(Token("1.2.3")).isNone());
+    REQUIRE(Atom(Token("0x10")).isNone());
+    REQUIRE(Atom(Token("1e")).isNone());
+    REQUIRE(Atom(Token("1e400")).isNone());
+  }
+
+  {
+    INFO("Anything else not starting with a digit is a symbol");
+    REQUIRE(Atom(Token("+")).asSymbol() == "+");
+    REQUIRE(Atom(Token("-")).asSymbol() == "-");
+    REQUIRE(Atom(Token("e5")).asSymbol() == "e5");
+    REQUIRE(Atom(Token("inf")).asSymbol() == "inf");
+    REQUIRE(Atom(Token("nan")).asSymbol() == "nan");
+    REQUIRE(Atom(Token("-abc")).asSymbol() == "-abc");
+  }
+
+  {
+    INFO("String literals follow the same rules");
+    REQUIRE(Atom::fromStringLiteral(Token(" 3")).asNumber() == 3);
+    REQUIRE(Atom::fromStringLiteral(Token("3 ")).isNone());
+    REQUIRE(Atom::fromStringLiteral(Token("a b")).asStringLiteral() == "a b");
+  }
+}
+
+TEST_CASE( "Test compact atoms", "[atom]" ) {
+
+  REQUIRE(sizeof(Atom) == 16);
+
+  {
+    INFO("Complex numbers keep any real part");
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double snan = std::numeric_limits<double>::signaling_NaN();
+    for (double real : {0.0, -0.0, 1e308, -1.5, nan, snan}) {
+      Atom a(std::complex<double>(real, 2.0));
+      REQUIRE(a.isComplexNumber());
+      REQUIRE(!a.isNumber());
+      REQUIRE(a.asComplexNumber().imag() == 2.0);
+      if (std::isnan(real))
+        REQUIRE(std::isnan(a.asComplexNumber().real()));
+      else
+        REQUIRE(a.asComplexNumber().real() == real);
+    }
+  }
+
+  {
+    INFO("Numbers keep any value");
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    REQUIRE(Atom(nan).isNumber());
+    REQUIRE(std::isnan(Atom(nan).asNumber()));
+    REQUIRE(Atom(-0.0).isNumber());
+    REQUIRE(Atom(std::numeric_limits<double>::infinity()).asNumber()
+      == std::numeric_limits<double>::infinity());
+  }
+
+  {
+    INFO("String literals hold their text apart from symbols");
+    Atom a = Atom::fromStringLiteral(Token("shared"));
+    Atom b("shared");
+    REQUIRE(a != b);
+    b.setStringLiteral();
+    REQUIRE(a == b);
+    REQUIRE(a != Atom::fromStringLiteral(Token("other")));
+  }
+}
+
+TEST_CASE( "Test string literals are not interned", "[atom]" ) {
+
+  SymbolTable & symbols = SymbolTable::getInstance();
+  const std::size_t interned = symbols.size();
+
+  {
+    INFO("Making and copying string literals interns nothing");
+    std::vector<Atom> texts;
+    for (int i = 0; i < 1000; ++i)
+      texts.push_back(Atom::fromString("label " + std::to_string(i)));
+    REQUIRE(symbols.size() == interned);
+
+    REQUIRE(Atom::fromString("3").isStringLiteral());
+    REQUIRE(Atom::fromString("label 7") == texts[7]);
+  }
+
+  {
+    INFO("Copies share the text until the last one goes");
+    Atom a = Atom::fromString("text");
+    Atom b = a;
+    REQUIRE(&a.asStringLiteral() == &b.asStringLiteral());
+    a = Atom(1.0);
+    REQUIRE(b.asStringLiteral() == "text");
+    Atom c(std::move(b));
+    REQUIRE(b.isNone());
+    REQUIRE(c.asStringLiteral() == "text");
+    const Atom & same = c;
+    c = same;
+    REQUIRE(c.asStringLiteral() == "text");
+  }
+}
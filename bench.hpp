@@ -0,0 +1,89 @@
+/*! \file bench.hpp
+Defines a minimal timing harness for the benchmarks executable.
+
+Each benchmark case registers itself with BENCHMARK_CASE and reports one or
+more measurements through the Bench object it is handed. Run the benchmarks
+executable with an optional substring argument to select cases by name.
+ */
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*! \class Bench
+\brief Collects and prints the timing measurements of one benchmark case.
+ */
+class Bench {
+public:
+
+  /// Construct a Bench reporting under the given case name
+  explicit Bench(const std::string & name);
+
+  /*! Time a callable over a number of iterations and print the mean time
+    per iteration.
+    \param label describes the measurement within the case
+    \param iterations the number of times to call body
+    \param body the callable to measure
+    \return the mean time per iteration in nanoseconds
+   */
+  template<typename Body>
+  double run(const std::string & label, std::size_t iterations, Body body);
+
+  /// print a derived figure (a ratio, a throughput, ...) for the case
+  void report(const std::string & label, double value, const std::string & unit);
+
+private:
+  std::string m_name;
+};
+
+/// keep the compiler from discarding a computed value
+template<typename T>
+void doNotOptimize(const T & value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "g"(&value) : "memory");
+#else
+  static const void * volatile sink;
+  sink = &value;
+#endif
+}
+
+/*! \typedef BenchmarkFunction
+\brief A benchmark case is a function handed its Bench.
+*/
+typedef void (*BenchmarkFunction)(Bench & bench);
+
+/*! \class BenchRegistrar
+\brief Registers a benchmark case at static initialization time.
+ */
+class BenchRegistrar {
+public:
+  BenchRegistrar(const char * name, BenchmarkFunction function);
+};
+
+/// the registered (name, function) pairs in registration order
+std::vector<std::pair<std::string, BenchmarkFunction> > & benchmarkRegistry();
+
+/// define and register a benchmark case
+#define BENCHMARK_CASE(name) \
+  static void name(Bench & bench); \
+  static BenchRegistrar name##_registrar(#name, name); \
+  static void name(Bench & bench)
+
+template<typename Body>
+double Bench::run(const std::string & label, std::size_t iterations, Body body) {
+
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < iterations; ++i)
+    body();
+  auto stop = std::chrono::steady_clock::now();
+
+  double total = std::chrono::duration<double, std::nano>(stop - start).count();
+  double mean = total / (iterations ? iterations : 1);
+  report(label, mean, "ns/iter");
+  return mean;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+Bench::Bench(const std::string & name): m_name(name) {}
+
+void Bench::report(const std::string & label, double value, const std::string & unit) {
+
+  std::cout << std::left << std::setw(28) << m_name
+            << std::setw(44) << label
+            << std::right << std::setw(16) << std::fixed << std::setprecision(1) << value
+            << " " << unit << std::endl;
+}
+
+std::vector<std::pair<std::string, BenchmarkFunction> > & benchmarkRegistry() {
+  static std::vector<std::pair<std::string, BenchmarkFunction> > registry;
+  return registry;
+}
+
+BenchRegistrar::BenchRegistrar(const char * name, BenchmarkFunction function) {
+  benchmarkRegistry().emplace_back(name, function);
+}
+
+int main(int argc, char *argv[]) {
+
+  std::string filter = (argc > 1) ? argv[1] : "";
+
+  for (auto & entry : benchmarkRegistry()) {
+    if (entry.first.find(filter) == std::string::npos)
+      continue;
+
+    Bench bench(entry.first);
+    entry.second(bench);
+  }
+
+  return EXIT_SUCCESS;
+}
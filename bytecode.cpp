@@ -0,0 +1,239 @@
+#include "bytecode.hpp"
+
+namespace {
+
+// how a node of the tree is lowered
+enum NodeKind {
+  LiteralNode,  // number, complex or string leaf
+  NameNode,     // symbol leaf
+  BeginNode,    // begin special-form
+  DefineNode,   // well formed define special-form
+  ProcCallNode, // call of a built-in procedure
+  NameCallNode, // call through a symbol that is not a built-in procedure
+  TreeNode      // anything left to the tree walker
+};
+
+// a define the tree walker would accept before evaluating its value
+bool validDefine(const Expression & exp, const Environment & env) {
+
+  if (exp.listLength() != 2)
+    return false;
+
+  const Atom & target = exp.tailConstBegin()->head();
+  SymbolId id = target.symbolId();
+  return target.isSymbol() && (id != Symbols::Define) && (id != Symbols::Begin)
+    && !env.is_proc(target);
+}
+
+// mirror the dispatch of Expression::eval
+NodeKind classify(const Expression & exp, const Environment & env) {
+
+  const Atom & head = exp.head();
+
+  if (exp.isListEmpty() && head.symbolId() != Symbols::List) {
+    if (head.isSymbol())
+      return NameNode;
+    if (head.isNumber() || head.isComplexNumber() || head.isStringLiteral())
+      return LiteralNode;
+    return TreeNode;
+  }
+
+  switch (head.symbolId()) {
+  case Symbols::Begin:
+    return BeginNode;
+  case Symbols::Define:
+    return validDefine(exp, env) ? DefineNode : TreeNode;
+  case Symbols::Lambda:
+  case Symbols::Apply:
+  case Symbols::Map:
+  case Symbols::ParallelMap:
+  case Symbols::SetProperty:
+  case Symbols::GetProperty:
+  case Symbols::DiscretePlot:
+  case Symbols::ContinuousPlot:
+    return TreeNode;
+  default:
+    break;
+  }
+
+  if (env.is_proc(head))
+    return ProcCallNode;
+  if (head.isSymbol())
+    return NameCallNode;
+  return TreeNode;
+}
+
+/* Lowers an expression tree into the code of one Function. Inside a lambda
+   body, names with a local slot are accessed by index; every other name is
+   looked up by symbol at run-time. */
+class Compiler {
+public:
+
+  Compiler(const Environment & env, Function & fn): m_env(env), m_fn(fn) {}
+
+  // true if some node of exp must be left to the tree walker
+  bool needsTree(const Expression & exp) const {
+
+    switch (classify(exp, m_env)) {
+    case LiteralNode:
+    case NameNode:
+      return false;
+    case DefineNode:
+      return needsTree(*(exp.tailConstBegin() + 1));
+    case BeginNode:
+    case ProcCallNode:
+    case NameCallNode:
+      for (auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e) {
+        if (needsTree(*e))
+          return true;
+      }
+      return false;
+    default:
+      return true;
+    }
+  }
+
+  // add a local slot for every symbol defined in exp
+  void collectDefines(const Expression & exp) {
+
+    NodeKind kind = classify(exp, m_env);
+    if (kind == DefineNode) {
+      SymbolId id = exp.tailConstBegin()->head().symbolId();
+      if (slotOf(id) < 0)
+        m_fn.slotNames.push_back(id);
+    }
+
+    if (kind != LiteralNode && kind != NameNode && kind != TreeNode) {
+      for (auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e)
+        collectDefines(*e);
+    }
+  }
+
+  // emit code leaving the value of exp on the stack
+  void compile(const Expression & exp) {
+
+    switch (classify(exp, m_env)) {
+    case LiteralNode:
+      // a literal evaluates to its head alone, without properties
+      emit(PUSH_CONST, addConstant(Expression(exp.head())));
+      break;
+    case NameNode:
+      emitAccess(LOAD_LOCAL, LOAD_NAME, exp.head().symbolId());
+      break;
+    case BeginNode:
+      for (auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e) {
+        if (e != exp.tailConstBegin())
+          emit(POP);
+        compile(*e);
+      }
+      break;
+    case DefineNode:
+      compile(*(exp.tailConstBegin() + 1));
+      emitAccess(DEFINE_LOCAL, DEFINE_NAME, exp.tailConstBegin()->head().symbolId());
+      break;
+    case ProcCallNode:
+      for (auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e)
+        compile(*e);
+      emit(CALL_PROC, addProcedure(m_env.get_proc(exp.head())), exp.listLength());
+      break;
+    case NameCallNode:
+      // the callee is resolved before the arguments, as in Expression::eval
+      emit(PREPARE_CALL, exp.head().symbolId(), exp.listLength());
+      for (auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e)
+        compile(*e);
+      emit(CALL, 0, exp.listLength());
+      break;
+    case TreeNode:
+      emit(EVAL_TREE, addConstant(exp));
+      break;
+    }
+  }
+
+  void emit(OpCode op, std::uint32_t a = 0, std::uint32_t b = 0) {
+    m_fn.code.push_back(Instruction{op, a, b});
+  }
+
+private:
+
+  const Environment & m_env;
+  Function & m_fn;
+
+  // the last slot named id (a repeated parameter binds the last), or -1
+  int slotOf(SymbolId id) const {
+    for (std::size_t i = m_fn.slotNames.size(); i > 0; --i) {
+      if (m_fn.slotNames[i - 1] == id)
+        return static_cast<int>(i - 1);
+    }
+    return -1;
+  }
+
+  void emitAccess(OpCode local, OpCode global, SymbolId id) {
+    int slot = slotOf(id);
+    if (slot >= 0)
+      emit(local, slot);
+    else
+      emit(global, id);
+  }
+
+  std::uint32_t addConstant(const Expression & exp) {
+    m_fn.constants.push_back(exp);
+    return m_fn.constants.size() - 1;
+  }
+
+  std::uint32_t addProcedure(Procedure proc) {
+    for (std::size_t i = 0; i < m_fn.procedures.size(); ++i) {
+      if (m_fn.procedures[i] == proc)
+        return i;
+    }
+    m_fn.procedures.push_back(proc);
+    return m_fn.procedures.size() - 1;
+  }
+};
+
+} // namespace
+
+std::shared_ptr<Function> compileProgram(const Expression & program, const Environment & env) {
+
+  std::shared_ptr<Function> fn = std::make_shared<Function>();
+  fn->body = program;
+
+  Compiler compiler(env, *fn);
+  compiler.compile(program);
+  compiler.emit(RETURN);
+
+  return fn;
+}
+
+std::shared_ptr<Function> compileLambda(const Expression & lambda, const Environment & env) {
+
+  std::shared_ptr<Function> fn = std::make_shared<Function>();
+
+  // a lambda value is (lambda (list params...) body)
+  if (lambda.listLength() != 2) {
+    fn->treeOnly = true;
+    return fn;
+  }
+
+  const Expression & paramList = *lambda.tailConstBegin();
+  fn->body = *(lambda.tailConstBegin() + 1);
+
+  bool symbolParams = true;
+  for (auto p = paramList.tailConstBegin(); p != paramList.tailConstEnd(); ++p) {
+    fn->params.push_back(p->head());
+    fn->slotNames.push_back(p->head().symbolId());
+    symbolParams = symbolParams && p->head().isSymbol();
+  }
+
+  Compiler compiler(env, *fn);
+  if (!symbolParams || compiler.needsTree(fn->body)) {
+    fn->treeOnly = true;
+    fn->slotNames.clear();
+    return fn;
+  }
+
+  compiler.collectDefines(fn->body);
+  compiler.compile(fn->body);
+  compiler.emit(RETURN);
+
+  return fn;
+}
@@ -0,0 +1,101 @@
+/*! \file bytecode.hpp
+Defines the bytecode a parsed Expression can be compiled to, and the
+functions that compile it.
+
+The instruction set targets the stack machine in vm.hpp. Only the core of
+the language is lowered: literals, symbol lookup, begin, define, calls of
+built-in procedures (resolved at compile time) and calls of user lambdas
+(with their parameters in numbered local slots). Every other special form
+is kept as an Expression constant and handed to the tree-walking evaluator,
+which remains the reference semantics.
+ */
+#ifndef BYTECODE_HPP
+#define BYTECODE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "atom.hpp"
+#include "environment.hpp"
+#include "expression.hpp"
+
+/*! \enum OpCode
+\brief The operations of the stack machine. a and b refer to the operands
+       of the Instruction.
+*/
+enum OpCode {
+  PUSH_CONST,   //< push constants[a]
+  LOAD_NAME,    //< push the value bound to symbol a
+  LOAD_LOCAL,   //< push local slot a, or the binding of its name if unset
+  DEFINE_NAME,  //< bind symbol a to the top of stack in the environment
+  DEFINE_LOCAL, //< bind local slot a to the top of stack
+  POP,          //< discard the top of stack
+  CALL_PROC,    //< replace the top b values by procedures[a] applied to them
+  PREPARE_CALL, //< resolve symbol a as the callee of a call with b arguments
+  CALL,         //< replace the top b values by the prepared callee applied to them
+  EVAL_TREE,    //< push the tree-walking evaluation of constants[a]
+  RETURN        //< return the top of stack to the caller
+};
+
+/*! \struct Instruction
+\brief One operation of the stack machine with its operands.
+*/
+struct Instruction {
+  OpCode op;
+  std::uint32_t a;
+  std::uint32_t b;
+};
+
+/*! \struct Function
+\brief A compiled unit of code: a top-level program or a lambda body.
+
+A lambda whose body needs the tree walker (it contains special forms other
+than begin and define) is marked treeOnly; its code is empty and calls to
+it evaluate body in a frame binding params.
+*/
+struct Function {
+
+  /// the instructions, ending in RETURN
+  std::vector<Instruction> code;
+
+  /// literal values and tree-walked subexpressions
+  std::vector<Expression> constants;
+
+  /// the built-in procedures called by the code
+  std::vector<Procedure> procedures;
+
+  /// the symbol named by each local slot, parameters first
+  std::vector<SymbolId> slotNames;
+
+  /// the parameter atoms of a lambda
+  std::vector<Atom> params;
+
+  /// the lambda body, used when treeOnly
+  Expression body;
+
+  /// true if calls must be evaluated by the tree walker
+  bool treeOnly = false;
+};
+
+/*! \fn compileProgram
+\brief compile a top-level expression; symbols are bound and looked up in
+       the environment it is run in
+
+\param program the expression, as returned by parse
+\param env the environment used to resolve built-in procedures
+\returns the compiled program
+ */
+std::shared_ptr<Function> compileProgram(const Expression & program, const Environment & env);
+
+/*! \fn compileLambda
+\brief compile the body of a lambda value with its parameters and local
+       definitions in slots
+
+\param lambda the lambda value, as produced by evaluating a lambda form
+\param env the environment used to resolve built-in procedures
+\returns the compiled lambda
+ */
+std::shared_ptr<Function> compileLambda(const Expression & lambda, const Environment & env);
+
+#endif
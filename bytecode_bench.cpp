@@ -0,0 +1,35 @@
+#include "bench.hpp"
+
+#include <sstream>
+
+#include "interpreter.hpp"
+
+// nested user lambda calls: each evaluation performs 84 calls of f
+static const char * CALL_PROGRAM =
+  "(begin (define f (lambda (x) (- (* x 2) x)))"
+  " (define g (lambda (x) (f (f (f (f x))))))"
+  " (define h (lambda (x) (g (g (g (g x))))))"
+  " (h (h (h (h (h 1))))))";
+
+// the tree walker against the bytecode VM on the same program
+BENCHMARK_CASE(tree_walker_vs_bytecode) {
+
+  struct { const char * name; Interpreter::EvalMode mode; } modes[] = {
+    {"tree walker", Interpreter::TreeWalkMode},
+    {"bytecode", Interpreter::BytecodeMode}
+  };
+
+  double times[2];
+  for (int i = 0; i < 2; ++i) {
+    Interpreter interp;
+    interp.setMode(modes[i].mode);
+
+    std::istringstream iss(CALL_PROGRAM);
+    interp.parseStream(iss);
+    times[i] = bench.run(std::string("lambda calls, ") + modes[i].name, 2000, [&] {
+      doNotOptimize(interp.evaluate());
+    });
+  }
+
+  bench.report("bytecode speedup", times[0] / times[1], "x");
+}
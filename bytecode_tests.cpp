@@ -0,0 +1,116 @@
+#include "catch.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bytecode.hpp"
+#include "interpreter.hpp"
+#include "semantic_error.hpp"
+
+// evaluate each program in turn in one interpreter running both evaluators;
+// a disagreement throws std::logic_error, a shared error is a SemanticError
+static void runDifferential(const std::vector<std::string> & programs) {
+
+  Interpreter interp;
+  interp.setMode(Interpreter::DifferentialMode);
+
+  for (auto & program : programs) {
+    INFO(program);
+    std::istringstream iss(program);
+    REQUIRE(interp.parseStream(iss));
+    try {
+      interp.evaluate();
+    }
+    catch (const SemanticError &) {
+    }
+  }
+}
+
+static Expression runBytecode(const std::string & program) {
+
+  Interpreter interp;
+  interp.setMode(Interpreter::BytecodeMode);
+
+  std::istringstream iss(program);
+  REQUIRE(interp.parseStream(iss));
+  return interp.evaluate();
+}
+
+TEST_CASE("Test bytecode compilation", "[bytecode]") {
+
+  Environment env;
+
+  {
+    INFO("procedure calls resolve at compile time");
+    Expression exp(Atom("+"));
+    exp.append(Atom(1.));
+    exp.append(Atom(2.));
+
+    auto fn = compileProgram(exp, env);
+    REQUIRE(fn->code.size() == 4);
+    REQUIRE(fn->code[2].op == CALL_PROC);
+    REQUIRE(fn->code[3].op == RETURN);
+    REQUIRE(fn->procedures.size() == 1);
+  }
+
+  {
+    INFO("lambda parameters and definitions get slots");
+    Interpreter interp;
+    std::istringstream iss("(lambda (x) (begin (define y 2) (* x y)))");
+    REQUIRE(interp.parseStream(iss));
+    Expression lambda = interp.evaluate();
+
+    auto fn = compileLambda(lambda, env);
+    REQUIRE(!fn->treeOnly);
+    REQUIRE(fn->slotNames.size() == 2);
+  }
+
+  {
+    INFO("other special forms are left to the tree walker");
+    Interpreter interp;
+    std::istringstream iss("(lambda (x) (map sin x))");
+    REQUIRE(interp.parseStream(iss));
+    Expression lambda = interp.evaluate();
+
+    REQUIRE(compileLambda(lambda, env)->treeOnly);
+  }
+}
+
+TEST_CASE("Test bytecode evaluation", "[bytecode]") {
+
+  REQUIRE(runBytecode("(+ 1 (* 2 3))") == Expression(7.));
+  REQUIRE(runBytecode("(begin (define f (lambda (x) (* x x))) (f (f 3)))") == Expression(81.));
+  REQUIRE(runBytecode("(begin (define a 1) (define f (lambda (x) (+ a x))) (f 2))") == Expression(3.));
+  REQUIRE_THROWS_AS(runBytecode("(begin (define f (lambda (x) x)) (f 1 2))"), SemanticError);
+  REQUIRE_THROWS_AS(runBytecode("(begin (define a 1) (a 2))"), SemanticError);
+  REQUIRE_THROWS_AS(runBytecode("(+ b 1)"), SemanticError);
+}
+
+TEST_CASE("Test bytecode matches the tree walker", "[bytecode]") {
+
+  runDifferential({ "(1)", "(-3.5e2)", "(I)", "(\"text\")", "(list)", "(list 1 (list 2 3))",
+    "(+ 1 2 3)", "(- 4)", "(/ 1 0)", "(sqrt -4)", "(^ e (* I pi))", "(first (list))",
+    "(rest (list 1 2))", "(join (list 1) (list 2 3))", "(range 0 1 0.25)",
+    "(begin (define a 1) (define b pi) (+ a b))", "(define a 2)", "(+ a 1)",
+    "(define pi 3)", "(define + 3)", "(define begin 1)", "(define 1 2)", "(begin)" });
+
+  runDifferential({ "(define f (lambda (x) (+ 2 x)))", "(f 2)", "(f 1 2)",
+    "(define a 1)", "(define x 100)",
+    "(define g (lambda (x) (begin (define b 12) (+ a b x))))", "(g 3)", "(b)",
+    "(define h (lambda (x y) (g (+ x y))))", "(h 1 2)", "(h 1)",
+    "(define k (lambda (a) (begin (define a (* a 2)) a)))", "(k 4)", "(a)",
+    "(define d (lambda (y) (+ y z)))", "(d 1)", "(define z 5)", "(d 1)",
+    "(define caller (lambda (z) (d 1)))", "(caller 10)",
+    "(define twice (lambda (x x) x))", "(twice 1 2)", "(a 1)", "(nope 1)" });
+
+  runDifferential({ "(define linear (lambda (a b x) (+ (* a x) b)))",
+    "(apply linear (list 3 4 5))", "(map sin (list 0 pi))",
+    "(define sq (lambda (x) (* x x)))", "(map sq (list 1 2 3))",
+    "(define m (lambda (l) (map sq l)))", "(m (list 4 5))",
+    "(define p (set-property \"size\" 2 (make-point 0 0)))",
+    "(get-property \"size\" p)",
+    "(define outer (lambda (n) (begin (define w 3) (m (list n w)))))", "(outer 2)",
+    "(discrete-plot (list (list 0 0) (list 1 1)) (list))",
+    "(continuous-plot sq (list 0 1))" });
+}
@@ -0,0 +1,32 @@
+#include "bench.hpp"
+
+#include <sstream>
+#include <string>
+
+#include "interpreter.hpp"
+
+// the mean time of one evaluation of program over 100 evaluations
+static double timeProgram(Bench & bench, const std::string & label, const std::string & program) {
+
+  Interpreter interp;
+  std::istringstream iss(program);
+  interp.parseStream(iss);
+
+  return bench.run(label, 100, [&] {
+    doNotOptimize(interp.evaluate());
+  });
+}
+
+// 1M calls of a user lambda, mapped over 10k points 100 times, and the
+// extra cost over mapping a built-in procedure over the same points
+BENCHMARK_CASE(lambda_call_overhead) {
+
+  const std::string points = "(range 0 9999 1)";
+
+  double builtin = timeProgram(bench, "map built-in over 10k", "(map - " + points + ")");
+  double lambda = timeProgram(bench, "map lambda over 10k",
+    "(begin (define sq (lambda (x) (* x x))) (map sq " + points + "))");
+
+  bench.report("per lambda call", lambda / 1e4, "ns");
+  bench.report("lambda over built-in, per call", (lambda - builtin) / 1e4, "ns");
+}
@@ -0,0 +1,26 @@
+#include "closure.hpp"
+
+Closure::Closure(const Expression & lambda) {
+
+  if (lambda.listLength() != 2)
+    return;
+
+  const Expression & params = *lambda.tailConstBegin();
+  m_params.reserve(params.listLength());
+  m_ids.reserve(params.listLength());
+  for (auto p = params.tailConstBegin(); p != params.tailConstEnd(); ++p) {
+    m_params.push_back(p->head());
+    m_ids.push_back(p->head().symbolId());
+  }
+
+  m_body = *(lambda.tailConstBegin() + 1);
+}
+
+int Closure::slotOf(SymbolId id, std::size_t bound) const noexcept {
+
+  for (std::size_t i = bound; i > 0; --i) {
+    if (m_ids[i - 1] == id)
+      return static_cast<int>(i - 1);
+  }
+  return -1;
+}
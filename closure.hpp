@@ -0,0 +1,57 @@
+/*! \file closure.hpp
+Defines the callable form of a lambda value.
+ */
+#ifndef CLOSURE_HPP
+#define CLOSURE_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "atom.hpp"
+#include "expression.hpp"
+
+/*! \class Closure
+\brief A lambda value analyzed once for calling: its parameters in slot
+order and its body.
+
+Environment builds the Closure of a binding to a lambda when the binding is
+made and keeps it with the binding, so threads may share it. A call then
+binds its arguments to the slots of a frame (see Environment(const
+Environment *, const Closure &)) and evaluates the body in it.
+
+Lambdas are dynamically scoped: the frame of a call encloses the
+environment of the caller, not of the definition, so a Closure captures no
+environment.
+ */
+class Closure {
+public:
+
+  /*! Analyze a lambda value.
+    \param lambda the value of a lambda special-form, (lambda (list params...) body)
+   */
+  explicit Closure(const Expression & lambda);
+
+  /// the number of parameters, the most arguments a call may pass
+  std::size_t arity() const noexcept { return m_params.size(); }
+
+  /// the parameter bound to slot i
+  const Atom & param(std::size_t i) const { return m_params[i]; }
+
+  /// the body evaluated by a call
+  const Expression & body() const noexcept { return m_body; }
+
+  /*! Find the slot of a parameter.
+    \param id the symbol to look for
+    \param bound the number of slots bound by the call
+    \return the last of the first bound slots naming id (a repeated
+    parameter binds the last), or -1
+   */
+  int slotOf(SymbolId id, std::size_t bound) const noexcept;
+
+private:
+  std::vector<Atom> m_params;
+  std::vector<SymbolId> m_ids;
+  Expression m_body;
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include "curve_sampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+  // an interval left to test, bisected depth times from a uniform one, and
+  // how rough the curve was found about it, which orders it under a budget
+  struct Interval {
+    CurveSampler::Point a;
+    CurveSampler::Point b;
+    std::size_t depth;
+    double error;
+  };
+
+  // keep the count roughest intervals, in the order they were given
+  void keepRoughest(std::vector<Interval> & intervals, std::size_t count) {
+    if (intervals.size() <= count)
+      return;
+    std::vector<std::size_t> order(intervals.size());
+    for (std::size_t k = 0; k < order.size(); ++k)
+      order[k] = k;
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t i, std::size_t j) {
+      return intervals[i].error > intervals[j].error;
+    });
+    order.resize(count);
+    std::sort(order.begin(), order.end());
+
+    std::vector<Interval> kept;
+    kept.reserve(count);
+    for (std::size_t k : order)
+      kept.push_back(intervals[k]);
+    intervals.swap(kept);
+  }
+
+  // the bounds of the finite samples of y
+  struct Bounds {
+    double low = std::numeric_limits<double>::max();
+    double high = std::numeric_limits<double>::lowest();
+
+    void add(double y) noexcept {
+      if (std::isfinite(y)) {
+        low = std::min(low, y);
+        high = std::max(high, y);
+      }
+    }
+
+    // the plot units per unit of y, 0 when there is no range to scale
+    double scale(double size) const noexcept {
+      return high > low ? size / (high - low) : 0;
+    }
+  };
+}
+
+std::vector<CurveSampler::Point> CurveSampler::sample(double left, double right,
+  const Function & f) const {
+
+  const std::size_t n = std::max<std::size_t>(intervals, 1);
+
+  std::vector<double> xs(n + 1);
+  for (std::size_t i = 0; i <= n; ++i)
+    xs[i] = left + (right - left) * i / n;
+  xs[n] = right;
+  std::vector<double> ys = f(xs);
+
+  std::vector<Point> points;
+  Bounds bounds;
+  for (std::size_t i = 0; i <= n; ++i) {
+    points.push_back(Point{xs[i], ys[i]});
+    bounds.add(ys[i]);
+  }
+
+  const double xScale = right > left ? width / (right - left) : 0;
+
+  // nothing is known yet of how the curve bends within a uniform interval,
+  // so the longest chords are tested first
+  std::vector<Interval> pending, next;
+  for (std::size_t i = 0; i < n; ++i)
+    pending.push_back(Interval{points[i], points[i + 1], 0,
+      chordLength(points[i], points[i + 1], xScale, bounds.scale(height))});
+  std::size_t evaluations = n + 1;
+
+  // a round evaluates the midpoints of the intervals left, and leaves the
+  // halves of those that are rough for the next one; the last round the
+  // budget allows tests the halves of the roughest intervals
+  while (!pending.empty() && evaluations < maxSamples) {
+
+    keepRoughest(pending, maxSamples - evaluations);
+    xs.resize(pending.size());
+    for (std::size_t k = 0; k < pending.size(); ++k)
+      xs[k] = pending[k].a.x + (pending[k].b.x - pending[k].a.x) / 2;
+    ys = f(xs);
+    evaluations += xs.size();
+
+    for (double y : ys)
+      bounds.add(y);
+    const double yScale = bounds.scale(height);
+
+    next.clear();
+    for (std::size_t k = 0; k < pending.size(); ++k) {
+      const Interval & interval = pending[k];
+      Point m = {xs[k], ys[k]};
+      points.push_back(m);
+      if (interval.depth + 1 < maxDepth && rough(interval.a, m, interval.b, xScale, yScale)) {
+        const double error = chordError(interval.a, m, interval.b, xScale, yScale);
+        next.push_back(Interval{interval.a, m, interval.depth + 1, error});
+        next.push_back(Interval{m, interval.b, interval.depth + 1, error});
+      }
+    }
+    pending.swap(next);
+  }
+
+  std::sort(points.begin(), points.end(), [](const Point & p, const Point & q) {
+    return p.x < q.x;
+  });
+  return points;
+}
+
+bool CurveSampler::rough(const Point & a, const Point & m, const Point & b,
+  double xScale, double yScale) const noexcept {
+
+  // a value that is not a number is infinitely far from the chord, so the
+  // curve is refined towards it
+  if (chordError(a, m, b, xScale, yScale) > maxError)
+    return true;
+
+  const double toMidX = (m.x - a.x) * xScale;
+  const double toMidY = (m.y - a.y) * yScale;
+  const double fromMidX = (b.x - m.x) * xScale;
+  const double fromMidY = (b.y - m.y) * yScale;
+
+  const double degrees = 180 / std::atan2(0, -1);
+  const double bend = std::atan2(std::abs(toMidX * fromMidY - toMidY * fromMidX),
+    toMidX * fromMidX + toMidY * fromMidY) * degrees;
+  return chordLength(a, b, xScale, yScale) > 1 && bend > maxBend;
+}
+
+double CurveSampler::chordError(const Point & a, const Point & m, const Point & b,
+  double xScale, double yScale) noexcept {
+
+  if (!std::isfinite(a.y) || !std::isfinite(m.y) || !std::isfinite(b.y))
+    return std::numeric_limits<double>::infinity();
+
+  const double chordX = (b.x - a.x) * xScale;
+  const double chordY = (b.y - a.y) * yScale;
+  const double toMidX = (m.x - a.x) * xScale;
+  const double toMidY = (m.y - a.y) * yScale;
+
+  const double chord = std::hypot(chordX, chordY);
+  return chord > 0 ? std::abs(chordX * toMidY - chordY * toMidX) / chord
+    : std::hypot(toMidX, toMidY);
+}
+
+double CurveSampler::chordLength(const Point & a, const Point & b,
+  double xScale, double yScale) noexcept {
+
+  if (!std::isfinite(a.y) || !std::isfinite(b.y))
+    return std::numeric_limits<double>::infinity();
+  return std::hypot((b.x - a.x) * xScale, (b.y - a.y) * yScale);
+}
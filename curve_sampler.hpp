@@ -0,0 +1,85 @@
+/*! \file curve_sampler.hpp
+Defines the adaptive sampling of the function a continuous plot draws.
+ */
+#ifndef CURVE_SAMPLER_HPP
+#define CURVE_SAMPLER_HPP
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/*! \class CurveSampler
+\brief Chooses where to evaluate a function of x so that the polyline
+through the samples stays within a tolerance of the curve.
+
+The range is first cut into uniform intervals. Each interval is then tested
+by evaluating its midpoint: if the midpoint is further from the chord than
+maxError, or a long chord bends by more than maxBend at it, both halves are
+tested in turn, at most maxDepth times. Distances and angles are measured
+in the units of the plot, which is width by height for the range of x and
+of the samples of y.
+
+The midpoints of a whole round of bisection are evaluated in one call of
+the function, so it can evaluate them in parallel. When a round would pass
+maxSamples evaluations, only the intervals whose parent midpoint was
+furthest from its chord are tested, so the budget goes where the curve is
+roughest; past it no more intervals are tested, except for the uniform
+ones.
+ */
+class CurveSampler {
+public:
+
+  /// a sample of the function
+  struct Point {
+    double x;
+    double y;
+  };
+
+  /// the function, evaluating y at each of a batch of x, in order
+  typedef std::function<std::vector<double>(const std::vector<double> &)> Function;
+
+  /// the number of uniform intervals sampled first, and so the fewest
+  /// intervals drawn; each is then bisected as the curve needs
+  std::size_t intervals = 16;
+
+  /// the most times an interval is bisected
+  std::size_t maxDepth = 10;
+
+  /// the number of evaluations past which no more intervals are tested
+  std::size_t maxSamples = 4096;
+
+  /// the distance of a midpoint from its chord refined, in plot units
+  double maxError = 0.05;
+
+  /// the bend refined at the midpoint of a chord longer than a plot unit, in degrees
+  double maxBend = 10;
+
+  /// the size of the plot
+  double width = 20;
+  double height = 20;
+
+  /*! Sample f over [left, right].
+    \param left the lower bound of x
+    \param right the upper bound of x
+    \param f the function
+    \return the samples in increasing x, including both bounds
+   */
+  std::vector<Point> sample(double left, double right, const Function & f) const;
+
+private:
+
+  // true if the curve through a, m and b needs more samples
+  bool rough(const Point & a, const Point & m, const Point & b,
+    double xScale, double yScale) const noexcept;
+
+  // the distance of m from the chord from a to b, in plot units, infinite
+  // where the curve is not a number
+  static double chordError(const Point & a, const Point & m, const Point & b,
+    double xScale, double yScale) noexcept;
+
+  // the length of the chord from a to b, in plot units
+  static double chordLength(const Point & a, const Point & b,
+    double xScale, double yScale) noexcept;
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include "curve_sampler.hpp"
+
+// a sampled function, counting its evaluations
+struct Counted {
+  std::function<double(double)> f;
+  std::size_t evaluations;
+  std::size_t calls;
+
+  explicit Counted(std::function<double(double)> g): f(g), evaluations(0), calls(0) {}
+
+  CurveSampler::Function function() {
+    return [this](const std::vector<double> & xs) {
+      ++calls;
+      evaluations += xs.size();
+      std::vector<double> ys;
+      for (double x : xs)
+        ys.push_back(f(x));
+      return ys;
+    };
+  }
+};
+
+// the largest distance, in plot units, of f from the polyline through the
+// samples, checked at 100k points
+static double plotError(const std::vector<CurveSampler::Point> & samples,
+  const std::function<double(double)> & f) {
+
+  double low = samples.front().y, high = samples.front().y;
+  for (auto & p : samples) {
+    low = std::min(low, p.y);
+    high = std::max(high, p.y);
+  }
+  const double xScale = 20 / (samples.back().x - samples.front().x);
+  const double yScale = 20 / (high - low);
+
+  double error = 0;
+  std::size_t segment = 0;
+  const double left = samples.front().x, right = samples.back().x;
+  for (int i = 0; i <= 100000; ++i) {
+    double x = left + (right - left) * i / 100000;
+    while (segment + 2 < samples.size() && samples[segment + 1].x < x)
+      ++segment;
+    const CurveSampler::Point & a = samples[segment];
+    const CurveSampler::Point & b = samples[segment + 1];
+    double dx = (b.x - a.x) * xScale, dy = (b.y - a.y) * yScale;
+    double cross = dx * (f(x) - a.y) * yScale - dy * (x - a.x) * xScale;
+    error = std::max(error, std::abs(cross) / std::hypot(dx, dy));
+  }
+  return error;
+}
+
+TEST_CASE( "Test curve sampler refines where the curve bends", "[curve_sampler]" ) {
+
+  CurveSampler sampler;
+
+  {
+    INFO("a line is only tested at the midpoints of the uniform intervals");
+    Counted line([](double x) { return 2 * x + 1; });
+    auto samples = sampler.sample(-2, 2, line.function());
+    REQUIRE(samples.size() == 2 * sampler.intervals + 1);
+    REQUIRE(line.evaluations == samples.size());
+    REQUIRE(line.calls == 2);
+    REQUIRE(samples.front().x == -2);
+    REQUIRE(samples.back().x == 2);
+    REQUIRE(std::is_sorted(samples.begin(), samples.end(),
+      [](const CurveSampler::Point & p, const CurveSampler::Point & q) { return p.x < q.x; }));
+  }
+
+  {
+    INFO("a smooth curve is drawn within the tolerance");
+    Counted wave([](double x) { return std::sin(x); });
+    auto samples = sampler.sample(-10, 10, wave.function());
+    REQUIRE(wave.evaluations == samples.size());
+    REQUIRE(samples.size() < 400);
+    REQUIRE(plotError(samples, wave.f) < 2 * sampler.maxError);
+  }
+
+  {
+    INFO("the samples gather at a kink");
+    Counted kink([](double x) { return std::sqrt(std::abs(x)); });
+    auto samples = sampler.sample(-1, 1, kink.function());
+    std::size_t near = std::count_if(samples.begin(), samples.end(),
+      [](const CurveSampler::Point & p) { return std::abs(p.x) < 0.05; });
+    REQUIRE(near > samples.size() / 5);
+    REQUIRE(plotError(samples, kink.f) < 0.5);
+  }
+
+  {
+    INFO("the budgets bound the evaluations");
+    Counted noise([](double x) {
+      double h = std::sin(12345.678 * x) * 43758.5453;
+      return h - std::floor(h);
+    });
+    sampler.maxSamples = 500;
+    auto samples = sampler.sample(0, 1, noise.function());
+    REQUIRE(noise.evaluations == 500);
+    REQUIRE(samples.size() == 500);
+
+    Counted pole([](double x) { return 1 / x; });
+    sampler.maxSamples = 4096;
+    sampler.maxDepth = 4;
+    samples = sampler.sample(-1, 1, pole.function());
+    REQUIRE(pole.calls == 1 + sampler.maxDepth);
+  }
+
+  {
+    INFO("the uniform intervals are sampled whatever the budget");
+    Counted line([](double x) { return x; });
+    sampler.intervals = 1000;
+    sampler.maxSamples = 10;
+    auto samples = sampler.sample(0, 1, line.function());
+    REQUIRE(samples.size() == 1001);
+  }
+}
+
+TEST_CASE( "Test curve sampler spends its budget where the curve is roughest", "[curve_sampler]" ) {
+
+  CurveSampler sampler;
+  sampler.intervals = 2;
+
+  // a low bump left of 0 and a high one right of it, so that the halves of
+  // both are rough after the first round, those on the right the more
+  Counted bumps([](double x) {
+    return x < 0 ? 0.1 * (1 - (2 * x + 1) * (2 * x + 1)) : 1 - (2 * x - 1) * (2 * x - 1);
+  });
+
+  {
+    INFO("the last round tests the roughest intervals, wherever they are");
+    sampler.maxSamples = 7;
+    auto samples = sampler.sample(-1, 1, bumps.function());
+    REQUIRE(bumps.evaluations == 7);
+    REQUIRE(samples.size() == 7);
+    std::vector<double> xs;
+    for (auto & p : samples)
+      xs.push_back(p.x);
+    REQUIRE(xs == std::vector<double>({-1, -0.5, 0, 0.25, 0.5, 0.75, 1}));
+  }
+
+  {
+    INFO("without a budget both bumps are refined");
+    sampler.maxSamples = 4096;
+    auto samples = sampler.sample(-1, 1, bumps.function());
+    REQUIRE(std::count_if(samples.begin(), samples.end(),
+      [](const CurveSampler::Point & p) { return p.x < -0.5 && p.x > -1; }) > 1);
+    REQUIRE(plotError(samples, bumps.f) < 2 * sampler.maxError);
+  }
+}
@@ -0,0 +1,70 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "environment.hpp"
+
+// the symbols prefix0, prefix1, ... interned up front
+static std::vector<Atom> symbolNames(std::size_t count, const std::string & prefix) {
+
+  std::vector<Atom> names;
+  names.reserve(count);
+  for (std::size_t i = 0; i < count; ++i)
+    names.push_back(Atom(prefix + std::to_string(i)));
+  return names;
+}
+
+// names in a fixed random order, so lookups do not follow definition order
+static std::vector<Atom> shuffled(std::vector<Atom> names) {
+
+  std::shuffle(names.begin(), names.end(), std::mt19937(42));
+  return names;
+}
+
+// defining, finding and missing top-level symbols with 10, 1k and 100k
+// bindings in the environment
+BENCHMARK_CASE(environment_throughput) {
+
+  const std::size_t operations = 1000000;
+
+  double construct = bench.run("construct default", 10000, [] {
+    Environment env;
+    doNotOptimize(env);
+  });
+
+  for (std::size_t size : {10, 1000, 100000}) {
+    const std::string suffix = ", " + std::to_string(size) + " bindings";
+    std::vector<Atom> names = symbolNames(size, "sym");
+    std::vector<Atom> lookups = shuffled(names);
+    std::vector<Atom> missing = shuffled(symbolNames(size, "missing"));
+    const Expression value(1.);
+    const std::size_t rounds = operations / size;
+
+    double define = bench.run("define all" + suffix, rounds, [&] {
+      Environment env;
+      for (auto & name : names)
+        env.add_exp(name, value);
+      doNotOptimize(env);
+    });
+    bench.report("define" + suffix, (define - construct) / size, "ns");
+
+    Environment env;
+    for (auto & name : names)
+      env.add_exp(name, value);
+
+    double find = bench.run("find all" + suffix, rounds, [&] {
+      for (auto & name : lookups)
+        doNotOptimize(env.find_exp(name));
+    });
+    bench.report("find" + suffix, find / size, "ns");
+
+    double miss = bench.run("miss all" + suffix, rounds, [&] {
+      for (auto & name : missing)
+        doNotOptimize(env.find_exp(name));
+    });
+    bench.report("miss" + suffix, miss / size, "ns");
+  }
+}
@@ -5,14 +5,30 @@
 #include <cmath>
 //#include <complex>
 #include <iostream>
+#include <utility>
 
+#include "arena.hpp"
+#include "closure.hpp"
 #include "environment.hpp"
 #include "semantic_error.hpp"
+#include "vector_math.hpp"
 
 /***********************************************************************
 Helper Functions
 **********************************************************************/
 
+// intern a builtin name
+SymbolId symbol(const char * name) {
+	return SymbolTable::getInstance().intern(name);
+}
+
+// an expression holding a string literal
+Expression string_literal(const char * text) {
+	Atom a(text);
+	a.setStringLiteral();
+	return Expression(std::move(a));
+}
+
 // predicate, the number of args is nargs
 bool nargs_equal(const std::vector<Expression> & args, unsigned nargs) {
 	return args.size() == nargs;
@@ -24,7 +40,7 @@ typedef'd Procedure function pointer.
 **********************************************************************/
 
 // the default procedure always returns an expresison of type None
-Expression default_proc(const std::vector<Expression> & args) {
+Expression default_proc(std::vector<Expression> args) {
 	args.size(); // make compiler happy we used this parameter
 	return Expression();
 };
@@ -34,7 +50,342 @@ const double PI = std::atan2(0, -1);
 const double EXP = std::exp(1);
 const std::complex<double> I(0, 1);
 
-Expression add(const std::vector<Expression> & args) {
+/***********************************************************************
+Arithmetic over lists
+
+A call of an arithmetic procedure with list arguments applies it to the
+elements at each index of the lists, the other arguments being repeated,
+and makes the list of the results: the value map would give.
+**********************************************************************/
+
+typedef std::complex<double> Complex;
+
+// true if exp is a list
+bool is_list(const Expression & exp) {
+	return exp.head().symbolId() == Symbols::List;
+}
+
+// true if any argument is a list
+bool has_list(const std::vector<Expression> & args) {
+	for (auto & a : args) {
+		if (is_list(a))
+			return true;
+	}
+	return false;
+}
+
+// a Number or Complex Number, or a packed list of them, as contiguous
+// doubles: the value, or the real then imaginary part, of each element
+struct Operand {
+	bool list;
+	bool complex;
+	std::size_t length;           // the number of elements of a list
+	Expression::Numbers computed; // the values of a computed operand
+	const double * values;
+
+	Operand(): list(false), complex(false), length(0), values(nullptr) {}
+
+	// a computed operand, to be filled through out()
+	Operand(bool isList, bool isComplex, std::size_t n): list(isList), complex(isComplex),
+		length(isList ? n : 0), computed((isList ? n : 1) * (isComplex ? 2 : 1)),
+		values(computed.data()) {}
+
+	// moving the vector keeps its buffer, so values stays valid
+	Operand(Operand &&) = default;
+	Operand & operator=(Operand &&) = default;
+	Operand(const Operand &) = delete;
+	Operand & operator=(const Operand &) = delete;
+
+	// the number of elements read, 1 for a number
+	std::size_t count() const { return list ? length : 1; }
+
+	// the stride of its elements, 0 for a number read at each index
+	std::size_t stride() const { return list ? 1 : 0; }
+
+	double * out() { return computed.data(); }
+
+	double real(std::size_t i) const { return values[i * stride()]; }
+
+	Complex complexNumber(std::size_t i) const {
+		return Complex(values[2 * i * stride()], values[2 * i * stride() + 1]);
+	}
+
+	void set(std::size_t i, Complex z) {
+		computed[2 * i] = z.real();
+		computed[2 * i + 1] = z.imag();
+	}
+
+	Expression value() {
+		if (list)
+			return Expression::packedList(std::move(computed), complex);
+		if (complex)
+			return Expression(Complex(computed[0], computed[1]));
+		return Expression(computed[0]);
+	}
+};
+
+// a number operand
+Operand number_operand(Complex z, bool complex) {
+	Operand x(false, complex, 1);
+	if (complex)
+		x.set(0, z);
+	else
+		x.out()[0] = z.real();
+	return x;
+}
+
+// the arguments as operands, false unless each is a number or a packed list
+bool to_operands(const std::vector<Expression> & args, std::vector<Operand> & operands) {
+
+	operands.reserve(args.size());
+	for (auto & a : args) {
+		if (a.isHeadNumber())
+			operands.push_back(number_operand(a.head().asNumber(), false));
+		else if (a.head().isComplexNumber())
+			operands.push_back(number_operand(a.head().asComplexNumber(), true));
+		else if (is_list(a) && a.packedTail() != nullptr) {
+			Operand x;
+			x.list = true;
+			x.complex = a.tailPacking() == Expression::PackedComplex;
+			x.length = a.listLength();
+			x.values = a.packedTail();
+			operands.push_back(std::move(x));
+		}
+		else
+			return false;
+	}
+	return true;
+}
+
+// the result of an operation on a and b, as long as the list among them
+Operand result_of(const Operand & a, const Operand & b, bool complex) {
+	return Operand(a.list || b.list, complex, a.list ? a.length : b.length);
+}
+
+// the result of an operation on a, as long as a
+Operand result_of(const Operand & a, bool complex) {
+	return Operand(a.list, complex, a.length);
+}
+
+// f(a[i], b[i]) for a Complex and b Number operand
+template <typename F>
+Operand zip_complex_real(const Operand & a, const Operand & b, F f) {
+	Operand r = result_of(a, b, true);
+	for (std::size_t i = 0; i < r.count(); ++i)
+		r.set(i, f(a.complexNumber(i), b.real(i)));
+	return r;
+}
+
+// f(a[i], b[i]) for a Number and b Complex operand
+template <typename F>
+Operand zip_real_complex(const Operand & a, const Operand & b, F f) {
+	Operand r = result_of(a, b, true);
+	for (std::size_t i = 0; i < r.count(); ++i)
+		r.set(i, f(a.real(i), b.complexNumber(i)));
+	return r;
+}
+
+// a op b for two operands of the same kind, vectorized
+Operand vector_op(VectorMath::Operation op, const Operand & a, const Operand & b) {
+	Operand r = result_of(a, b, a.complex);
+	if (a.complex)
+		VectorMath::applyComplex(op, a.values, a.stride(), b.values, b.stride(), r.out(), r.count());
+	else
+		VectorMath::apply(op, a.values, a.stride(), b.values, b.stride(), r.out(), r.count());
+	return r;
+}
+
+// a Procedure's value over operands, computed on whole arrays; false if
+// the call is left to the procedure, element by element
+typedef bool (*ListKernel)(const std::vector<Operand> & operands, Operand & result);
+
+// the length shared by the list arguments of a call
+std::size_t broadcast_length(const std::vector<Expression> & args, const char * name) {
+
+	std::size_t length = 0;
+	bool found = false;
+	for (auto & a : args) {
+		if (!is_list(a))
+			continue;
+		std::size_t n = a.listLength();
+		if (found && n != length)
+			throw SemanticError(std::string("Error in call to ") + name + ": lists of different lengths.");
+		length = n;
+		found = true;
+	}
+	return length;
+}
+
+// the value of a call of proc with list arguments, by kernel when every
+// argument is a number or a packed list
+Expression broadcast(const std::vector<Expression> & args, const char * name, Procedure proc, ListKernel kernel) {
+
+	const std::size_t length = broadcast_length(args, name);
+
+	std::vector<Operand> operands;
+	Operand result;
+	if (to_operands(args, operands) && kernel(operands, result))
+		return result.value();
+
+	std::vector<Expression> items;
+	items.reserve(length);
+	std::vector<Expression> elementArgs(args.size());
+	for (std::size_t i = 0; i < length; ++i) {
+		for (std::size_t j = 0; j < args.size(); ++j)
+			elementArgs[j] = is_list(args[j]) ? args[j].listElement(i) : args[j];
+		items.push_back(proc(elementArgs));
+	}
+	return Expression::makeList(std::move(items));
+}
+
+// true if any operand is complex
+bool any_complex(const std::vector<Operand> & operands) {
+	for (auto & x : operands) {
+		if (x.complex)
+			return true;
+	}
+	return false;
+}
+
+// the sum, adding in order from 0 as add does
+bool add_lists(const std::vector<Operand> & operands, Operand & result) {
+
+	const bool complex = any_complex(operands);
+	Operand sum = number_operand(0, complex);
+	for (auto & x : operands) {
+		if (complex && !x.complex)
+			sum = zip_complex_real(sum, x, [](Complex a, double b) { return a + b; });
+		else
+			sum = vector_op(VectorMath::Add, sum, x);
+	}
+	result = std::move(sum);
+	return true;
+}
+
+// the product, multiplying in order from 1 as mul does
+bool mul_lists(const std::vector<Operand> & operands, Operand & result) {
+
+	const bool complex = any_complex(operands);
+	Operand product = number_operand(1, complex);
+	for (auto & x : operands) {
+		if (complex && !x.complex)
+			product = zip_complex_real(product, x, [](Complex a, double b) { return a * b; });
+		else
+			product = vector_op(VectorMath::Multiply, product, x);
+	}
+	result = std::move(product);
+	return true;
+}
+
+// the negation or difference, with the imaginary parts subneg gives
+bool subneg_lists(const std::vector<Operand> & operands, Operand & result) {
+
+	const Operand & a = operands[0];
+	if (operands.size() == 1) {
+		result = result_of(a, a.complex);
+		VectorMath::negate(a.values, result.out(), result.computed.size());
+		return true;
+	}
+
+	const Operand & b = operands[1];
+	if (a.complex == b.complex)
+		result = vector_op(VectorMath::Subtract, a, b);
+	else if (a.complex)
+		result = zip_complex_real(a, b, [](Complex x, double y) { return Complex(x.real() - y, -x.imag()); });
+	else
+		result = zip_real_complex(a, b, [](double x, Complex y) { return Complex(x - y.real(), -y.imag()); });
+	return true;
+}
+
+// the reciprocal or quotient
+bool div_lists(const std::vector<Operand> & operands, Operand & result) {
+
+	if (operands.size() == 1) {
+		const Operand & a = operands[0];
+		result = vector_op(VectorMath::Divide, number_operand(1, a.complex), a);
+		return true;
+	}
+
+	const Operand & a = operands[0];
+	const Operand & b = operands[1];
+	if (a.complex == b.complex)
+		result = vector_op(VectorMath::Divide, a, b);
+	else if (a.complex)
+		result = zip_complex_real(a, b, [](Complex x, double y) { return x / y; });
+	else
+		result = zip_real_complex(a, b, [](double x, Complex y) { return x / y; });
+	return true;
+}
+
+// the power, of Complex Numbers if either operand is
+bool exponent_lists(const std::vector<Operand> & operands, Operand & result) {
+
+	const Operand & a = operands[0];
+	const Operand & b = operands[1];
+	if (!a.complex && !b.complex) {
+		result = result_of(a, b, false);
+		for (std::size_t i = 0; i < result.count(); ++i)
+			result.out()[i] = std::pow(a.real(i), b.real(i));
+	}
+	else if (!b.complex)
+		result = zip_complex_real(a, b, [](Complex x, double y) { return std::pow(x, y); });
+	else if (!a.complex)
+		result = zip_real_complex(a, b, [](double x, Complex y) { return std::pow(x, y); });
+	else {
+		result = result_of(a, b, true);
+		for (std::size_t i = 0; i < result.count(); ++i)
+			result.set(i, std::pow(a.complexNumber(i), b.complexNumber(i)));
+	}
+	return true;
+}
+
+// the square roots, unless a negative Number makes some of them complex
+bool sqrt_lists(const std::vector<Operand> & operands, Operand & result) {
+
+	const Operand & a = operands[0];
+	if (a.complex) {
+		result = result_of(a, true);
+		for (std::size_t i = 0; i < result.count(); ++i)
+			result.set(i, std::sqrt(a.complexNumber(i)));
+		return true;
+	}
+	if (!VectorMath::nonNegative(a.values, a.count()))
+		return false;
+	result = result_of(a, false);
+	VectorMath::sqrt(a.values, result.out(), result.count());
+	return true;
+}
+
+// f of each element of a list of Numbers; anything else is left to the
+// procedure to reject
+template <double (*f)(double)>
+bool real_function_lists(const std::vector<Operand> & operands, Operand & result) {
+
+	const Operand & a = operands[0];
+	if (a.complex)
+		return false;
+	result = result_of(a, false);
+	for (std::size_t i = 0; i < result.count(); ++i)
+		result.out()[i] = f(a.values[i]);
+	return true;
+}
+
+double natural_log(double x) { return std::log(x); }
+double sine(double x) { return std::sin(x); }
+double cosine(double x) { return std::cos(x); }
+double tangent(double x) { return std::tan(x); }
+
+// the logarithms, unless a negative Number makes ln fail
+bool ln_lists(const std::vector<Operand> & operands, Operand & result) {
+	if (!operands[0].complex && !VectorMath::nonNegative(operands[0].values, operands[0].count()))
+		return false;
+	return real_function_lists<natural_log>(operands, result);
+}
+
+Expression add(std::vector<Expression> args) {
+
+	if (has_list(args))
+		return broadcast(args, "add", add, add_lists);
 
 	// check all aruments are numbers, while adding
 	double realSum = 0, imagSum = 0;
@@ -63,7 +414,7 @@ Expression add(const std::vector<Expression> & args) {
 	return Expression(result);
 };
 
-Expression mul(const std::vector<Expression> & args) {
+Expression mul(std::vector<Expression> args) {
 
 	// check all aruments are numbers, while multiplying
 	std::complex<double> result(1, 0);
@@ -72,6 +423,9 @@ Expression mul(const std::vector<Expression> & args) {
 	if (nargs_equal(args, 1))
 		throw SemanticError("Error in call to mul, invalid number of arguments");
 
+	if (has_list(args))
+		return broadcast(args, "mul", mul, mul_lists);
+
 	for (auto & a : args) {
 		if (a.isHeadSymbol())
 			throw SemanticError("Error in call to mul, argument not a number");
@@ -94,11 +448,14 @@ Expression mul(const std::vector<Expression> & args) {
 		return Expression(result);
 };
 
-Expression subneg(const std::vector<Expression> & args) {
+Expression subneg(std::vector<Expression> args) {
 
 	double realResult = 0, imagResult = 0;
 	bool flag = true;
 
+	if ((nargs_equal(args, 1) || nargs_equal(args, 2)) && has_list(args))
+		return broadcast(args, "subtraction", subneg, subneg_lists);
+
 	// preconditions
 	if (nargs_equal(args, 1)) {
 		if (args[0].isHeadNumber()) {
@@ -154,10 +511,13 @@ Expression subneg(const std::vector<Expression> & args) {
 		return Expression(result);
 };
 
-Expression div(const std::vector<Expression> & args) {
+Expression div(std::vector<Expression> args) {
 
 	std::complex<double> result(0, 0);
 	bool flag = true;
+
+	if ((nargs_equal(args, 1) || nargs_equal(args, 2)) && has_list(args))
+		return broadcast(args, "div", div, div_lists);
 	
 	if (nargs_equal(args,1))
 	{
@@ -201,11 +561,14 @@ Expression div(const std::vector<Expression> & args) {
 };
 
 //compute the exponent. 1st input is base and 2nd is the exponent 
-Expression exponent(const std::vector<Expression>& args) {
+Expression exponent(std::vector<Expression> args) {
 
 	std::complex<double> result(0, 0);
 	bool flag = true;
 
+	if (nargs_equal(args, 2) && has_list(args))
+		return broadcast(args, "exponent", exponent, exponent_lists);
+
 	if (nargs_equal(args, 2))
 	{
 		if ((args[0].isHeadNumber()) && (args[1].isHeadNumber()))
@@ -237,11 +600,14 @@ Expression exponent(const std::vector<Expression>& args) {
 		return Expression(result);
 };
 
-Expression sqrt(const std::vector<Expression> & args) {
+Expression sqrt(std::vector<Expression> args) {
 
 	std::complex<double> result(0,0);
 	bool flag = true;
 
+	if (nargs_equal(args, 1) && has_list(args))
+		return broadcast(args, "square root", sqrt, sqrt_lists);
+
 	if (nargs_equal(args, 1))
 	{
 		if (args[0].isHeadNumber())
@@ -269,10 +635,13 @@ Expression sqrt(const std::vector<Expression> & args) {
 };
 
 // computes the natural log
-Expression ln(const std::vector<Expression> & args) {
+Expression ln(std::vector<Expression> args) {
 
 	double result = 0;
 
+	if (nargs_equal(args, 1) && has_list(args))
+		return broadcast(args, "natural log", ln, ln_lists);
+
 	if (nargs_equal(args, 1))
 	{
 		if (args[0].isHeadNumber())
@@ -293,10 +662,13 @@ Expression ln(const std::vector<Expression> & args) {
 
 
 // computes the sine
-Expression sin(const std::vector<Expression> & args) {
+Expression sin(std::vector<Expression> args) {
 
 	double result = 0;
 
+	if (nargs_equal(args, 1) && has_list(args))
+		return broadcast(args, "sine", sin, real_function_lists<sine>);
+
 	if (nargs_equal(args, 1))
 	{
 		if (args[0].isHeadNumber())
@@ -311,10 +683,13 @@ Expression sin(const std::vector<Expression> & args) {
 };
 
 // computes the cosine
-Expression cos(const std::vector<Expression> & args) {
+Expression cos(std::vector<Expression> args) {
 
 	double result = 0;
 
+	if (nargs_equal(args, 1) && has_list(args))
+		return broadcast(args, "cosine", cos, real_function_lists<cosine>);
+
 	if (nargs_equal(args, 1))
 	{
 		if (args[0].isHeadNumber())
@@ -329,10 +704,13 @@ Expression cos(const std::vector<Expression> & args) {
 };
 
 // computes the tangent
-Expression tan(const std::vector<Expression> & args) {
+Expression tan(std::vector<Expression> args) {
 
 	double result = 0;
 
+	if (nargs_equal(args, 1) && has_list(args))
+		return broadcast(args, "tangent", tan, real_function_lists<tangent>);
+
 	if (nargs_equal(args, 1))
 	{
 		if (args[0].isHeadNumber())
@@ -347,7 +725,7 @@ Expression tan(const std::vector<Expression> & args) {
 };
 
 // returns real part of a complex number
-Expression real(const std::vector<Expression> & args) {
+Expression real(std::vector<Expression> args) {
 
 	if (nargs_equal(args, 1) && args[0].head().isComplexNumber())
 		return Expression(std::real(args[0].head().asComplexNumber()));
@@ -356,7 +734,7 @@ Expression real(const std::vector<Expression> & args) {
 };
 
 // returns imaginary part of a complex number
-Expression imaginary(const std::vector<Expression> & args) {
+Expression imaginary(std::vector<Expression> args) {
 
 	if (nargs_equal(args, 1) && args[0].head().isComplexNumber())
 		return Expression(std::imag(args[0].head().asComplexNumber()));
@@ -365,7 +743,7 @@ Expression imaginary(const std::vector<Expression> & args) {
 };
 
 // returns phase angle of a complex number in radians 
-Expression arg(const std::vector<Expression> & args) {
+Expression arg(std::vector<Expression> args) {
 
 	if (nargs_equal(args, 1) && args[0].head().isComplexNumber())
 		return Expression(std::arg(args[0].head().asComplexNumber()));
@@ -374,7 +752,7 @@ Expression arg(const std::vector<Expression> & args) {
 };
 
 // returns the conjugate of a complex number 
-Expression conj(const std::vector<Expression> & args) {
+Expression conj(std::vector<Expression> args) {
 
 	if (nargs_equal(args, 1) && args[0].head().isComplexNumber())
 		return Expression(std::conj(args[0].head().asComplexNumber()));
@@ -383,7 +761,7 @@ Expression conj(const std::vector<Expression> & args) {
 };
 
 // returns the magnitude of a complex number 
-Expression mag(const std::vector<Expression> & args) {
+Expression mag(std::vector<Expression> args) {
 
 	if (nargs_equal(args, 1) && args[0].head().isComplexNumber())
 		return Expression(std::abs(args[0].head().asComplexNumber()));
@@ -393,25 +771,20 @@ Expression mag(const std::vector<Expression> & args) {
 
 // Milestone 1 task 2
 // returns list of the arguments 
-Expression list(const std::vector<Expression> & args) {
-
-	Atom list_head("list");
-	Expression list(list_head);
+Expression list(std::vector<Expression> args) {
 
-	for (unsigned int i = 0; i < args.size(); i++) {
-		list.addToTail(args[i]);
-	}
-	 return list;
+	// the arguments become the tail as they are, packed if all numbers
+	return Expression::makeList(std::move(args));
 };
 
 // this functions returns the first expression of the list 
-Expression first(const std::vector<Expression> &args) 
+Expression first(std::vector<Expression> args) 
 {
-	Expression firstList(Atom("list"));
+	Expression firstList(Atom::fromSymbolId(Symbols::List));
 	if (nargs_equal(args, 1)) {
-		if (args[0].tailConstBegin() != args[0].tailConstEnd()) {
-			if (args[0].head().asSymbol() == "list")
-				firstList = *(args[0].tailConstBegin());
+		if (!args[0].isListEmpty()) {
+			if (args[0].head().symbolId() == Symbols::List)
+				firstList = args[0].listElement(0);
 			else
 				throw SemanticError("Error in call to first: argument not a list");
 		}
@@ -424,26 +797,23 @@ Expression first(const std::vector<Expression> &args)
 }
 
 
-Expression rest(const std::vector<Expression> &args) {
+Expression rest(std::vector<Expression> args) {
 
-	if (args[0].head().asSymbol() != "list")
+	if (args[0].head().symbolId() != Symbols::List)
 	{
 		throw SemanticError("Error: argument to rest is not a list.");
 
 	}
 		if (nargs_equal(args, 1))
 		{
-			if (args[0].head().asSymbol() != "list")
+			if (args[0].head().symbolId() != Symbols::List)
 				throw SemanticError("Error: argument to rest is not a list.");
 
 			if (args[0].isListEmpty())
 				throw SemanticError("Error: argument to rest is an empty list.");
 			
-			Expression rest(Atom("list"));
-			for (auto  a = args[0].tailConstBegin() + 1; a != args[0].tailConstEnd(); ++a)
-				rest.addToTail(*a);
-
-			return rest;
+			// shares the storage of the argument
+			return args[0].tailList(1);
 			
 		}
 		else
@@ -451,12 +821,12 @@ Expression rest(const std::vector<Expression> &args) {
 
 }
 
-Expression length(const std::vector<Expression> &args)
+Expression length(std::vector<Expression> args)
 {
 
 		if (nargs_equal(args, 1))
 		{
-			if (args[0].head() != Expression(Atom("list")))
+			if (args[0].head().symbolId() != Symbols::List)
 				throw SemanticError("Error: argument to length is not a list.");
 
 			return Expression(Atom(args[0].listLength()));
@@ -465,39 +835,41 @@ Expression length(const std::vector<Expression> &args)
 			throw SemanticError("Error: more than one argument in call to length.");
 }
 
-Expression append(const std::vector<Expression> &args)
+Expression append(std::vector<Expression> args)
 {
 	if (nargs_equal(args, 2))
 	{
-		if (args[0].head() != Expression(Atom("list")))
+		if (args[0].head().symbolId() != Symbols::List)
 			throw SemanticError("Error: first argument to append not a list.");
 
-		Expression newList(Atom("list"));
-		for (auto a = args[0].tailConstBegin(); a != args[0].tailConstEnd(); ++a)
-			newList.addToTail(*a);
-		newList.addToTail(args[1]);
+		// the elements are shared; the tail is extended in place when the
+		// argument was its only owner
+		Expression newList = args[0].tailList();
+		args[0] = Expression();
+		newList.addToTail(std::move(args[1]));
 		return newList;
 	}
 	else
 		throw SemanticError("Error in append: invalid number of arguments");
 }
 
-Expression join(const std::vector<Expression> &args)
+Expression join(std::vector<Expression> args)
 {
-	if (args[0].head() != Expression(Atom("list")) || args[1].head() != Expression(Atom("list")))
+	if (args[0].head().symbolId() != Symbols::List || args[1].head().symbolId() != Symbols::List)
 		throw SemanticError("Error: first argument to join not a list.");
 	else
 	{
-		Expression newList(Atom("list"));
-		for (auto a = args[0].tailConstBegin(); a != args[0].tailConstEnd(); ++a)
-			newList.addToTail(*a);
-		for (auto a = args[1].tailConstBegin(); a != args[1].tailConstEnd(); ++a)
-			newList.addToTail(*a);
+		// the elements are shared; the first tail is extended in place when
+		// the argument was its only owner
+		Expression newList = args[0].tailList();
+		args[0] = Expression();
+		for (int i = 0; i < args[1].listLength(); ++i)
+			newList.addToTail(args[1].listElement(i));
 		return newList;
 	}
 }
 
-Expression range(const std::vector<Expression> &args)
+Expression range(std::vector<Expression> args)
 {
 	if (!args[0].isHeadNumber() || !args[1].isHeadNumber() || !args[2].isHeadNumber())
 		throw SemanticError("Error: argument not a number.");
@@ -509,85 +881,305 @@ Expression range(const std::vector<Expression> &args)
 			throw SemanticError("Error: negative or zero increment in range.");
 		else
 		{
-			Expression rangeList(Atom("list"));
+			// a hint, rounding may make the loop add one more or less
+			double count = std::floor((args[1].head().asNumber() - args[0].head().asNumber())
+				/ args[2].head().asNumber()) + 1;
+			Expression::Numbers numbers;
+			if (count < 1e8)
+				numbers.reserve(static_cast<std::size_t>(count));
 			for (double a = args[0].head().asNumber(); a <= args[1].head().asNumber(); a += args[2].head().asNumber())
-			{
-				rangeList.addToTail(Expression(a));
-				//a += args[2].head().asNumber();
-			}
-			return rangeList;
+				numbers.push_back(a);
+			return Expression::packedList(std::move(numbers));
 		}
 	}
 }
 
 
-Environment::Environment() {
+// graphic primitives, with the properties the start-up file used to give
+// them; the properties are built once, on the heap, and shared by every
+// primitive until it is modified
+
+// the properties of a point
+const Expression & pointProperties() {
+	static const Expression properties = [] {
+		ArenaScope heap(nullptr);
+		Expression p;
+		p.setProperty("object-name", string_literal("point"));
+		p.setProperty("size", Expression(0.0));
+		return p;
+	}();
+	return properties;
+}
+
+// returns the point (x y) of size 0
+Expression make_point(std::vector<Expression> args)
+{
+	if (!nargs_equal(args, 2))
+		throw SemanticError("Error in call to make-point: invalid number of arguments");
 
-	reset();
+	Expression point = list(std::move(args));
+	point.shareProperties(pointProperties());
+	return point;
+}
+
+// the point (0 0), where texts are placed
+const Expression & origin() {
+	static const Expression point = [] {
+		ArenaScope heap(nullptr);
+		return make_point({ Expression(0.0), Expression(0.0) });
+	}();
+	return point;
+}
+
+// the properties of a line
+const Expression & lineProperties() {
+	static const Expression properties = [] {
+		ArenaScope heap(nullptr);
+		Expression l;
+		l.setProperty("object-name", string_literal("line"));
+		l.setProperty("thickness", Expression(1.0));
+		return l;
+	}();
+	return properties;
+}
+
+// returns the line from p1 to p2 of thickness 1
+Expression make_line(std::vector<Expression> args)
+{
+	if (!nargs_equal(args, 2))
+		throw SemanticError("Error in call to make-line: invalid number of arguments");
+
+	Expression line = list(std::move(args));
+	line.shareProperties(lineProperties());
+	return line;
+}
+
+// the properties of a text
+const Expression & textProperties() {
+	static const Expression properties = [] {
+		ArenaScope heap(nullptr);
+		Expression t;
+		t.setProperty("object-name", string_literal("text"));
+		t.setProperty("position", origin());
+		t.setProperty("text-scale", Expression(1.0));
+		t.setProperty("text-rotation", Expression(0.0));
+		return t;
+	}();
+	return properties;
+}
+
+// returns the text str at the origin, unscaled and unrotated
+Expression make_text(std::vector<Expression> args)
+{
+	if (!nargs_equal(args, 1))
+		throw SemanticError("Error in call to make-text: invalid number of arguments");
+
+	Expression text = std::move(args[0]);
+
+	// the properties of the argument are kept unless these replace them
+	if (!text.hasProperties()) {
+		text.shareProperties(textProperties());
+		return text;
+	}
+	text.setProperty("object-name", string_literal("text"));
+	text.setProperty("position", origin());
+	text.setProperty("text-scale", Expression(1.0));
+	text.setProperty("text-rotation", Expression(0.0));
+	return text;
+}
+
+struct Environment::Defaults {
+	SymbolMap<EnvResult> expressions;
+	SymbolMap<Procedure> procedures;
+
+	Defaults();
+};
+
+const Environment::Defaults & Environment::defaults() {
+
+	static const Defaults table;
+	return table;
+}
+
+Environment::EnvResult::EnvResult(Expression && e): exp(std::move(e)) {
+
+	if (exp.head().symbolId() == Symbols::Lambda)
+		closure = std::make_shared<const Closure>(exp);
+}
+
+Environment::Environment(): m_defaults(&defaults()), m_parent(nullptr), m_closure(nullptr) {}
+
+Environment::Environment(const Environment * parent):
+	m_defaults(nullptr), m_parent(parent), m_closure(nullptr) {}
+
+Environment::Environment(const Environment * parent, const Closure & closure):
+	m_defaults(nullptr), m_parent(parent), m_closure(&closure) {
+
+	m_slots.reserve(closure.arity());
+}
+
+void Environment::bind_param(Expression && exp) {
+
+	if (!m_closure->param(m_slots.size()).isSymbol()) {
+		throw SemanticError("Attempt to add non-symbol to environment");
+	}
+
+	m_slots.emplace_back(std::move(exp));
+}
+
+bool Environment::hides(const Environment & other) const {
+
+	auto bound = [this](SymbolId id) {
+		return (m_closure != nullptr && m_closure->slotOf(id, m_slots.size()) >= 0)
+			|| envmap.count(id) != 0;
+	};
+
+	for (std::size_t i = 0; i < other.m_slots.size(); ++i) {
+		if (!bound(other.m_closure->param(i).symbolId()))
+			return false;
+	}
+	return other.envmap.all_of([&bound](const std::pair<SymbolId, EnvResult> & binding) {
+		return bound(binding.first);
+	});
+}
+
+const Environment::EnvResult * Environment::find(const Atom & sym, Procedure * proc) const {
+
+	if (!sym.isSymbol()) return nullptr;
+
+	const SymbolId id = sym.symbolId();
+	const Environment * frame = this;
+	for (; ; frame = frame->m_parent) {
+		if (frame->m_closure != nullptr) {
+			int slot = frame->m_closure->slotOf(id, frame->m_slots.size());
+			if (slot >= 0)
+				return &frame->m_slots[slot];
+		}
+		const EnvResult * result = frame->envmap.find(id);
+		if (result != nullptr)
+			return result;
+		if (frame->m_parent == nullptr)
+			break;
+	}
+
+	if (frame->m_defaults == nullptr)
+		return nullptr;
+
+	const EnvResult * builtin = frame->m_defaults->expressions.find(id);
+	if (builtin != nullptr)
+		return builtin;
+
+	if (proc != nullptr) {
+		const Procedure * builtinProc = frame->m_defaults->procedures.find(id);
+		if (builtinProc != nullptr)
+			*proc = *builtinProc;
+	}
+
+	return nullptr;
 }
 
 bool Environment::is_known(const Atom & sym) const {
-	if (!sym.isSymbol()) return false;
 
-	return envmap.find(sym.asSymbol()) != envmap.end();
+	Procedure proc = nullptr;
+	return find(sym, &proc) != nullptr || proc != nullptr;
 }
 
 bool Environment::is_exp(const Atom & sym) const {
-	if (!sym.isSymbol()) return false;
 
-	auto result = envmap.find(sym.asSymbol());
-	return (result != envmap.end()) && (result->second.type == ExpressionType);
+	return find(sym) != nullptr;
 }
 
 Expression Environment::get_exp(const Atom & sym) const {
 
-	Expression exp;
-
-	if (sym.isSymbol()) {
-		auto result = envmap.find(sym.asSymbol());
-		if ((result != envmap.end()) && (result->second.type == ExpressionType)) {
-			exp = result->second.exp;
-		}
+	const EnvResult * result = find(sym);
+	if (result != nullptr) {
+		return result->exp;
 	}
 
-	return exp;
+	return Expression();
+}
+
+const Expression * Environment::find_exp(const Atom & sym) const {
+
+	const EnvResult * result = find(sym);
+	if (result != nullptr)
+		return &result->exp;
+
+	return nullptr;
+}
+
+std::shared_ptr<const Closure> Environment::find_closure(const Atom & sym) const {
+
+	const EnvResult * result = find(sym);
+	if ((result == nullptr) || (result->exp.head().symbolId() != Symbols::Lambda))
+		return nullptr;
+
+	return result->closure;
 }
 
 void Environment::add_exp(const Atom & sym, const Expression & exp) {
 
+	add_exp(sym, Expression(exp));
+}
+
+void Environment::add_exp(const Atom & sym, Expression && exp) {
+
 	if (!sym.isSymbol()) {
 		throw SemanticError("Attempt to add non-symbol to environment");
 	}
 
-	// overwrite the symbol map if lambda is used 
-	if (envmap.find(sym.asSymbol()) != envmap.end()) {
-		envmap[sym.asSymbol()] = EnvResult(ExpressionType, exp);
+	// a top-level binding outlives the evaluation, so it must not keep the
+	// arena of the evaluation alive
+	if (m_parent == nullptr)
+		exp = exp.heapCopy();
+
+	// a definition in the body of a call rebinds a parameter in its slot
+	if (m_closure != nullptr) {
+		int slot = m_closure->slotOf(sym.symbolId(), m_slots.size());
+		if (slot >= 0) {
+			m_slots[slot] = EnvResult(std::move(exp));
+			return;
+		}
 	}
 
-	envmap.emplace(sym.asSymbol(), EnvResult(ExpressionType, exp));
+	// overwrite the symbol map if lambda is used 
+	auto binding = envmap.try_emplace(sym.symbolId(), std::move(exp));
+	if (!binding.second)
+		*binding.first = EnvResult(std::move(exp));
+}
+
+void Environment::add_all(const Environment & other) {
+
+	other.envmap.all_of([this](const std::pair<SymbolId, EnvResult> & binding) {
+		auto copy = envmap.try_emplace(binding.first, binding.second);
+		if (!copy.second)
+			*copy.first = binding.second;
+		return true;
+	});
 }
 
 bool Environment::is_proc(const Atom & sym) const {
-	if (!sym.isSymbol()) return false;
 
-	auto result = envmap.find(sym.asSymbol());
-	return (result != envmap.end()) && (result->second.type == ProcedureType);
+	Procedure proc = nullptr;
+	return find(sym, &proc) == nullptr && proc != nullptr;
+}
+
+bool Environment::is_builtin_proc(const Atom & sym) {
+
+	return sym.isSymbol() && defaults().procedures.count(sym.symbolId()) != 0
+		&& defaults().expressions.count(sym.symbolId()) == 0;
 }
 
 bool Environment::is_list(const std::vector<Expression> & exp) const
 {
-	return (Expression(exp[0].head()) == Expression(Atom("list")));
+	return (Expression(exp[0].head()) == Expression(Atom::fromSymbolId(Symbols::List)));
 }
 
 Procedure Environment::get_proc(const Atom & sym) const {
 
-	//Procedure proc = default_proc;
-
-	if (sym.isSymbol()) {
-		auto result = envmap.find(sym.asSymbol());
-		if ((result != envmap.end()) && (result->second.type == ProcedureType)) {
-			return result->second.proc;
-		}
+	Procedure proc = nullptr;
+	if (find(sym, &proc) == nullptr && proc != nullptr) {
+		return proc;
 	}
 
 	return default_proc;
@@ -598,67 +1190,80 @@ Procedure Environment::get_proc(const Atom & sym) const {
 }*/
 
 /*
-Reset the environment to the default state. First remove all entries and
-then re-add the default ones.
+Reset the environment to the default state. Only the definitions made in it
+are removed; the defaults of a top-level environment are shared and never
+change.
  */
 void Environment::reset() {
 
 	envmap.clear();
+	m_slots.clear();
+}
+
+/*
+Build the default definitions and procedures.
+ */
+Environment::Defaults::Defaults() {
 
 	// Built-In value of pi
-	envmap.emplace("pi", EnvResult(ExpressionType, Expression(PI)));
-	envmap.emplace("-pi", EnvResult(ExpressionType, Expression(-PI)));
+	expressions.try_emplace(symbol("pi"), Expression(PI));
+	expressions.try_emplace(symbol("-pi"), Expression(-PI));
 
 	// Procedure: add;
-	envmap.emplace("+", EnvResult(ProcedureType, add));
+	procedures[symbol("+")] = add;
 
 	// Procedure: subneg;
-	envmap.emplace("-", EnvResult(ProcedureType, subneg));
+	procedures[symbol("-")] = subneg;
 
 	// Procedure: mul;
-	envmap.emplace("*", EnvResult(ProcedureType, mul));
+	procedures[symbol("*")] = mul;
 
 	// Procedure: div;
-	envmap.emplace("/", EnvResult(ProcedureType, div));
+	procedures[symbol("/")] = div;
 
 	//milestone 0
 	// task 3-1 Built-in value of e = exp(1)
-	envmap.emplace("e", EnvResult(ExpressionType, Expression(EXP)));
-	envmap.emplace("-e", EnvResult(ExpressionType, Expression(-EXP)));
+	expressions.try_emplace(symbol("e"), Expression(EXP));
+	expressions.try_emplace(symbol("-e"), Expression(-EXP));
 
 	// task 3-2 procedure: sqrt
-	envmap.emplace("sqrt", EnvResult(ProcedureType, sqrt));
+	procedures[symbol("sqrt")] = sqrt;
 
 	// task 3-3 precedure: exponent
-	envmap.emplace("^", EnvResult(ProcedureType, exponent));
+	procedures[symbol("^")] = exponent;
 
 	// task 3-4 procedure: natural log 
-	envmap.emplace("ln", EnvResult(ProcedureType, ln));
+	procedures[symbol("ln")] = ln;
 
 	// task 3-5~7 procedure: trig functions 
-	envmap.emplace("sin", EnvResult(ProcedureType, sin));
-	envmap.emplace("cos", EnvResult(ProcedureType, cos));
-	envmap.emplace("tan", EnvResult(ProcedureType, tan));
+	procedures[symbol("sin")] = sin;
+	procedures[symbol("cos")] = cos;
+	procedures[symbol("tan")] = tan;
 
 	//task 4-1 create built-in expression I 
-	envmap.emplace("I", EnvResult(ExpressionType, Expression(I)));
-	envmap.emplace("-I", EnvResult(ExpressionType, Expression(-I)));
+	expressions.try_emplace(symbol("I"), Expression(I));
+	expressions.try_emplace(symbol("-I"), Expression(-I));
 
 	//task 4-4  real, imaginary, arg, conj procedures implemented 
 
-	envmap.emplace("real", EnvResult(ProcedureType, real));
-	envmap.emplace("imag", EnvResult(ProcedureType, imaginary));
-	envmap.emplace("arg",  EnvResult(ProcedureType, arg));
-	envmap.emplace("conj", EnvResult(ProcedureType, conj));
-	envmap.emplace("mag", EnvResult(ProcedureType, mag));
+	procedures[symbol("real")] = real;
+	procedures[symbol("imag")] = imaginary;
+	procedures[symbol("arg")] = arg;
+	procedures[symbol("conj")] = conj;
+	procedures[symbol("mag")] = mag;
 
 	//milestone 1 task 1 creating a list 
-	envmap.emplace("list", EnvResult(ProcedureType, list));
-	envmap.emplace("first", EnvResult(ProcedureType, first));
-	envmap.emplace("rest", EnvResult(ProcedureType, rest));
-	envmap.emplace("length", EnvResult(ProcedureType, length));
-	envmap.emplace("append", EnvResult(ProcedureType, append));
-	envmap.emplace("join", EnvResult(ProcedureType, join));
-	envmap.emplace("range", EnvResult(ProcedureType, range));
+	procedures[symbol("list")] = list;
+	procedures[symbol("first")] = first;
+	procedures[symbol("rest")] = rest;
+	procedures[symbol("length")] = length;
+	procedures[symbol("append")] = append;
+	procedures[symbol("join")] = join;
+	procedures[symbol("range")] = range;
+
+	// graphic primitives
+	procedures[symbol("make-point")] = make_point;
+	procedures[symbol("make-line")] = make_line;
+	procedures[symbol("make-text")] = make_text;
 	
 }
@@ -11,18 +11,26 @@ needed.
 #define ENVIRONMENT_HPP
 
 // system includes
-#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
 
 // module includes
 #include "atom.hpp"
 #include "expression.hpp"
 #include "message_queue.h"
+#include "symbol_map.hpp"
+
+class Closure;
 
 /*! \typedef Procedure
 \brief A Procedure is a C++ function pointer taking a vector of 
        Expressions as arguments and returning an Expression.
+
+The arguments are taken by value so a caller done with them can move them
+in, and a procedure building a list can move them into its result.
 */
-typedef Expression (*Procedure)(const std::vector<Expression> & args);
+typedef Expression (*Procedure)(std::vector<Expression> args);
 
 /*! \class Environment
 \brief A class representing the interpreter environment.
@@ -37,6 +45,21 @@ return you can obtain
 the mapped-to value using get_exp or get_proc.
 
 To add an symbol to expression mapping use the add_exp member function.
+
+Each frame keeps its definitions in an open-addressing SymbolMap keyed by
+interned symbol, so a binding holds either an expression or a procedure, never
+room for both.
+
+The built-in definitions and procedures are built once, on first use, into an
+immutable table shared by every top-level environment. A top-level
+environment only records the definitions made in it, which are looked up
+before the built-in ones, so constructing or resetting one copies nothing.
+
+Environments are linked frames. A child frame, as created for each lambda
+call, holds only its own bindings and defers any other lookup to its parent,
+so entering a new scope never copies the enclosing environment. The frame of
+a lambda call keeps the arguments in an array of slots, one per parameter of
+the Closure called.
  */
 class Environment {
 public:
@@ -44,6 +67,40 @@ public:
    * definitions. */
   Environment();
 
+  /*! Construct an empty child frame of an enclosing environment.
+    \param parent the enclosing environment, which must outlive this frame
+   */
+  explicit Environment(const Environment * parent);
+
+  /*! Construct the frame of a call of a closure, with its parameter slots
+    all unbound.
+    \param parent the environment of the caller, which must outlive this frame
+    \param closure the closure called, which must outlive this frame
+   */
+  Environment(const Environment * parent, const Closure & closure);
+
+  /*! Bind the next parameter slot of a call frame, in parameter order.
+    \param exp the value of the argument
+    \throws SemanticError if the parameter is not a symbol
+   */
+  void bind_param(Expression &&exp);
+
+  /// the enclosing environment, or nullptr for the top-level environment
+  const Environment * parent() const noexcept { return m_parent; }
+
+  /*! Enclose this frame in another environment.
+    \param parent the new enclosing environment, which must outlive this frame
+   */
+  void set_parent(const Environment * parent) noexcept { m_parent = parent; }
+
+  /*! Determine if this frame binds every symbol bound by another frame
+    itself (not by its parents), so that no lookup through this frame can
+    reach the bindings of the other.
+    \param other the frame to test
+    \return true if every binding of other is hidden
+   */
+  bool hides(const Environment &other) const;
+
   /*! Determine if a symbol is known to the environment.
     \param sym the sumbol to lookup
     \return true if the symbol has been defined in the environment
@@ -63,12 +120,40 @@ public:
   */
   Expression get_exp(const Atom &sym) const;
 
+  /*! Find the Expression the argument symbol maps to without copying it.
+    \param sym the symbol to lookup
+    \return a pointer to the mapped expression, valid until the binding
+    changes, or nullptr if sym is not defined as an expression
+  */
+  const Expression * find_exp(const Atom &sym) const;
+
+  /*! Find the closure of the lambda the argument symbol maps to. It is
+    built with the binding, so looking it up only reads the environment.
+    \param sym the symbol to lookup
+    \return the closure, or nullptr if sym is not defined as a lambda
+  */
+  std::shared_ptr<const Closure> find_closure(const Atom &sym) const;
+
   /*! Add a mapping from sym argument to the exp argument within the environment.
     \param sym the symbol to add
     \param exp the expression the symbol should map to
    */
   void add_exp(const Atom &sym, const Expression &exp);
 
+  /*! Add a mapping from sym argument to the exp argument within the
+    environment, taking over exp.
+    \param sym the symbol to add
+    \param exp the expression the symbol should map to
+   */
+  void add_exp(const Atom &sym, Expression &&exp);
+
+  /*! Add the definitions made in the frame of another environment, not
+    those of its parents or its defaults, replacing any of the same name.
+    The closures already built for them are shared.
+    \param other the environment to copy the definitions of
+   */
+  void add_all(const Environment &other);
+
   /*! Determine if a symbol has been defined as a procedure
     \param sym the symbol to lookup
     \return true if thr symbol maps to a procedure
@@ -84,31 +169,58 @@ public:
   */
   Procedure get_proc(const Atom &sym) const;
 
+  /*! Determine if a symbol names a built-in procedure, as it does in a
+    default environment, without constructing one.
+    \param sym the symbol to lookup
+    \return true if sym maps to a procedure in the default environment
+   */
+  static bool is_builtin_proc(const Atom &sym);
+
   bool is_list(const std::vector<Expression> & exp) const;
 
-  /*! Reset the environment to its default state. */
+  /*! Reset the environment to its default state. A child frame is reset
+    to an empty frame. */
   void reset();
 
   //void add_MessageQueue(MessageQueue<std::string> *msg);
 
 private:
-  
-  // Environment is a mapping from symbols to expressions or procedures
-  enum EnvResultType { ExpressionType, ProcedureType };
 
+  // the binding of a symbol to an expression
   struct EnvResult {
-    EnvResultType type;
-    Expression exp; // used when type is ExpressionType
-    Procedure proc; // used when type is ProcedureType
-
-    // constructors for use in container emplace
-    EnvResult(){};
-    EnvResult(EnvResultType t, Expression e) : type(t), exp(e){};
-    EnvResult(EnvResultType t, Procedure p) : type(t), proc(p){};
+    Expression exp;
+
+    // the closure of a lambda exp
+    std::shared_ptr<const Closure> closure;
+
+    EnvResult() {}
+    explicit EnvResult(Expression && e);
   };
 
-  // the environment map
-  std::map<std::string, EnvResult> envmap;
+  // the built-in definitions and procedures
+  struct Defaults;
+
+  // the shared defaults, built on the first call
+  static const Defaults & defaults();
+
+  // the expressions defined in this frame, keyed by interned symbol
+  SymbolMap<EnvResult> envmap;
+
+  // the defaults, in the top-level environment only; a symbol defined as an
+  // expression anywhere along the chain hides its procedure
+  const Defaults * m_defaults;
+
+  // the enclosing frame, or nullptr for the top-level environment
+  const Environment * m_parent;
+
+  // the closure of a call frame and the values of its bound parameters
+  const Closure * m_closure;
+  std::vector<EnvResult> m_slots;
+
+  // find the binding for sym in this frame or the nearest enclosing one;
+  // if there is none and proc is given, set *proc to the procedure sym
+  // names, if any
+  const EnvResult * find(const Atom & sym, Procedure * proc = nullptr) const;
 };
 
 #endif
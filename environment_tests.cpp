@@ -1,7 +1,9 @@
 #include "catch.hpp"
 
+#include "closure.hpp"
 #include "environment.hpp"
 #include "semantic_error.hpp"
+#include "symbol_map.hpp"
 
 #include <cmath>
 
@@ -310,6 +312,179 @@ TEST_CASE( "Test reset", "[environment]" ) {
   REQUIRE(env.get_exp(Atom("hi")) == Expression());
 }
 
+TEST_CASE( "Test default environments share the built-ins", "[environment]" ) {
+  Environment first, second;
+  const Expression pi(std::atan2(0, -1));
+
+  // a definition in one environment hides the default in that one only
+  first.add_exp(Atom("pi"), Expression(3.0));
+  REQUIRE(first.get_exp(Atom("pi")) == Expression(3.0));
+  REQUIRE(second.get_exp(Atom("pi")) == pi);
+  REQUIRE(Environment().get_exp(Atom("pi")) == pi);
+
+  first.reset();
+  REQUIRE(first.get_exp(Atom("pi")) == pi);
+  REQUIRE(first.is_proc(Atom("+")));
+
+  // copies keep the defaults and their own definitions
+  first.add_exp(Atom("one"), Expression(1.0));
+  Environment copy(first);
+  REQUIRE(copy.get_exp(Atom("one")) == Expression(1.0));
+  REQUIRE(copy.get_exp(Atom("e")) == Expression(std::exp(1)));
+  REQUIRE(copy.is_proc(Atom("range")));
+
+  REQUIRE(Environment::is_builtin_proc(Atom("+")));
+  REQUIRE(Environment::is_builtin_proc(Atom("range")));
+  REQUIRE(!Environment::is_builtin_proc(Atom("pi")));
+  REQUIRE(!Environment::is_builtin_proc(Atom("one")));
+  REQUIRE(!Environment::is_builtin_proc(Atom(1.0)));
+}
+
+TEST_CASE( "Test child frame", "[environment]" ) {
+  Environment env;
+  env.add_exp(Atom("one"), Expression(1.0));
+
+  Environment frame(&env);
+  REQUIRE(frame.is_exp(Atom("one")));
+  REQUIRE(frame.is_proc(Atom("+")));
+  REQUIRE(frame.get_exp(Atom("pi")) == Expression(std::atan2(0, -1)));
+
+  // bindings in the frame shadow the parent and do not leak into it
+  frame.add_exp(Atom("one"), Expression(2.0));
+  frame.add_exp(Atom("two"), Expression(2.0));
+  REQUIRE(frame.get_exp(Atom("one")) == Expression(2.0));
+  REQUIRE(env.get_exp(Atom("one")) == Expression(1.0));
+  REQUIRE(!env.is_known(Atom("two")));
+
+  frame.reset();
+  REQUIRE(!frame.is_known(Atom("two")));
+  REQUIRE(frame.get_exp(Atom("one")) == Expression(1.0));
+}
+
+TEST_CASE( "Test closure frame", "[environment]" ) {
+  Environment env;
+  env.add_exp(Atom("y"), Expression(5.0));
+
+  // the value of (lambda (x y x) (+ x y))
+  Expression params(Atom("list"), {Expression(Atom("x")), Expression(Atom("y")), Expression(Atom("x"))});
+  Expression body(Atom("+"), {Expression(Atom("x")), Expression(Atom("y"))});
+  env.add_exp(Atom("f"), Expression(Atom("lambda"), {params, body}));
+
+  std::shared_ptr<const Closure> closure = env.find_closure(Atom("f"));
+  REQUIRE(closure);
+  REQUIRE(closure->arity() == 3);
+  REQUIRE(closure->body() == body);
+  REQUIRE(env.find_closure(Atom("f")) == closure);
+  REQUIRE(!env.find_closure(Atom("y")));
+  REQUIRE(!env.find_closure(Atom("+")));
+
+  // unbound parameters defer to the parent, a repeated one binds the last
+  Environment frame(&env, *closure);
+  frame.bind_param(Expression(1.0));
+  REQUIRE(frame.get_exp(Atom("x")) == Expression(1.0));
+  REQUIRE(frame.get_exp(Atom("y")) == Expression(5.0));
+  frame.bind_param(Expression(2.0));
+  frame.bind_param(Expression(3.0));
+  REQUIRE(frame.get_exp(Atom("x")) == Expression(3.0));
+  REQUIRE(frame.get_exp(Atom("y")) == Expression(2.0));
+
+  // a definition in the frame rebinds the parameter
+  frame.add_exp(Atom("y"), Expression(7.0));
+  REQUIRE(frame.get_exp(Atom("y")) == Expression(7.0));
+  REQUIRE(env.get_exp(Atom("y")) == Expression(5.0));
+
+  // rebinding the name drops the closure
+  env.add_exp(Atom("f"), Expression(Atom("lambda"), {params, Expression(Atom("x"))}));
+  REQUIRE(env.find_closure(Atom("f")) != closure);
+
+  Expression badParams(Atom("list"), {Expression(Atom("x")), Expression(1.0)});
+  Closure bad(Expression(Atom("lambda"), {badParams, body}));
+  Environment badFrame(&env, bad);
+  badFrame.bind_param(Expression(1.0));
+  REQUIRE_THROWS_AS(badFrame.bind_param(Expression(2.0)), SemanticError);
+}
+
+TEST_CASE( "Test symbol map", "[environment]" ) {
+  SymbolMap<int> map;
+  REQUIRE(map.empty());
+  REQUIRE(map.find(0) == nullptr);
+
+  // enough entries to grow the table and the value blocks many times
+  const SymbolId count = 10000;
+  int * first = map.try_emplace(0, 0).first;
+  for (SymbolId id = 1; id < count; ++id)
+    REQUIRE(map.try_emplace(id, int(id)).second);
+  REQUIRE(map.size() == count);
+  REQUIRE(map.find(0) == first);
+
+  bool found = true;
+  for (SymbolId id = 0; id < count; ++id)
+    found = found && map.find(id) != nullptr && *map.find(id) == int(id);
+  REQUIRE(found);
+  REQUIRE(map.find(count) == nullptr);
+  REQUIRE(map.count(count - 1) == 1);
+
+  // an existing entry is neither replaced nor duplicated
+  auto again = map.try_emplace(7, -1);
+  REQUIRE(!again.second);
+  REQUIRE(*again.first == 7);
+  map[7] = 70;
+  REQUIRE(*map.find(7) == 70);
+  REQUIRE(map.size() == count);
+
+  // entries are visited in insertion order
+  SymbolId next = 0;
+  REQUIRE(map.all_of([&next](const std::pair<SymbolId, int> & entry) {
+    return entry.first == next++;
+  }));
+
+  SymbolMap<int> copy(map);
+  copy[7] = 700;
+  REQUIRE(*copy.find(9999) == 9999);
+  REQUIRE(*map.find(7) == 70);
+
+  map.clear();
+  REQUIRE(map.empty());
+  REQUIRE(map.find(7) == nullptr);
+  REQUIRE(*copy.find(7) == 700);
+}
+
+TEST_CASE( "Test expressions hide procedures", "[environment]" ) {
+  Environment env;
+  REQUIRE(env.is_proc(Atom("+")));
+  REQUIRE(env.is_known(Atom("+")));
+  REQUIRE(!env.is_exp(Atom("+")));
+
+  // a frame binding the name of a procedure hides it, the parent keeps it
+  Environment frame(&env);
+  frame.add_exp(Atom("+"), Expression(1.0));
+  REQUIRE(!frame.is_proc(Atom("+")));
+  REQUIRE(frame.is_exp(Atom("+")));
+  REQUIRE(frame.get_proc(Atom("+"))({}) == Expression());
+  REQUIRE(env.is_proc(Atom("+")));
+}
+
+TEST_CASE( "Test list procedures share structure", "[environment]" ) {
+  Environment env;
+
+  std::vector<Expression> items = {Expression(1.0), Expression(2.0), Expression(3.0)};
+  Expression l = env.get_proc(Atom("list"))(items);
+  env.add_exp(Atom("l"), l);
+
+  Expression rest = env.get_proc(Atom("rest"))({l});
+  REQUIRE(rest.listLength() == 2);
+  REQUIRE(rest.tailId() == &*(l.tailConstBegin() + 1));
+
+  // append to a list still bound elsewhere leaves the bound list alone
+  Expression appended = env.get_proc(Atom("append"))({l, Expression(4.0)});
+  REQUIRE(appended.listLength() == 4);
+  REQUIRE(env.get_exp(Atom("l")).listLength() == 3);
+
+  Expression joined = env.get_proc(Atom("join"))({l, rest});
+  REQUIRE(joined.listLength() == 5);
+  REQUIRE(l.listLength() == 3);
+}
+
 TEST_CASE( "Test semeantic errors", "[environment]" ) {
 
   Environment env;
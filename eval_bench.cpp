@@ -0,0 +1,69 @@
+#include "bench.hpp"
+
+#include <sstream>
+
+#include "interpreter.hpp"
+
+// build an interpreter holding the given number of user definitions
+static void defineSymbols(Interpreter & interp, int count) {
+
+  for (int i = 0; i < count; ++i) {
+    std::istringstream iss("(define sym" + std::to_string(i) + " " + std::to_string(i) + ")");
+    interp.parseStream(iss);
+    interp.evaluate();
+  }
+}
+
+// the cost of evaluating a program should not depend on how many
+// unrelated symbols are already defined
+BENCHMARK_CASE(eval_vs_environment_size) {
+
+  for (int size : {10, 1000, 100000}) {
+    Interpreter interp;
+    interp.useFolding(false);
+    defineSymbols(interp, size);
+
+    std::istringstream def("(define sq (lambda (x) (* x x)))");
+    interp.parseStream(def);
+    interp.evaluate();
+
+    std::istringstream literal("(42)");
+    interp.parseStream(literal);
+    bench.run("literal, " + std::to_string(size) + " bindings", 20000, [&] {
+      doNotOptimize(interp.evaluate());
+    });
+
+    std::istringstream arith("(+ (* 2 3) (- 7 1) (/ 8 2))");
+    interp.parseStream(arith);
+    bench.run("arithmetic, " + std::to_string(size) + " bindings", 20000, [&] {
+      doNotOptimize(interp.evaluate());
+    });
+
+    std::istringstream call("(sq 12)");
+    interp.parseStream(call);
+    bench.run("lambda call, " + std::to_string(size) + " bindings", 20000, [&] {
+      doNotOptimize(interp.evaluate());
+    });
+  }
+}
+
+// a lambda with constant subtrees mapped over a list, with and without
+// constant folding
+BENCHMARK_CASE(fold_constants_in_map) {
+
+  std::string program = "(begin (define f (lambda (x) (+ (* x (/ 1 3)) (* 2 (sqrt 2)) (^ x 2))))"
+    " (map f (range 0 10000 1)))";
+
+  for (bool folding : {false, true}) {
+    Interpreter interp;
+    interp.useFolding(folding);
+    std::istringstream iss(program);
+    interp.parseStream(iss);
+
+    std::string label = folding ? "folded" : "unfolded";
+    bench.run("map 10k, " + label, 20, [&] {
+      doNotOptimize(interp.evaluate());
+    });
+    bench.report("nodes folded, " + label, interp.foldedNodes(), "nodes");
+  }
+}
@@ -0,0 +1,179 @@
+#include "evaluator.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "semantic_error.hpp"
+
+Expression StackEvaluator::run(const Expression & exp, Environment & env) {
+
+  m_peakFrames = 0;
+
+  try {
+    evaluate(exp, env);
+    while (!m_stack.empty())
+      resume();
+  }
+  catch (...) {
+    m_stack.clear();
+    m_values.clear();
+    m_frames.clear();
+    throw;
+  }
+
+  Expression result = std::move(m_values.back());
+  m_values.clear();
+  return result;
+}
+
+void StackEvaluator::evaluate(const Expression & exp, Environment & env) {
+
+  // leaves and the special forms not run here are evaluated whole
+  if (exp.isListEmpty() && exp.head().symbolId() != Symbols::List) {
+    const Expression * value = env.find_exp(exp.head());
+    m_values.push_back(value != nullptr ? *value : exp.eval(env));
+    return;
+  }
+
+  switch (exp.head().symbolId()) {
+  case Symbols::Begin:
+    m_stack.push_back(Continuation{Begin, &exp, &env, 0, 0});
+    return;
+  case Symbols::Define: {
+    // a malformed define fails before evaluating anything, as in eval
+    const Expression & target = *exp.tailConstBegin();
+    SymbolId id = target.head().symbolId();
+    if (exp.listLength() != 2 || !target.isHeadSymbol() || id == Symbols::Define
+      || id == Symbols::Begin || env.is_proc(target.head()))
+      break;
+    m_stack.push_back(Continuation{Define, &exp, &env, 0, 0});
+    return;
+  }
+  case Symbols::Lambda:
+  case Symbols::Apply:
+  case Symbols::Map:
+  case Symbols::ParallelMap:
+  case Symbols::SetProperty:
+  case Symbols::GetProperty:
+  case Symbols::DiscretePlot:
+  case Symbols::ContinuousPlot:
+    break;
+  default: {
+    std::shared_ptr<const Closure> closure = env.find_closure(exp.head());
+    if (!closure) {
+      m_stack.push_back(Continuation{CallProcedure, &exp, &env, 0, m_values.size()});
+      return;
+    }
+
+    if (static_cast<std::size_t>(exp.listLength()) > closure->arity())
+      throw SemanticError("Error in call to lambda: invalid number of arguments");
+
+    // the frame binds each argument as soon as it is evaluated
+    Frame frame;
+    frame.env.reset(new Environment(&env, *closure));
+    frame.closure = std::move(closure);
+    m_frames.push_back(std::move(frame));
+    m_stack.push_back(Continuation{CallLambda, &exp, &env, 0, m_frames.size() - 1});
+    return;
+  }
+  }
+
+  m_values.push_back(exp.eval(env));
+}
+
+void StackEvaluator::resume() {
+
+  Continuation & k = m_stack.back();
+  const std::size_t length = k.exp != nullptr ? k.exp->listLength() : 0;
+
+  switch (k.kind) {
+  case CallProcedure:
+    if (k.next < length) {
+      evaluate(*(k.exp->tailConstBegin() + k.next++), *k.env);
+      return;
+    }
+    else {
+      std::vector<Expression> args(std::make_move_iterator(m_values.begin() + k.base),
+        std::make_move_iterator(m_values.end()));
+      m_values.resize(k.base);
+      const Expression & exp = *k.exp;
+      const Environment & env = *k.env;
+      m_stack.pop_back();
+      m_values.push_back(apply(exp.head(), std::move(args), env));
+      return;
+    }
+
+  case CallLambda:
+    if (k.next > 0) {
+      m_frames[k.base].env->bind_param(std::move(m_values.back()));
+      m_values.pop_back();
+    }
+    if (k.next < length) {
+      evaluate(*(k.exp->tailConstBegin() + k.next++), *k.env);
+      return;
+    }
+    enter();
+    return;
+
+  case Begin:
+    // only the value of the last expression is kept
+    if (k.next > 0)
+      m_values.pop_back();
+    if (k.next + 1 < length) {
+      evaluate(*(k.exp->tailConstBegin() + k.next++), *k.env);
+      return;
+    }
+    else {
+      const Expression & last = *(k.exp->tailConstBegin() + k.next);
+      Environment & env = *k.env;
+      m_stack.pop_back();
+      evaluate(last, env);
+      return;
+    }
+
+  case Define:
+    if (k.next == 0) {
+      k.next = 1;
+      evaluate(*(k.exp->tailConstBegin() + 1), *k.env);
+      return;
+    }
+    else {
+      if (k.env->is_exp(k.exp->head()))
+        throw SemanticError("Error during evaluation: attempt to redefine a previously defined symbol");
+      k.env->add_exp(k.exp->tailConstBegin()->head(), m_values.back());
+      m_stack.pop_back();
+      return;
+    }
+
+  case Return:
+    m_frames.erase(m_frames.begin() + k.base, m_frames.end());
+    m_stack.pop_back();
+    return;
+  }
+}
+
+void StackEvaluator::enter() {
+
+  m_stack.pop_back();
+
+  Environment & frame = *m_frames.back().env;
+  const Expression & body = m_frames.back().closure->body();
+
+  // a call in tail position of a body continues in the place of the body;
+  // its caller's frame can go if nothing can be looked up in it any more
+  if (!m_stack.empty() && m_stack.back().kind == Return
+    && frame.parent() == m_frames[m_frames.size() - 2].env.get()) {
+    Environment & caller = *m_frames[m_frames.size() - 2].env;
+    if (frame.hides(caller)) {
+      frame.set_parent(caller.parent());
+      m_frames.erase(m_frames.end() - 2);
+    }
+  }
+  else {
+    m_stack.push_back(Continuation{Return, nullptr, nullptr, 0, m_frames.size() - 1});
+  }
+
+  m_peakFrames = std::max(m_peakFrames, m_frames.size());
+  evaluate(body, frame);
+}
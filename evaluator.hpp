@@ -0,0 +1,100 @@
+/*! \file evaluator.hpp
+Defines an evaluator of Expression trees keeping its continuations on the
+heap instead of the C++ stack.
+ */
+#ifndef EVALUATOR_HPP
+#define EVALUATOR_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "closure.hpp"
+#include "environment.hpp"
+#include "expression.hpp"
+
+/*! \class StackEvaluator
+\brief An evaluator producing the same results as Expression::eval, whose
+nesting depth is limited only by memory.
+
+Where Expression::eval recurses into each subexpression, StackEvaluator
+pushes a continuation recording what is left to do with the expression on
+an explicit stack, and keeps the values computed so far on a second one.
+Calls of procedures and lambdas, begin and define run this way; the other
+special forms are handed to Expression::eval whole.
+
+The last expression of a begin and the body of a lambda are evaluated in
+tail position: they replace the continuation of their enclosing form
+instead of nesting in it. A call in tail position of a lambda body reuses
+the continuation of that body, so a chain of tail calls runs in constant
+stack space. Lambdas are dynamically scoped, so the frame of the caller
+stays visible to the callee and is kept, unless every binding in it is
+hidden by a parameter of the callee, in which case it is released.
+ */
+class StackEvaluator {
+public:
+
+  StackEvaluator() = default;
+
+  /// a copy starts with empty stacks, which only hold the state of a run
+  StackEvaluator(const StackEvaluator & other) noexcept
+    : m_peakFrames(other.m_peakFrames) {}
+
+  /// the stacks are left as they are, empty between runs
+  StackEvaluator & operator=(const StackEvaluator & other) noexcept {
+    m_peakFrames = other.m_peakFrames;
+    return *this;
+  }
+
+  /*! Evaluate an expression.
+    \param exp the expression
+    \param env the environment to look symbols up and define them in
+    \return the value of exp
+    \throws SemanticError when a semantic error is encountered
+   */
+  Expression run(const Expression & exp, Environment & env);
+
+  /// the largest number of lambda call frames alive at once in the last run
+  std::size_t peakFrames() const noexcept { return m_peakFrames; }
+
+private:
+
+  // what remains to be done with an expression
+  enum Kind {
+    CallProcedure, // evaluate the arguments then apply the procedure
+    CallLambda,    // evaluate the arguments into the frame then the body
+    Begin,         // evaluate each expression, keeping the last value
+    Define,        // evaluate the value then bind it
+    Return         // the body of the call owning frames [base, end) is done
+  };
+
+  struct Continuation {
+    Kind kind;
+    const Expression * exp;
+    Environment * env;
+    std::size_t next;   // the next argument to evaluate
+    std::size_t base;   // its first value, or its frame for CallLambda and Return
+  };
+
+  // the frame of an active lambda call and the closure it binds
+  struct Frame {
+    std::shared_ptr<const Closure> closure;
+    std::unique_ptr<Environment> env;
+  };
+
+  std::vector<Continuation> m_stack;
+  std::vector<Expression> m_values;
+  std::vector<Frame> m_frames;
+  std::size_t m_peakFrames = 0;
+
+  // start evaluating exp in env, pushing its value or its continuation
+  void evaluate(const Expression & exp, Environment & env);
+
+  // continue the continuation on top of the stack
+  void resume();
+
+  // enter the body of the lambda call on top of the stack
+  void enter();
+};
+
+#endif
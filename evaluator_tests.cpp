@@ -0,0 +1,150 @@
+#include "catch.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "evaluator.hpp"
+#include "interpreter.hpp"
+#include "parse.hpp"
+#include "semantic_error.hpp"
+#include "token.hpp"
+
+// the value of a program, or the message of the error it throws
+static std::string outcome(Interpreter & interp, const std::string & program) {
+
+  std::istringstream iss(program);
+  REQUIRE(interp.parseStream(iss));
+
+  std::ostringstream out;
+  try {
+    out << interp.evaluate();
+  }
+  catch (const SemanticError & ex) {
+    out << "error: " << ex.what();
+  }
+  return out.str();
+}
+
+// a call of op nested depth times around the innermost expression
+static std::string nest(const std::string & op, const std::string & innermost, int depth) {
+
+  std::string program;
+  for (int i = 0; i < depth; ++i)
+    program += "(" + op + " ";
+  program += innermost;
+  program += std::string(depth, ')');
+  return program;
+}
+
+TEST_CASE("Test stack evaluator agrees with the tree walker", "[evaluator]") {
+
+  std::vector<std::string> programs = {
+    "(+ 1 2 (* 3 4) (- 5))",
+    "(begin (define a 2) (define b (* a 3)) (list a b (list)))",
+    "(begin)",
+    "(begin 1 undefined 2)",
+    "(define 1 2)",
+    "(define + 2)",
+    "(define begin 2)",
+    "(define c)",
+    "(1 2 3)",
+    "(a 1)",
+    "(define f (lambda (x y) (begin (define z (+ x y)) (* z z))))",
+    "(f 1 2)",
+    "(f 1 2 3)",
+    "(begin (define y 10) (f 1))",
+    "(define g (lambda (x) (h 0)))",
+    "(define h (lambda (y) x))",
+    "(g 5)",
+    "(define k (lambda (x 1) x))",
+    "(k 1 (define side 1))",
+    "(begin side)",
+    "(define r (lambda (define) (begin (define q 1) q)))",
+    "(r 1)",
+    "(map f (list 1 2 3))",
+    "(apply + (list (f 1 1) 2))",
+    "(get-property \"a\" (set-property \"a\" (f 2 2) 0))",
+    "(f (define f 3) 1)",
+    "(begin f)",
+  };
+
+  Interpreter tree, stack;
+  stack.setMode(Interpreter::StackMode);
+
+  for (auto & program : programs) {
+    INFO(program);
+    REQUIRE(outcome(stack, program) == outcome(tree, program));
+  }
+}
+
+TEST_CASE("Test stack evaluator depth", "[evaluator]") {
+
+  Interpreter interp;
+  interp.setMode(Interpreter::StackMode);
+
+  {
+    INFO("nested procedure calls");
+    REQUIRE(outcome(interp, nest("+ 1", "0", 100000)) == "(100000)");
+  }
+
+  {
+    INFO("nested lambda calls");
+    REQUIRE(outcome(interp, "(define inc (lambda (x) (+ x 1)))") != "");
+    REQUIRE(outcome(interp, nest("inc", "0", 100000)) == "(100000)");
+  }
+
+  {
+    INFO("nested begins");
+    REQUIRE(outcome(interp, nest("begin 1", "2", 100000)) == "(2)");
+  }
+}
+
+TEST_CASE("Test stack evaluator tail calls", "[evaluator]") {
+
+  Environment env;
+  StackEvaluator evaluator;
+
+  auto run = [&](const std::string & program) {
+    Tokenizer tokens(program);
+    return evaluator.run(parse(tokens), env);
+  };
+
+  {
+    INFO("a chain of tail calls runs in one frame");
+    const int length = 100000;
+    std::ostringstream program;
+    program << "(begin";
+    for (int i = 0; i < length; ++i)
+      program << " (define f" << i << " (lambda (x) (f" << i + 1 << " (+ x 1))))";
+    program << " (define f" << length << " (lambda (x) x)))";
+    run(program.str());
+
+    REQUIRE(run("(f0 0)") == Expression(double(length)));
+    REQUIRE(evaluator.peakFrames() == 1);
+  }
+
+  {
+    INFO("a frame the callee can still see is kept");
+    run("(define g (lambda (x) (h 0)))");
+    run("(define h (lambda (y) x))");
+    REQUIRE(run("(g 5)") == Expression(5.));
+    REQUIRE(evaluator.peakFrames() == 2);
+  }
+
+  {
+    INFO("calls that are not in tail position nest");
+    run("(define inc (lambda (x) (+ x 1)))");
+    REQUIRE(run("(inc (inc (inc 0)))") == Expression(3.));
+    REQUIRE(evaluator.peakFrames() == 3);
+    run("(define twice (lambda (x) (+ (inc x) (inc x))))");
+    REQUIRE(run("(twice 1)") == Expression(4.));
+    REQUIRE(evaluator.peakFrames() == 2);
+  }
+
+  {
+    INFO("errors leave the evaluator ready for the next run");
+    REQUIRE_THROWS_AS(run("(f0 (inc undefined))"), SemanticError);
+    REQUIRE(run("(inc 1)") == Expression(2.));
+  }
+}
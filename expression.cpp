@@ -1,47 +1,71 @@
 #include "expression.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <functional>
 #include <sstream>
 #include <list>
+#include <map>
+#include <mutex>
 
+#include "arena.hpp"
+#include "closure.hpp"
+#include "curve_sampler.hpp"
 #include "environment.hpp"
 #include "semantic_error.hpp"
+#include "thread_pool.hpp"
+#include "vector_math.hpp"
 #include <limits>
+#include <utility>
 
 Expression::Expression() {}
 
-Expression::Expression(const Atom & a) {
+Expression::Expression(const Atom & a): m_head(a) {}
 
-	m_head = a;
-}
+Expression::Expression(Atom && a): m_head(std::move(a)) {}
 
+Expression::Expression(const Atom & a, std::vector<Expression> tail):
+	m_head(a), m_tail(std::move(tail)) {}
 
-// recursive copy
-Expression::Expression(const Expression & a) {
+Expression::Expression(const Atom & a, Tail tail):
+	m_head(a), m_tail(std::move(tail)) {}
 
-	m_head = a.m_head;
-	for (auto e : a.m_tail) {
-		m_tail.push_back(e);
-	}
-	m_property.clear();
-	m_property = a.m_property;
-}
+// shallow copy, the tail and properties are shared
+Expression::Expression(const Expression & a):
+	m_head(a.m_head), m_tail(a.m_tail), m_property(a.m_property) {}
+
+Expression::Expression(Expression && a) noexcept:
+	m_head(std::move(a.m_head)), m_tail(std::move(a.m_tail)),
+	m_property(std::move(a.m_property)) {}
+
+// the tail releases its subtrees
+Expression::~Expression() {}
 
 Expression & Expression::operator=(const Expression & a) {
 
 	// prevent self-assignment
 	if (this != &a) {
 		m_head = a.m_head;
-		m_tail.clear();
-		for (auto e : a.m_tail) {
-			m_tail.push_back(e);
-		}
-		m_property.clear();
+		m_tail = a.m_tail;
 		m_property = a.m_property;
 	}
 
 	return *this;
 }
 
+Expression & Expression::operator=(Expression && a) noexcept {
+
+	if (this != &a) {
+		m_head = std::move(a.m_head);
+		m_tail = std::move(a.m_tail);
+		m_property = std::move(a.m_property);
+	}
+
+	return *this;
+}
+
 
 Atom & Expression::head() {
 	return m_head;
@@ -61,11 +85,23 @@ bool Expression::isHeadSymbol() const noexcept {
 
 
 void Expression::append(const Atom & a) {
-	m_tail.emplace_back(a);
+	m_tail.push_back(Expression(a));
+}
+
+void Expression::append(Atom && a) {
+	m_tail.push_back(Expression(std::move(a)));
 }
 
 void Expression::addToTail(const Expression & a) {
-	m_tail.emplace_back(a);
+	m_tail.push_back(a);
+}
+
+void Expression::addToTail(Expression && a) {
+	m_tail.push_back(std::move(a));
+}
+
+void Expression::reserveTail(std::size_t n) {
+	m_tail.reserve(n);
 }
 
 bool Expression::isListEmpty() const noexcept {
@@ -87,15 +123,690 @@ Expression * Expression::tail() {
 	return ptr;
 }
 
-Expression::ConstIteratorType Expression::tailConstBegin() const noexcept {
-	return m_tail.cbegin();
+Expression::ConstIteratorType Expression::tailConstBegin() const {
+	return m_tail.begin();
+}
+
+Expression::ConstIteratorType Expression::tailConstEnd() const {
+	return m_tail.end();
+}
+
+Expression::Packing Expression::tailPacking() const noexcept {
+	return m_tail.packing();
+}
+
+const double * Expression::packedTail() const noexcept {
+	return m_tail.numbers();
+}
+
+const Graphics * Expression::graphics() const noexcept {
+	return m_tail.graphics();
+}
+
+Expression Expression::listElement(std::size_t i) const {
+	return m_tail.at(i);
+}
+
+Expression Expression::tailList(std::size_t first) const {
+	return Expression(Atom::fromSymbolId(Symbols::List), m_tail.dropFirst(first));
+}
+
+const void * Expression::tailId() const {
+	return m_tail.id();
+}
+
+/***********************************************************************
+Properties
+**********************************************************************/
+
+namespace {
+
+// the names of the numeric graphic properties, in GraphicProperty order
+const char * const GRAPHIC_PROPERTIES[Expression::NumGraphicProperties] = {
+	"size", "thickness", "text-scale", "text-rotation"
+};
+
+// the names of the graphic primitives, in ObjectName order
+const char * const OBJECT_NAMES[] = { "", "point", "line", "text", "label" };
+
+// a well-known property: a GraphicProperty, or one of these
+const int OBJECT_NAME = Expression::NumGraphicProperties;
+const int NOT_WELL_KNOWN = -1;
+
+// the well-known property tag names, or NOT_WELL_KNOWN; the names all
+// differ in length, so at most one is compared
+int wellKnown(const std::string & tag) {
+
+	int known;
+	switch (tag.size()) {
+	case 4: known = Expression::SizeProperty; break;
+	case 9: known = Expression::ThicknessProperty; break;
+	case 10: known = Expression::TextScaleProperty; break;
+	case 13: known = Expression::TextRotationProperty; break;
+	case 11: return tag.compare("object-name") == 0 ? OBJECT_NAME : NOT_WELL_KNOWN;
+	default: return NOT_WELL_KNOWN;
+	}
+	return tag.compare(GRAPHIC_PROPERTIES[known]) == 0 ? known : NOT_WELL_KNOWN;
+}
+
+// the interned name of a property, known is wellKnown(tag)
+SymbolId propertyKey(const std::string & tag, int known) {
+
+	static const std::vector<SymbolId> keys = [] {
+		std::vector<SymbolId> ids;
+		for (auto name : GRAPHIC_PROPERTIES)
+			ids.push_back(SymbolTable::getInstance().intern(name));
+		ids.push_back(SymbolTable::getInstance().intern("object-name"));
+		return ids;
+	}();
+
+	return known == NOT_WELL_KNOWN ? SymbolTable::getInstance().intern(tag) : keys[known];
+}
+
+// true if exp is only an atom, without tail or properties
+bool isPlainAtom(const Expression & exp) {
+	return exp.isListEmpty() && !exp.hasProperties();
+}
+
+} // namespace
+
+struct Expression::PropertyTable {
+
+	// a property keyed by its interned name; the name is kept to find it
+	// by tag without interning the tag
+	struct Entry {
+		SymbolId key;
+		const std::string * name;
+		Expression value;
+
+		Entry(SymbolId k, Expression && v):
+			key(k), name(&SymbolTable::getInstance().name(k)), value(std::move(v)) {}
+	};
+
+	typedef std::vector<Entry, ArenaAllocator<Entry> > Others;
+
+	std::atomic<unsigned> refs;
+
+	// the ObjectName of the object-name property, if not among the others
+	unsigned char objectName;
+
+	// bit p is set when GraphicProperty p is held in number[p]
+	unsigned char numbers;
+
+	double number[NumGraphicProperties];
+
+	// every other property, including well-known ones set to values that
+	// do not fit their fields
+	Others others;
+
+	// the allocator of the table, which keeps its arena alive
+	ArenaAllocator<PropertyTable> allocator;
+
+	explicit PropertyTable(const ArenaAllocator<PropertyTable> & alloc):
+		refs(1), objectName(NoObject), numbers(0), others(Others::allocator_type(alloc)),
+		allocator(alloc) {}
+
+	PropertyTable(const PropertyTable & other, const ArenaAllocator<PropertyTable> & alloc):
+		refs(1), objectName(other.objectName), numbers(other.numbers),
+		others(other.others.begin(), other.others.end(), Others::allocator_type(alloc)),
+		allocator(alloc) {
+		std::memcpy(number, other.number, sizeof(number));
+	}
+
+	bool empty() const noexcept {
+		return objectName == NoObject && numbers == 0 && others.empty();
+	}
+
+	const Expression * find(const std::string & tag) const noexcept {
+		for (auto & p : others) {
+			if (*p.name == tag)
+				return &p.value;
+		}
+		return nullptr;
+	}
+
+	void erase(SymbolId key) {
+		for (auto p = others.begin(); p != others.end(); ++p) {
+			if (p->key == key) {
+				others.erase(p);
+				return;
+			}
+		}
+	}
+
+	// a new table on allocator, copying other if not nullptr
+	static PropertyTable * make(ArenaAllocator<PropertyTable> alloc, const PropertyTable * other) {
+		PropertyTable * table = alloc.allocate(1);
+		try {
+			if (other != nullptr)
+				new (table) PropertyTable(*other, alloc);
+			else
+				new (table) PropertyTable(alloc);
+		}
+		catch (...) {
+			alloc.deallocate(table, 1);
+			throw;
+		}
+		return table;
+	}
+};
+
+Expression::Properties & Expression::Properties::operator=(const Properties & other) noexcept {
+	if (other.m_table != nullptr)
+		other.retain();
+	if (m_table != nullptr)
+		release();
+	m_table = other.m_table;
+	return *this;
+}
+
+Expression::Properties & Expression::Properties::operator=(Properties && other) noexcept {
+	if (this != &other) {
+		if (m_table != nullptr)
+			release();
+		m_table = other.m_table;
+		other.m_table = nullptr;
+	}
+	return *this;
+}
+
+void Expression::Properties::retain() const noexcept {
+	m_table->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Expression::Properties::release() noexcept {
+	if (m_table->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		ArenaAllocator<PropertyTable> alloc(std::move(m_table->allocator));
+		m_table->~PropertyTable();
+		alloc.deallocate(m_table, 1);
+	}
+	m_table = nullptr;
+}
+
+Expression::PropertyTable & Expression::Properties::unshared() {
+	if (m_table == nullptr)
+		m_table = PropertyTable::make(ArenaAllocator<PropertyTable>(), nullptr);
+	else if (m_table->refs.load(std::memory_order_acquire) > 1) {
+		PropertyTable * copy = PropertyTable::make(ArenaAllocator<PropertyTable>(), m_table);
+		release();
+		m_table = copy;
+	}
+	return *m_table;
+}
+
+void Expression::Properties::moveToHeap() {
+	if (m_table == nullptr || !m_table->allocator.arena())
+		return;
+
+	PropertyTable * copy = PropertyTable::make(ArenaAllocator<PropertyTable>(nullptr), m_table);
+	for (auto & p : copy->others)
+		p.value = p.value.heapCopy();
+	release();
+	m_table = copy;
+}
+
+bool Expression::hasProperties() const noexcept {
+	return m_property.get() != nullptr && !m_property.get()->empty();
+}
+
+Expression::ObjectName Expression::objectName() const noexcept {
+	const PropertyTable * table = m_property.get();
+	return table != nullptr ? static_cast<ObjectName>(table->objectName) : NoObject;
+}
+
+bool Expression::graphicProperty(GraphicProperty property, double & value) const noexcept {
+	const PropertyTable * table = m_property.get();
+	if (table == nullptr || (table->numbers & (1u << property)) == 0)
+		return false;
+	value = table->number[property];
+	return true;
+}
+
+bool Expression::hasProperty(const std::string & tag) const {
+
+	const PropertyTable * table = m_property.get();
+	if (table == nullptr)
+		return false;
+
+	int known = wellKnown(tag);
+	if (known == OBJECT_NAME && table->objectName != NoObject)
+		return true;
+	if (known >= 0 && known < NumGraphicProperties && (table->numbers & (1u << known)))
+		return true;
+	return table->find(tag) != nullptr;
+}
+
+Expression Expression::property(const std::string & tag) const {
+
+	const PropertyTable * table = m_property.get();
+	if (table == nullptr)
+		return Expression();
+
+	int known = wellKnown(tag);
+	if (known == OBJECT_NAME && table->objectName != NoObject) {
+		static const std::vector<Expression> names = [] {
+			std::vector<Expression> literals;
+			for (auto name : OBJECT_NAMES) {
+				Atom literal(name);
+				literal.setStringLiteral();
+				literals.emplace_back(std::move(literal));
+			}
+			return literals;
+		}();
+		return names[table->objectName];
+	}
+	if (known >= 0 && known < NumGraphicProperties && (table->numbers & (1u << known)))
+		return Expression(table->number[known]);
+
+	const Expression * value = table->find(tag);
+	return value != nullptr ? *value : Expression();
+}
+
+
+Expression Expression::heapCopy() const {
+
+	Expression result(m_head);
+	result.m_tail = m_tail.heapCopy();
+
+	result.m_property = m_property;
+	result.m_property.moveToHeap();
+
+	return result;
+}
+
+// the storage of every empty tail
+static const Expression::ConstIteratorType emptyTail() {
+	static const std::vector<Expression, ArenaAllocator<Expression> > empty(ArenaAllocator<Expression>(nullptr));
+	return empty.cbegin();
+}
+
+// how exp would be held in a packed tail, Unpacked if it cannot be
+static Expression::Packing elementPacking(const Expression & exp) noexcept {
+
+	if (!exp.isListEmpty() || exp.hasProperties())
+		return Expression::Unpacked;
+	if (exp.head().isNumber())
+		return Expression::PackedReal;
+	if (exp.head().isComplexNumber())
+		return Expression::PackedComplex;
+	return Expression::Unpacked;
+}
+
+// primitive i of a graphics buffer, as make-point, make-line or make-text
+// would build it
+static Expression graphicElement(const Graphics & graphics, std::size_t i);
+
+struct Expression::TailBlock {
+
+	std::atomic<unsigned> refs;
+
+	// the elements; those of a packed block are unpacked from its numbers
+	// on first use
+	TailVector items;
+
+	// the numbers of a packed block, stride() per element
+	Numbers numbers;
+	Packing packing;
+
+	// the primitives of a block packed as graphics
+	std::shared_ptr<const Graphics> graphics;
+
+	std::once_flag unpack;
+	bool unpacked;
+
+	TailBlock(TailVector && elements, Numbers && packed, Packing how):
+		refs(1), items(std::move(elements)), numbers(std::move(packed)), packing(how),
+		unpacked(false) {}
+
+	std::size_t stride() const noexcept {
+		return packing == PackedComplex ? 2 : 1;
+	}
+
+	std::size_t size() const noexcept {
+		if (packing == PackedGraphics)
+			return graphics->size();
+		return packing == Unpacked ? items.size() : numbers.size() / stride();
+	}
+
+	// element i of a packed block
+	Expression element(std::size_t i) const {
+		if (packing == PackedGraphics)
+			return graphicElement(*graphics, i);
+		if (packing == PackedComplex)
+			return Expression(Atom(std::complex<double>(numbers[2 * i], numbers[2 * i + 1])));
+		return Expression(Atom(numbers[i]));
+	}
+
+	// the elements, unpacked once from the numbers of a packed block
+	const TailVector & elements() {
+		if (packing != Unpacked) {
+			std::call_once(unpack, [this] {
+				items.clear();
+				items.reserve(size());
+				for (std::size_t i = 0; i < size(); ++i)
+					items.push_back(element(i));
+				unpacked = true;
+			});
+		}
+		return items;
+	}
+
+	// a new block allocated by alloc, like its elements
+	static TailBlock * make(const ArenaAllocator<Expression> & alloc, TailVector && items,
+		Numbers && numbers, Packing packing) {
+		ArenaAllocator<TailBlock> blocks(alloc);
+		TailBlock * block = blocks.allocate(1);
+		try {
+			new (block) TailBlock(std::move(items), std::move(numbers), packing);
+		}
+		catch (...) {
+			blocks.deallocate(block, 1);
+			throw;
+		}
+		return block;
+	}
+
+	// a new empty block
+	static TailBlock * make(const ArenaAllocator<Expression> & alloc) {
+		return make(alloc, TailVector(alloc), Numbers(), Unpacked);
+	}
+
+	// a new block holding the elements [first, last)
+	template<typename Iterator>
+	static TailBlock * make(const ArenaAllocator<Expression> & alloc, Iterator first, Iterator last) {
+		return make(alloc, TailVector(first, last, alloc), Numbers(), Unpacked);
+	}
+
+	// a new packed block holding the given numbers
+	static TailBlock * make(const ArenaAllocator<Expression> & alloc, const double * first,
+		const double * last, Packing packing) {
+		return make(alloc, TailVector(alloc), Numbers(first, last), packing);
+	}
+
+	// a new block packed as the given graphics
+	static TailBlock * make(const ArenaAllocator<Expression> & alloc,
+		std::shared_ptr<const Graphics> graphics) {
+		TailBlock * block = make(alloc, TailVector(alloc), Numbers(), PackedGraphics);
+		block->graphics = std::move(graphics);
+		return block;
+	}
+
+	static void destroy(TailBlock * block) noexcept {
+		ArenaAllocator<TailBlock> blocks(block->items.get_allocator());
+		block->~TailBlock();
+		blocks.deallocate(block, 1);
+	}
+};
+
+Expression::Tail::Tail(std::vector<Expression> && items): Tail() {
+	if (!items.empty())
+		m_block = TailBlock::make(ArenaAllocator<Expression>(),
+			std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+}
+
+Expression::Tail::Tail(Numbers && numbers, Packing packing): Tail() {
+	if (!numbers.empty()) {
+		ArenaAllocator<Expression> alloc;
+		m_block = TailBlock::make(alloc, TailVector(alloc), std::move(numbers), packing);
+	}
+}
+
+Expression::Tail::Tail(std::shared_ptr<const Graphics> && graphics): Tail() {
+	if (graphics->size() > 0)
+		m_block = TailBlock::make(ArenaAllocator<Expression>(), std::move(graphics));
+}
+
+Expression::Tail & Expression::Tail::operator=(const Tail & other) noexcept {
+	if (other.m_block != nullptr)
+		other.retain();
+	if (m_block != nullptr)
+		release();
+	m_block = other.m_block;
+	m_offset = other.m_offset;
+	return *this;
+}
+
+Expression::Tail & Expression::Tail::operator=(Tail && other) noexcept {
+	if (this != &other) {
+		if (m_block != nullptr)
+			release();
+		m_block = other.m_block;
+		m_offset = other.m_offset;
+		other.m_block = nullptr;
+		other.m_offset = 0;
+	}
+	return *this;
+}
+
+void Expression::Tail::retain() const noexcept {
+	m_block->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+// blocks released by expressions nested deeper than MAX_RELEASE_DEPTH are
+// queued and destroyed by the outermost release, one at a time
+static const unsigned MAX_RELEASE_DEPTH = 256;
+
+void Expression::Tail::release() noexcept {
+
+	TailBlock * block = m_block;
+	m_block = nullptr;
+	m_offset = 0;
+	if (block->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+
+	static thread_local unsigned releaseDepth = 0;
+	static thread_local std::vector<TailBlock *> * releaseQueue = nullptr;
+
+	if (releaseDepth >= MAX_RELEASE_DEPTH) {
+		releaseQueue->push_back(block);
+		return;
+	}
+
+	std::vector<TailBlock *> queue;
+	const bool outermost = (releaseDepth == 0);
+	if (outermost)
+		releaseQueue = &queue;
+
+	++releaseDepth;
+	TailBlock::destroy(block);
+	while (outermost && !queue.empty()) {
+		block = queue.back();
+		queue.pop_back();
+		TailBlock::destroy(block);
+	}
+	--releaseDepth;
+
+	if (outermost)
+		releaseQueue = nullptr;
+}
+
+std::size_t Expression::Tail::size() const noexcept {
+	return m_block != nullptr ? m_block->size() - m_offset : 0;
+}
+
+Expression::Tail::const_iterator Expression::Tail::begin() const {
+	return m_block != nullptr ? m_block->elements().cbegin() + m_offset : emptyTail();
+}
+
+Expression::Tail::const_iterator Expression::Tail::end() const {
+	return m_block != nullptr ? m_block->elements().cend() : emptyTail();
+}
+
+Expression::Packing Expression::Tail::packing() const noexcept {
+	return m_block != nullptr ? m_block->packing : Unpacked;
+}
+
+const double * Expression::Tail::numbers() const noexcept {
+	if (m_block == nullptr || m_block->packing == Unpacked || m_block->packing == PackedGraphics)
+		return nullptr;
+	return m_block->numbers.data() + m_offset * m_block->stride();
+}
+
+const Graphics * Expression::Tail::graphics() const noexcept {
+	if (m_block == nullptr || m_block->packing != PackedGraphics || m_offset > 0)
+		return nullptr;
+	return m_block->graphics.get();
 }
 
-Expression::ConstIteratorType Expression::tailConstEnd() const noexcept {
-	return m_tail.cend();
+Expression Expression::Tail::at(std::size_t i) const {
+	if (m_block->packing != Unpacked)
+		return m_block->element(m_offset + i);
+	return m_block->items[m_offset + i];
 }
 
-Expression apply(const Atom & op, const std::vector<Expression> & args, const Environment & env) {
+Expression::Tail Expression::Tail::dropFirst(std::size_t n) const {
+
+	Tail result;
+	if (n < size()) {
+		result = *this;
+		result.m_offset = static_cast<std::uint32_t>(m_offset + n);
+	}
+	return result;
+}
+
+const void * Expression::Tail::id() const {
+	return empty() ? nullptr : static_cast<const void *>(&*begin());
+}
+
+void Expression::Tail::clear() noexcept {
+
+	// keep the capacity of an unshared vector for reuse
+	if (m_block != nullptr && m_offset == 0
+		&& m_block->refs.load(std::memory_order_acquire) == 1) {
+		m_block->items.clear();
+		m_block->numbers.clear();
+		m_block->graphics.reset();
+		m_block->packing = Unpacked;
+	}
+	else if (m_block != nullptr)
+		release();
+	m_offset = 0;
+}
+
+Expression::Tail Expression::Tail::heapCopy() const {
+
+	if (empty() || !m_block->items.get_allocator().arena())
+		return *this;
+
+	Tail result;
+	const ArenaAllocator<Expression> heap(nullptr);
+	if (m_block->packing == PackedGraphics) {
+		// the buffer is on the heap already
+		result.m_block = TailBlock::make(heap, m_block->graphics);
+		result.m_offset = m_offset;
+		return result;
+	}
+	if (const double * first = numbers()) {
+		result.m_block = TailBlock::make(heap, first, first + size() * m_block->stride(),
+			m_block->packing);
+		return result;
+	}
+
+	result.m_block = TailBlock::make(heap);
+	result.m_block->items.reserve(size());
+	for (auto & e : *this)
+		result.m_block->items.push_back(e.heapCopy());
+
+	return result;
+}
+
+Expression::TailVector & Expression::Tail::items() {
+
+	if (m_block == nullptr) {
+		m_block = TailBlock::make(ArenaAllocator<Expression>());
+		m_offset = 0;
+	}
+	else if (m_offset > 0 || m_block->refs.load(std::memory_order_acquire) > 1) {
+		// copy the viewed elements; each copy shares its own subtree
+		TailBlock * copy = TailBlock::make(ArenaAllocator<Expression>());
+		copy->items.reserve(size());
+		for (std::size_t i = 0; i < size(); ++i)
+			copy->items.push_back(at(i));
+		release();
+		m_block = copy;
+		m_offset = 0;
+	}
+	else if (m_block->packing != Unpacked) {
+		// the only view of a packed block unpacks it for good
+		m_block->elements();
+		Numbers().swap(m_block->numbers);
+		m_block->graphics.reset();
+		m_block->packing = Unpacked;
+	}
+
+	return m_block->items;
+}
+
+bool Expression::Tail::pushNumber(const Expression & exp) {
+
+	if (m_block == nullptr || m_block->packing == Unpacked
+		|| elementPacking(exp) != m_block->packing)
+		return false;
+
+	if (m_offset > 0 || m_block->refs.load(std::memory_order_acquire) > 1) {
+		// copy the viewed numbers
+		const double * first = numbers();
+		TailBlock * copy = TailBlock::make(ArenaAllocator<Expression>(), first,
+			first + size() * m_block->stride(), m_block->packing);
+		release();
+		m_block = copy;
+	}
+	else if (m_block->unpacked) {
+		// its elements would have to follow
+		return false;
+	}
+
+	if (m_block->packing == PackedComplex) {
+		std::complex<double> value = exp.head().asComplexNumber();
+		m_block->numbers.push_back(value.real());
+		m_block->numbers.push_back(value.imag());
+	}
+	else {
+		m_block->numbers.push_back(exp.head().asNumber());
+	}
+	return true;
+}
+
+Expression Expression::packedList(Numbers numbers, bool complex) {
+	return Expression(Atom::fromSymbolId(Symbols::List),
+		Tail(std::move(numbers), complex ? PackedComplex : PackedReal));
+}
+
+Expression Expression::graphicsList(Graphics graphics) {
+	return Expression(Atom::fromSymbolId(Symbols::List),
+		Tail(std::make_shared<const Graphics>(std::move(graphics))));
+}
+
+Expression Expression::makeList(std::vector<Expression> items) {
+
+	Packing packing = items.empty() ? Unpacked : elementPacking(items.front());
+	for (auto & e : items) {
+		if (packing == Unpacked || elementPacking(e) != packing) {
+			packing = Unpacked;
+			break;
+		}
+	}
+	if (packing == Unpacked)
+		return Expression(Atom::fromSymbolId(Symbols::List), std::move(items));
+
+	Numbers numbers;
+	if (packing == PackedComplex) {
+		numbers.reserve(2 * items.size());
+		for (auto & e : items) {
+			std::complex<double> value = e.head().asComplexNumber();
+			numbers.push_back(value.real());
+			numbers.push_back(value.imag());
+		}
+	}
+	else {
+		numbers.reserve(items.size());
+		for (auto & e : items)
+			numbers.push_back(e.head().asNumber());
+	}
+	return packedList(std::move(numbers), packing == PackedComplex);
+}
+
+Expression apply(const Atom & op, std::vector<Expression> args, const Environment & env) {
 
 	// head must be a symbol
 	if (!op.isSymbol()) {
@@ -113,13 +824,14 @@ Expression apply(const Atom & op, const std::vector<Expression> & args, const En
 	Procedure proc = env.get_proc(op);
 
 	// call proc with args
-	return proc(args);
+	return proc(std::move(args));
 }
 
-Expression Expression::handle_lookup(const Atom & head, const Environment & env) {
+Expression Expression::handle_lookup(const Atom & head, const Environment & env) const {
 	if (head.isSymbol()) { // if symbol is in env return value
-		if (env.is_exp(head)) {
-			return env.get_exp(head);
+		const Expression * value = env.find_exp(head);
+		if (value != nullptr) {
+			return *value;
 		}
 		else {
 			throw SemanticError("Error during evaluation: unknown symbol");
@@ -133,7 +845,7 @@ Expression Expression::handle_lookup(const Atom & head, const Environment & env)
 	}
 }
 
-Expression Expression::handle_begin(Environment & env) {
+Expression Expression::handle_begin(Environment & env) const {
 
 	if (m_tail.size() == 0) {
 		throw SemanticError("Error during evaluation: zero arguments to begin");
@@ -141,14 +853,14 @@ Expression Expression::handle_begin(Environment & env) {
 
 	// evaluate each arg from tail, return the last
 	Expression result;
-	for (Expression::IteratorType it = m_tail.begin(); it != m_tail.end(); ++it) {
+	for (auto it = m_tail.begin(); it != m_tail.end(); ++it) {
 		result = it->eval(env);
 	}
 
 	return result;
 }
 
-Expression Expression::handle_define(Environment & env) {
+Expression Expression::handle_define(Environment & env) const {
 
 
 	// tail must have size 3 or error
@@ -162,12 +874,12 @@ Expression Expression::handle_define(Environment & env) {
 	}
 
 	// but tail[0] must not be a special-form or procedure
-	std::string s = m_tail[0].head().asSymbol();
-	if ((s == "define") || (s == "begin")) {
+	SymbolId s = m_tail[0].head().symbolId();
+	if ((s == Symbols::Define) || (s == Symbols::Begin)) {
 		throw SemanticError("Error during evaluation: attempt to redefine a special-form");
 	}
 
-	if (env.is_proc(m_head)) {
+	if (env.is_proc(m_tail[0].head())) {
 		throw SemanticError("Error during evaluation: attempt to redefine a built-in procedure");
 	}
 
@@ -185,7 +897,7 @@ Expression Expression::handle_define(Environment & env) {
 }
 
 // Milestone 1 task 3: anonymous(Lambda) functions 
-Expression Expression::handle_lambda(Environment & env)
+Expression Expression::handle_lambda(Environment & env) const
 {
 	if (m_tail.size() != 2) {
 		throw SemanticError("Error during evaluation: invalid number of arguments to lambda");
@@ -195,21 +907,21 @@ Expression Expression::handle_lambda(Environment & env)
 		throw SemanticError("Error during evaluation: first argument to lambda not symbol");
 	}
 
-	Atom head("list");
+	Atom head = Atom::fromSymbolId(Symbols::List);
 	Expression lambda_list(head);
-	if (env.is_proc(m_tail[0].head().asSymbol())) {
+	if (env.is_proc(m_tail[0].head())) {
 		throw SemanticError("Error during evaluation: attempt to redefine a built-in procedure");
 	}
 	lambda_list.addToTail(Expression(m_tail[0].head()));
 	for (auto a = m_tail[0].tailConstBegin(); a != m_tail[0].tailConstEnd(); ++a) {
-		if (env.is_proc(a->head().asSymbol())) {
+		if (env.is_proc(a->head())) {
 			throw SemanticError("Error during evaluation: attempt to redefine a built-in procedure");
 		}
 		else
 			lambda_list.addToTail(*a);
 	}
 
-	Atom headEx("lambda");
+	Atom headEx = Atom::fromSymbolId(Symbols::Lambda);
 	Expression result(headEx);
 	result.addToTail(lambda_list);
 	//m_tail[1].eval(env);
@@ -218,7 +930,7 @@ Expression Expression::handle_lambda(Environment & env)
 	return result;
 }
 
-Expression Expression::handle_apply(Environment & env)
+Expression Expression::handle_apply(Environment & env) const
 {
 
 	if (m_tail.size() != 2) {
@@ -227,7 +939,7 @@ Expression Expression::handle_apply(Environment & env)
 	if (!m_tail[0].isHeadSymbol())
 		throw SemanticError("Error in apply: first atgument not a procedure");
 
-	if (m_tail[1].head().asSymbol() != "list")
+	if (m_tail[1].head().symbolId() != Symbols::List)
 		throw SemanticError("Error: in apply: second argument not a list");
 
 	if (env.is_proc(m_tail[0].head()))
@@ -235,88 +947,121 @@ Expression Expression::handle_apply(Environment & env)
 		if (m_tail[0].m_tail.size() != 0)
 			throw SemanticError("Error during evaluation: first argument to apply not a procedure");
 
-		Expression post_apply_eval(m_tail[0].head());
-		int tempSize = m_tail[1].m_tail.size();
-		for (int i = 0; i < tempSize; ++i)
-		{
-			post_apply_eval.addToTail(m_tail[1].m_tail[i]);
-		}
-		Expression result(m_tail[1].head());
-		result = post_apply_eval.eval(env);
-		return result;
+		Expression post_apply_eval(m_tail[0].head(), m_tail[1].m_tail);
+		return post_apply_eval.eval(env);
 
 	}
 	else
 	{
-		Expression grablambda = env.get_exp(m_tail[0].head());
-
-		//if (grablambda.head().asSymbol() == "lambda") {
-			Expression lambdaEval = m_tail[1].eval(env);
-			Expression tree(m_tail[0].m_head.asSymbol());
-			int tempSize = lambdaEval.m_tail.size();
-			for (int i = 0; i < tempSize; i++)
-			{
-				tree.addToTail(lambdaEval.m_tail[i].eval(env));
-			}
-			Expression result(m_tail[1].head());
-			result = tree.eval(env);
-			return result;
-		//}
+		Expression lambdaEval = m_tail[1].eval(env);
+		Expression tree(m_tail[0].m_head);
+		for (std::size_t i = 0; i < lambdaEval.m_tail.size(); ++i)
+			tree.addToTail(lambdaEval.m_tail.at(i).eval(env));
+		return tree.eval(env);
 	}
 
 
 }
-Expression Expression::handle_map(Environment & env)
+// evaluate result(i, frame) for i = 0, ..., count - 1 on the shared pool
+// of threads, in chunks of consecutive elements; each chunk allocates from
+// its own arena and evaluates in its own frame, which leaves env and the
+// arena of the evaluation alone while the chunks run. The error of the
+// lowest element is rethrown, as a sequential loop would have thrown it.
+static std::vector<Expression> parallelResults(std::size_t count, Environment & env,
+	const std::function<Expression(std::size_t, Environment &)> & result)
+{
+	std::vector<Expression> results(count);
+
+	ThreadPool & pool = ThreadPool::shared();
+	const std::size_t chunks = std::min(count, 4 * (pool.workers() + 1));
+
+	std::mutex mutex;
+	std::exception_ptr error;
+	std::atomic<std::size_t> failed(count);
+
+	pool.run(chunks, [&](std::size_t chunk)
+	{
+		ArenaScope scope(std::make_shared<Arena>());
+		Environment frame(&env);
+		const std::size_t end = (chunk + 1) * count / chunks;
+		for (std::size_t i = chunk * count / chunks; i < end && i < failed.load(); ++i)
+		{
+			try {
+				results[i] = result(i, frame);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(mutex);
+				if (i < failed.load()) {
+					failed.store(i);
+					error = std::current_exception();
+				}
+				return;
+			}
+		}
+	});
+
+	if (error)
+		std::rethrow_exception(error);
+	return results;
+}
+
+Expression Expression::handle_map(Environment & env, bool parallel) const
 {
+	const std::string form = parallel ? "pmap" : "map";
+
 	if (m_tail.size() != 2) {
-		throw SemanticError("Error during evaluation: invalid number of arguments to map");
+		throw SemanticError("Error during evaluation: invalid number of arguments to " + form);
 	}
 	Expression arg = m_tail[1].eval(env);
-	if (arg.head().asSymbol() != "list")
-		throw SemanticError("Error in map: second argument not a list");
+	if (arg.head().symbolId() != Symbols::List)
+		throw SemanticError("Error in " + form + ": second argument not a list");
+
+	// each element is passed as the call (f element) would pass it, and
+	// the results are packed if all numbers
+	std::function<Expression(std::size_t, Environment &)> result;
+	std::shared_ptr<const Closure> closure;
 
 	if (env.is_proc(m_tail[0].head()))
 	{
 		if (m_tail[0].m_tail.size() != 0)
-			throw SemanticError("Error during evaluation: first argument to map not a procedure");
+			throw SemanticError("Error during evaluation: first argument to " + form + " not a procedure");
 
-		Expression result(Atom("list"));
-		int tempSize = arg.m_tail.size();
-		for (int i = 0; i < tempSize; ++i)
+		result = [&](std::size_t i, Environment & frame)
 		{
-			Expression post_apply_eval(m_tail[0].head());
-			post_apply_eval.addToTail(arg.m_tail[i]);
-			result.addToTail(post_apply_eval.eval((env)));
-		}
-		return result;
+			std::vector<Expression> element(1, arg.m_tail.at(i).eval(frame));
+			return apply(m_tail[0].head(), std::move(element), frame);
+		};
 	}
 	else if (env.is_exp(m_tail[0].head()))
 	{
-		Expression grablambda = env.get_exp(m_tail[0].head());
+		closure = env.find_closure(m_tail[0].head());
+		if (!closure)
+			throw SemanticError("Error in " + form + ": expression not lambda");
+		if (!arg.m_tail.empty() && closure->arity() == 0)
+			throw SemanticError("Error in call to lambda: invalid number of arguments");
 
-		if (grablambda.head().asSymbol() == "lambda")
+		result = [&](std::size_t i, Environment & frame)
 		{
-			Expression lambdaEval = m_tail[1].eval(env);
-			Expression tree(m_tail[0].m_head.asSymbol());
-			Expression result(Atom("list"));
-			for (unsigned int i = 0; i != lambdaEval.m_tail.size(); i++)
-			{
-				tree.addToTail(lambdaEval.m_tail[i].eval(env));
-				result.addToTail(tree.eval(env));
-				tree.m_tail.clear();
-			}
-			return result;
-
-		}
-		else
-			throw SemanticError("Error in map: expression not lambda");
-
+			Expression element = arg.m_tail.at(i).eval(frame);
+			Environment call(&frame, *closure);
+			call.bind_param(element.eval(frame));
+			return closure->body().eval(call);
+		};
 	}
 	else
-		throw SemanticError("Error during evaluation: first argument to map not a procedure");
+		throw SemanticError("Error during evaluation: first argument to " + form + " not a procedure");
+
+	if (parallel)
+		return makeList(parallelResults(arg.m_tail.size(), env, result));
+
+	std::vector<Expression> results;
+	results.reserve(arg.m_tail.size());
+	for (std::size_t i = 0; i < arg.m_tail.size(); ++i)
+		results.push_back(result(i, env));
+	return makeList(std::move(results));
 }
 
-Expression Expression::handle_setProperty(Environment & env)
+Expression Expression::handle_setProperty(Environment & env) const
 {
 	if (m_tail.size() != 3)
 		throw SemanticError("Error in set-property: invalid number of arguments");
@@ -331,136 +1076,187 @@ Expression Expression::handle_setProperty(Environment & env)
 
 	Expression value = m_tail[2].eval(env);
 
-	m_tail[2].m_property[tag] = property;
-	value.m_property[tag] = property;
-	//value.eval(env);
-
-	//m_tail[2].eval(env);
+	value.setProperty(std::move(tag), std::move(property));
 
 	return value;
 }
 
 void Expression::setProperty(std::string tag, Expression property)
 {
-	this->m_property[tag] = property;
+	PropertyTable & table = m_property.unshared();
+	int known = wellKnown(tag);
+	SymbolId key = propertyKey(tag, known);
+
+	// a well-known property is held in its field when its value fits,
+	// otherwise with the others
+	if (known == OBJECT_NAME) {
+		table.objectName = NoObject;
+		table.erase(key);
+		if (isPlainAtom(property) && property.head().isStringLiteral()) {
+			const std::string & name = property.head().asStringLiteral();
+			for (int o = PointObject; o <= LabelObject; ++o) {
+				if (name == OBJECT_NAMES[o]) {
+					table.objectName = static_cast<unsigned char>(o);
+					return;
+				}
+			}
+		}
+	}
+	else if (known != NOT_WELL_KNOWN) {
+		table.numbers &= ~(1u << known);
+		table.erase(key);
+		if (isPlainAtom(property) && property.isHeadNumber()) {
+			table.number[known] = property.head().asNumber();
+			table.numbers |= (1u << known);
+			return;
+		}
+	}
+	else {
+		for (auto & p : table.others) {
+			if (p.key == key) {
+				p.value = std::move(property);
+				return;
+			}
+		}
+	}
+
+	table.others.emplace_back(key, std::move(property));
+}
+
+void Expression::shareProperties(const Expression & other)
+{
+	m_property = other.m_property;
 }
 
-Expression Expression::handle_getProperty(Environment & env)
+Expression Expression::handle_getProperty(Environment & env) const
 {
 	if (m_tail.size() != 2)
 		throw SemanticError("Error in get-property: invalid number of arguments");
 	if (!m_tail[0].head().isStringLiteral())
 		throw SemanticError("Error in get-property: input for tag not a string literal");
 
-	Expression evalValue;
-	evalValue = m_tail[1].eval(env);
-	auto property = evalValue.m_property.find(m_tail[0].head().asStringLiteral());
+	Expression evalValue = m_tail[1].eval(env);
 
-	if (property == evalValue.m_property.end())
-		return Expression();
-	else
-	{
-		Expression result = property->second;
-		return result;
-	}
+	return evalValue.property(m_tail[0].head().asStringLiteral());
 }
 
 // helper function for discrete plots 
-std::map<std::string, double> getValueProperties(Expression exp)
+// the coordinates of every point of a list of points, in order; packed
+// points are read without unpacking them
+static std::vector<double> pointCoordinates(const Expression & exp)
 {
-
-	std::map<double, double> coordinates;
-	std::vector<Expression> tempParameters;
-	std::map<std::string, double> properties;
-
-	for (auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e)
-	{
-		
-			Expression points = *e;
-			for (auto a = points.tailConstBegin(); a != points.tailConstEnd(); ++a)
-				tempParameters.push_back(*a);
-	}
-
-	double xMin, xMax, yMin, yMax;
-	xMin = std::numeric_limits<double>::max();
-	yMin = std::numeric_limits<double>::max();
-	xMax = std::numeric_limits<double>::lowest();
-	yMax = std::numeric_limits<double>::lowest();
-
-	for (unsigned int i = 0; i != tempParameters.size(); i += 2)
+	std::vector<double> coordinates;
+	coordinates.reserve(2 * exp.listLength());
+	for (int p = 0; p < exp.listLength(); ++p)
 	{
-		if (xMax < tempParameters[i].head().asNumber())
-			xMax = tempParameters[i].head().asNumber();
-
-		if (yMax < tempParameters[i + 1].head().asNumber())
-			yMax = tempParameters[i + 1].head().asNumber();
-
-		if (xMin > tempParameters[i].head().asNumber())
-			xMin = tempParameters[i].head().asNumber();
-		if (yMin > tempParameters[i + 1].head().asNumber())
-			yMin = tempParameters[i + 1].head().asNumber();
+		Expression point = exp.listElement(p);
+		if (point.tailPacking() == Expression::PackedReal)
+		{
+			const double * first = point.packedTail();
+			coordinates.insert(coordinates.end(), first, first + point.listLength());
+		}
+		else
+		{
+			for (auto a = point.tailConstBegin(); a != point.tailConstEnd(); ++a)
+				coordinates.push_back(a->head().asNumber());
+		}
 	}
+	return coordinates;
+}
 
-	properties["max x"] = xMax;
-	properties["min x"] = xMin;
-	properties["max y"] = yMax;
-	properties["min y"] = yMin;
-	properties["x scale"] = 20 / (xMax - xMin);
-	properties["y scale"] = 20 / (yMax - yMin);
+// the bounds of the data of a plot and its scale, which maps the data
+// onto a box of 20 by 20 plot units
+struct PlotFrame
+{
+	double xMin, xMax, yMin, yMax; // the bounds of the data
+	double xScale, yScale;         // plot units per unit of data
+	double NxMin, NxMax, NyMin, NyMax; // the bounds in plot units, y not flipped
+};
 
-	return properties;
+// the frame of the points with the given coordinates, x then y of each
+static PlotFrame plotFrame(const std::vector<double> & coordinates)
+{
+	double low[2], high[2];
+	VectorMath::pairBounds(coordinates.data(), coordinates.size() / 2, low, high);
+
+	PlotFrame frame;
+	frame.xMin = low[0];
+	frame.xMax = high[0];
+	frame.yMin = low[1];
+	frame.yMax = high[1];
+	frame.xScale = 20 / (frame.xMax - frame.xMin);
+	frame.yScale = 20 / (frame.yMax - frame.yMin);
+	frame.NxMin = frame.xScale * frame.xMin;
+	frame.NxMax = frame.xScale * frame.xMax;
+	frame.NyMin = frame.yScale * frame.yMin;
+	frame.NyMax = frame.yScale * frame.yMax;
+	return frame;
 }
 
 Expression makePoint(double x, double y, double size)
 {
-	Expression point(Atom("list"));
+	Expression point(Atom::fromSymbolId(Symbols::List));
 	Atom p("point");
 	p.setStringLiteral();
 	point.setProperty("object-name", Expression(p));
-	point.addToTail(Atom(x));
-	point.addToTail(Atom(y));
+	point.append(Atom(x));
+	point.append(Atom(y));
 	point.setProperty("size", Expression(Atom(size)));
 	return point;
 }
 
 Expression makeLine(Expression p1, Expression p2, double thickness)
 {
-	Expression line(Atom("list"));
+	Expression line(Atom::fromSymbolId(Symbols::List));
 	Atom l("line");
 	l.setStringLiteral();
 	line.setProperty("object-name", Expression(l));
-	line.addToTail(p1);
-	line.addToTail(p2);
+	line.addToTail(std::move(p1));
+	line.addToTail(std::move(p2));
 	line.setProperty("thickness", Expression(Atom(thickness)));
 	return line;
 }
 
 Expression makeText(std::string text, double x, double y, double scale, double phi)
 {
-	Atom head(text);
-	head.setStringLiteral();
-	Expression txt(head);
+	// generated texts such as tick labels are not interned
+	Expression txt(Atom::fromString(text));
 	Atom t("text");
 	t.setStringLiteral();
 	txt.setProperty("object-name", Expression(t));
-	Expression point = makePoint(x, y, 0.0);
-	txt.setProperty("position", point);
+	txt.setProperty("position", makePoint(x, y, 0.0));
 	txt.setProperty("text-scale", Expression(Atom(scale)));
 	txt.setProperty("text-rotation", Expression(Atom(phi)));
 	return txt;
 }
 
-Expression createPlotLayout(std::map<std::string, double> values)
+// primitive i of a graphics buffer, as make-point, make-line or make-text
+// would build it
+static Expression graphicElement(const Graphics & graphics, std::size_t i)
 {
-	// extract the max,min,and scale value
-	double xscaler = values.find("x scale")->second;
-	double yscaler = values.find("y scale")->second;
+	switch (graphics.kind(i)) {
+	case Graphics::Point: {
+		Graphics::PointData p = graphics.point(i);
+		return makePoint(p.x, p.y, p.size);
+	}
+	case Graphics::Line: {
+		Graphics::LineData l = graphics.line(i);
+		return makeLine(makePoint(l.x1, l.y1, 0.0), makePoint(l.x2, l.y2, 0.0), l.thickness);
+	}
+	default: {
+		Graphics::TextData t = graphics.text(i);
+		return makeText(t.text, t.x, t.y, t.scale, t.rotation);
+	}
+	}
+}
 
-	// let the bounding box be size N x N and set max x y coordinates of the box
-	double NxMax = xscaler * values.find("max x")->second;
-	double NxMin = xscaler * values.find("min x")->second;
-	double NyMax = yscaler * values.find("max y")->second;
-	double NyMin = yscaler * values.find("min y")->second;
+void addPlotLayout(Graphics & graphics, const PlotFrame & frame)
+{
+	// the bounding box is N x N
+	double NxMax = frame.NxMax;
+	double NxMin = frame.NxMin;
+	double NyMax = frame.NyMax;
+	double NyMin = frame.NyMin;
 
 	bool xAxisExists = false, yAxisExists = false;
 
@@ -471,58 +1267,27 @@ Expression createPlotLayout(std::map<std::string, double> values)
 		xAxisExists = true;
 
 	// draw the box from the top going CWthen axes if they are within box range 
-	Expression boxLayout(Atom("list"));
-	Expression p1 = makePoint(NxMin, -NyMax, 0.0);
-	Expression p2 = makePoint(NxMax, -NyMax, 0.0);
-	boxLayout.addToTail(makeLine(p1, p2, 0.0));
-
-	p1 = makePoint(NxMax, -NyMax, 0.0);
-	p2 = makePoint(NxMax, -NyMin, 0.0);
-	boxLayout.addToTail(makeLine(p1, p2, 0.0));
-
-	p1 = makePoint(NxMax, -NyMin, 0.0);
-	p2 = makePoint(NxMin, -NyMin, 0.0);
-	boxLayout.addToTail(makeLine(p1, p2, 0.0));
-
-	p1 = makePoint(NxMin, -NyMin, 0.0);
-	p2 = makePoint(NxMin, -NyMax, 0.0);
-	boxLayout.addToTail(makeLine(p1, p2, 0.0));
+	graphics.addLine(NxMin, -NyMax, NxMax, -NyMax, 0.0);
+	graphics.addLine(NxMax, -NyMax, NxMax, -NyMin, 0.0);
+	graphics.addLine(NxMax, -NyMin, NxMin, -NyMin, 0.0);
+	graphics.addLine(NxMin, -NyMin, NxMin, -NyMax, 0.0);
 
 	// draw the axes if they are within box range
 	if (xAxisExists == true)
-	{
-		p1 = makePoint(NxMin, 0.0,0.0);
-		p2 = makePoint(NxMax, 0.0, 0.0);
-		boxLayout.addToTail(makeLine(p1, p2, 0.0));
-	}
+		graphics.addLine(NxMin, 0.0, NxMax, 0.0, 0.0);
 	if (yAxisExists == true)
-	{
-		p1 = makePoint(0.0,-NyMin, 0.0);
-		p2 = makePoint(0.0, -NyMax, 0.0);
-		boxLayout.addToTail(makeLine(p1, p2, 0.0));
-	}
-
-	return boxLayout;
+		graphics.addLine(0.0, -NyMin, 0.0, -NyMax, 0.0);
 } 
 
-Expression createPlotLabels(std::map<std::string, double> values, Expression exp)
+void addPlotLabels(Graphics & graphics, const PlotFrame & frame, const Expression & exp)
 {
-	// extract the max,min,and scale value
-	double xscaler = values.find("x scale")->second;
-	double yscaler = values.find("y scale")->second;
-	double xMax = values.find("max x")->second;
-	double xMin = values.find("min x")->second;
-	double yMax = values.find("max y")->second;
-	double yMin = values.find("min y")->second;
-
-	// let the bounding box be size N x N and set max x y coordinates of the box
-	double NxMax = xscaler * xMax;
-	double NxMin = xscaler * xMin;
-	double NyMax = yscaler * yMax;
-	double NyMin = yscaler * yMin;
+	// the bounding box is N x N
+	double NxMax = frame.NxMax;
+	double NxMin = frame.NxMin;
+	double NyMax = frame.NyMax;
+	double NyMin = frame.NyMin;
 
 	// create labels using make-text title, x label, y label respectively
-	Expression Labels(Atom("list"));
 	double scale = 1;
 
 	if (exp.head().asSymbol() != "no labels")
@@ -532,7 +1297,7 @@ Expression createPlotLabels(std::map<std::string, double> values, Expression exp
 
 		for (auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e)
 		{
-			Expression points = *e;
+			const Expression & points = *e;
 			for (auto a = points.tailConstBegin(); a != points.tailConstEnd(); ++a)
 				temp.push_back(*a);
 		}
@@ -549,18 +1314,18 @@ Expression createPlotLabels(std::map<std::string, double> values, Expression exp
 
 		auto title = labels.find("title");
 		if (title != labels.end())
-			Labels.addToTail(makeText(title->second.head().asStringLiteral(), NxMin + 10, -NyMax - 3, scale, 0.0));
+			graphics.addText(title->second.head().asStringLiteral(), NxMin + 10, -NyMax - 3, scale, 0.0);
 
 		auto xlabel = labels.find("abscissa-label");
 		if (xlabel != labels.end())
-			Labels.addToTail(makeText(xlabel->second.head().asStringLiteral(), NxMin + 10, -NyMin + 3, scale, 0.0));
+			graphics.addText(xlabel->second.head().asStringLiteral(), NxMin + 10, -NyMin + 3, scale, 0.0);
 
 		auto ylabel = labels.find("ordinate-label");
 		if (ylabel != labels.end())
-			Labels.addToTail(makeText(ylabel->second.head().asStringLiteral(), NxMin - 3, -NyMin - 10, scale, -std::atan2(0, -1) / 2));
+			graphics.addText(ylabel->second.head().asStringLiteral(), NxMin - 3, -NyMin - 10, scale, -std::atan2(0, -1) / 2);
 	}
 	// create labels for tic marks in roder of the vector below 
-	std::vector<double> rangeValues = { yMax,yMin,xMin,xMax };
+	std::vector<double> rangeValues = { frame.yMax,frame.yMin,frame.xMin,frame.xMax };
 	std::vector<std::string> tickMark;
 	std::stringstream stream;
 
@@ -571,328 +1336,288 @@ Expression createPlotLabels(std::map<std::string, double> values, Expression exp
 		stream.str(std::string());
 	}
 	
-	Labels.addToTail(makeText(tickMark[0], NxMin - 2, -NyMax, scale, 0.0));
-	Labels.addToTail(makeText(tickMark[1], NxMin - 2, -NyMin, scale, 0.0));
-	Labels.addToTail(makeText(tickMark[2], NxMin, -NyMin + 2, scale, 0.0));
-	Labels.addToTail(makeText(tickMark[3], NxMax, -NyMin + 2, scale, 0.0));
-
-	return Labels;
-
+	graphics.addText(tickMark[0], NxMin - 2, -NyMax, scale, 0.0);
+	graphics.addText(tickMark[1], NxMin - 2, -NyMin, scale, 0.0);
+	graphics.addText(tickMark[2], NxMin, -NyMin + 2, scale, 0.0);
+	graphics.addText(tickMark[3], NxMax, -NyMin + 2, scale, 0.0);
 }
 
-Expression Expression::handle_discretePlot(Environment & env)
+Expression Expression::handle_discretePlot(Environment & env) const
 {
 	Expression rawData = m_tail[0].eval(env);
 	Expression labelProperties = m_tail[1].eval(env);
 
-	if (rawData.head().asSymbol() != "list")
+	if (rawData.head().symbolId() != Symbols::List)
 		throw SemanticError("Error in discrete plot: first argument not a list");
-	if (labelProperties.head().asSymbol() != "list")
+	if (labelProperties.head().symbolId() != Symbols::List)
 		throw SemanticError("Error in discrete plot: second argument not a list");
 
-	std::map<std::string, double> properties = getValueProperties(rawData);
-	Expression plotLayout = createPlotLayout(properties);
-	Expression plotLabels = createPlotLabels(properties, labelProperties);
-
-	// extract the  ymax, ymin and scale value
-	double xscaler = properties.find("x scale")->second;
-	double yscaler = properties.find("y scale")->second;
+	// the data is read once, for the frame and for the points
+	std::vector<double> coordinates = pointCoordinates(rawData);
+	PlotFrame frame = plotFrame(coordinates);
+	Graphics graphics;
+	addPlotLayout(graphics, frame);
+	addPlotLabels(graphics, frame, labelProperties);
 
-	// let the bounding box be size N x N and set max x y coordinates of the box
-	double NyMax = yscaler * properties.find("max y")->second;
-	double NyMin = yscaler * properties.find("min y")->second;
+	double NyMax = frame.NyMax;
+	double NyMin = frame.NyMin;
 
 	bool xAxisExists = false;
 
 	if (NyMax > 0 && NyMin < 0)
 		xAxisExists = true;
 
-	std::vector<Expression> temp;
-	std::map<double, double> points;
-	Expression plot(Atom("list"));
+	// the points in increasing x; of points at the same x, the y of the last
+	// is drawn at the x of the first
+	std::vector<std::pair<double, double> > points(coordinates.size() / 2);
+	for (std::size_t i = 0; i < points.size(); ++i)
+		points[i] = std::make_pair(frame.xScale * coordinates[2 * i], frame.yScale * coordinates[2 * i + 1]);
 
-	for (auto e = rawData.tailConstBegin(); e != rawData.tailConstEnd(); ++e)
+	auto byX = [](const std::pair<double, double> & a, const std::pair<double, double> & b)
 	{
-		Expression point = *e;
-		for (auto a = point.tailConstBegin(); a != point.tailConstEnd(); ++a)
-			temp.push_back(*a);
-	}
-
-	for (unsigned int i = 0; i < temp.size(); i += 2)
-		points[xscaler*temp[i].head().asNumber()] = yscaler * temp[i + 1].head().asNumber();
-
-	for (auto it = points.begin(); it != points.end(); it++)
+		return a.first < b.first;
+	};
+	if (!std::is_sorted(points.begin(), points.end(), byX))
+		std::stable_sort(points.begin(), points.end(), byX);
+
+	// each point stands on the x axis, or else on the edge of the box
+	// nearest to it
+	double base = 0.0;
+	if (xAxisExists == false && NyMin > 0)
+		base = -NyMin;
+	else if (xAxisExists == false && NyMax < 0)
+		base = -NyMax;
+
+	for (std::size_t i = 0, last = 0; i < points.size(); i = ++last)
 	{
-		Expression basePoint;
-		if (xAxisExists == true)
-			basePoint = makePoint(it->first, 0.0, 0);
-		else if (xAxisExists == false && NyMin > 0)
-			basePoint = makePoint(it->first, -NyMin, 0.0);
-		else if (xAxisExists == false && NyMax < 0)
-			basePoint = makePoint(it->first, -NyMax, 0.0);
-		Expression actualPoint = makePoint(it->first, -it->second, 0.0);
-		Expression line = makeLine(basePoint, actualPoint, 0.0);
-		Expression lollipop = makePoint(it->first, -it->second, 0.5);
-		plot.addToTail(line);
-		plot.addToTail(lollipop);
+		while (last + 1 < points.size() && !byX(points[last], points[last + 1]))
+			++last;
+		graphics.addLine(points[i].first, base, points[i].first, -points[last].second, 0.0);
+		graphics.addPoint(points[i].first, -points[last].second, 0.5);
 	}
-	
-	// combine  all the parameters in to one list
-	Expression discretePlot(Atom("list"));
-	for (auto e = plotLayout.tailConstBegin(); e != plotLayout.tailConstEnd(); ++e)
-		discretePlot.addToTail(*e);
-	for (auto e = plotLabels.tailConstBegin(); e != plotLabels.tailConstEnd(); ++e)
-		discretePlot.addToTail(*e);
-	for (auto e = plot.tailConstBegin(); e != plot.tailConstEnd(); ++e)
-		discretePlot.addToTail(*e);
 
-	return discretePlot;
+	return graphicsList(std::move(graphics));
 }
 
-Expression Expression::handle_continousPlot(Environment & env)
+// the number of uniform intervals continuous-plot samples the function
+// over before refining them, from the "samples" option if given
+static std::size_t plotSamples(const Expression & options, std::size_t samples)
 {
-	// extract the plot bounds from input
-	Expression xleft = m_tail[1].m_tail[0];
-	Expression xright = m_tail[1].m_tail[1];
-	
-	// compute the scalar to generate exactly 50 samples for plotting
-	double xboundScaler = (xright.head().asNumber() - xleft.head().asNumber())/50;
-	Expression xPoints(Atom("list"));
-	Expression rawData(Atom("list"));
+	if (options.head().symbolId() != Symbols::List)
+		return samples;
 
-	for (double i = xleft.head().asNumber(); i <= xright.head().asNumber(); i += xboundScaler)
-		xPoints.addToTail(Expression(Atom(i)));
-	xPoints.addToTail(xright);
-
-	for (auto e = xPoints.tailConstBegin(); e != xPoints.tailConstEnd(); ++e)
+	for (auto e = options.tailConstBegin(); e != options.tailConstEnd(); ++e)
 	{
-		Expression currentData(Atom("list"));
-		Expression yPoints(m_tail[0]);
-		yPoints.addToTail(*e);
-
-		currentData.addToTail(*e);
-		currentData.addToTail(yPoints.eval(env));
-		rawData.addToTail(currentData);
+		if (e->listLength() != 2 || !e->tailConstBegin()->head().isStringLiteral()
+			|| e->tailConstBegin()->head().asStringLiteral() != "samples")
+			continue;
+
+		const Expression & value = *(e->tailConstBegin() + 1);
+		double n = value.head().asNumber();
+		if (!value.isHeadNumber() || n < 1 || n != std::floor(n) || n > 1e8)
+			throw SemanticError("Error in continuous plot: samples not a positive integer");
+		samples = static_cast<std::size_t>(n);
 	}
+	return samples;
+}
 
+Expression Expression::handle_continousPlot(Environment & env) const
+{
+	// extract the plot bounds from input
+	const Expression & xleft = m_tail[1].m_tail[0];
+	const Expression & xright = m_tail[1].m_tail[1];
 
-	// now generate continuous plot
-
-	std::map<std::string, double> properties = getValueProperties(rawData);
-	Expression plotLayout = createPlotLayout(properties);
 	Expression labelProperties(Atom("no labels"));
-
 	if (m_tail.size() == 3)
 		labelProperties = m_tail[2].eval(env);
 
-	Expression plotLabels = createPlotLabels(properties, labelProperties);
-	// extract the  ymax, ymin and scale value
-	double xscaler = properties.find("x scale")->second;
-	double yscaler = properties.find("y scale")->second;
-
-	std::vector<Expression> temp;
-	Expression plot(Atom("list"));
+	CurveSampler sampler;
+	sampler.intervals = plotSamples(labelProperties, sampler.intervals);
 
-	for (auto e = rawData.tailConstBegin(); e != rawData.tailConstEnd(); ++e)
+	// each batch of samples calls the function as (f x) would, in parallel
+	auto function = [&](const std::vector<double> & xs)
 	{
-		Expression point = *e;
-		for (auto a = point.tailConstBegin(); a != point.tailConstEnd(); ++a)
-			temp.push_back(*a);
-	}
-
-	int maxIter = 0;
-	double v1x,v2x,v1y,v2y,V1, V2,theta,dotProduct; // compute the angle between two vectors for smoothing 
-	double x1, x2, x3, y1, y2, y3;
-	Expression point1;
-	Expression smoothPoint;
-	Expression point2;
-	Expression point3;
-	Expression line1;
-	Expression line2;
-	Expression smoothLine;
-
-	double oneEightyOverPI = 180 / std::atan2(0, -1); // conversion
-	for (unsigned int i = 0; i < temp.size() - 4; i += 2) {
-		
-		x1 = temp[i].head().asNumber();
-		y1 = temp[i+1].head().asNumber();
-		x2 = temp[i+2].head().asNumber();
-		y2 = temp[i+3].head().asNumber();
-		x3 = temp[i+4].head().asNumber();
-		y3 = temp[i+5].head().asNumber();
-		
-		v1x = x2 - x1;
-		v1y = y2 - y1;
-		v2x = x3 - x2;
-		v2y = y3 - y2;
-
-		V1 = std::sqrt(v1x*v1x + v1y * v1y); //magnitude of vector 
-		V2 = std::sqrt(v2x*v2x + v2y * v2y);
-		dotProduct = v1x * v2x + v1y * v2y;
-		
-		theta = std::acos(dotProduct / (V1*V2)) * oneEightyOverPI; // compute theta in degrees
-
-		point1 = makePoint(xscaler*x1, -yscaler * y1, 0.0);
-		point2 = makePoint(xscaler*x2, -yscaler * y2, 0.0);
-		point3 = makePoint(xscaler*x3, -yscaler * y3, 0.0);
-
-		line1 = makeLine(point1, point2, 0.5);
-		plot.addToTail(line1);
-
-
-		if (theta >5 && theta < 175 && maxIter < 10) {
-			
-			maxIter++;
-			Expression newyPoints(m_tail[0]);
-			newyPoints.addToTail(Expression(Atom(temp[i].head().asNumber() + 0.5*(v1x - v2x))));
-			Expression newy = newyPoints.eval(env);
-			smoothPoint = makePoint(xscaler*(x1 + 0.5*(v1x - v2x)), -yscaler * (newy.head().asNumber()), 0.0);
-			
-			smoothLine = makeLine(smoothPoint, point2, 0.5);
-			plot.addToTail(smoothLine);
-			
-		}
-
-		line2 = makeLine(point2, point3, 0.5);
-		plot.addToTail(line2);
+		std::vector<Expression> ys = parallelResults(xs.size(), env,
+			[&](std::size_t i, Environment & frame)
+		{
+			Expression yPoints(m_tail[0]);
+			yPoints.addToTail(Expression(Atom(xs[i])));
+			return yPoints.eval(frame);
+		});
+
+		std::vector<double> values(ys.size());
+		for (std::size_t i = 0; i < ys.size(); ++i)
+			values[i] = ys[i].head().asNumber();
+		return values;
+	};
+
+	std::vector<CurveSampler::Point> samples =
+		sampler.sample(xleft.head().asNumber(), xright.head().asNumber(), function);
+
+	std::vector<double> coordinates;
+	coordinates.reserve(2 * samples.size());
+	for (auto & sample : samples)
+	{
+		coordinates.push_back(sample.x);
+		coordinates.push_back(sample.y);
 	}
 
+	// now generate continuous plot
 
-	/*for (unsigned int i = 0; i < temp.size()-2; i += 2)
-	{
-		
-		Expression point1 = makePoint(xscaler*temp[i].head().asNumber(), -yscaler * temp[i + 1].head().asNumber(),0.0);
-		Expression point2 = makePoint(xscaler*temp[i+2].head().asNumber(), -yscaler * temp[i + 3].head().asNumber(),0.0);
-		Expression line = makeLine(point1, point2, 0.5);
-		plot.addToTail(line);
-	}*/
-
+	PlotFrame frame = plotFrame(coordinates);
+	Graphics graphics;
+	addPlotLayout(graphics, frame);
+	addPlotLabels(graphics, frame, labelProperties);
+	double xscaler = frame.xScale;
+	double yscaler = frame.yScale;
 
-	// combine  all the parameters in to one list
-	Expression continuousPlot(Atom("list"));
-	for (auto e = plotLayout.tailConstBegin(); e != plotLayout.tailConstEnd(); ++e)
-		continuousPlot.addToTail(*e);
-	for (auto e = plotLabels.tailConstBegin(); e != plotLabels.tailConstEnd(); ++e)
-		continuousPlot.addToTail(*e);
-	for (auto e = plot.tailConstBegin(); e != plot.tailConstEnd(); ++e)
-		continuousPlot.addToTail(*e);
+	// a line from each sample to the next
+	for (std::size_t i = 0; i + 1 < samples.size(); ++i)
+		graphics.addLine(xscaler*samples[i].x, -yscaler * samples[i].y,
+			xscaler*samples[i + 1].x, -yscaler * samples[i + 1].y, 0.5);
 
-	return continuousPlot;
+	return graphicsList(std::move(graphics));
 }
 
 
 std::pair<std::string, Expression> Expression::get_property(std::string const &property)
 {
-	//if (m_property.empty())
-		//throw SemanticError("Error: there is no assigned property");
-
-	auto targetProperty = m_property.find(property);
-	if (targetProperty == m_property.end())
+	if (!hasProperty(property))
 		return std::pair<std::string, Expression>("", Expression());
-	else
-		return std::pair<std::string, Expression>(targetProperty->first, targetProperty->second);
+	return std::pair<std::string, Expression>(property, this->property(property));
 }
 
 
 // this is a simple recursive version. the iterative version is more
 // difficult with the ast data structure used (no parent pointer).
 // this limits the practical depth of our AST
-Expression Expression::eval(Environment & env)
+Expression Expression::eval(Environment & env) const
 {
-	Environment copyEnv(env);
-
-	if (m_tail.empty() && m_head.asSymbol() != "list") {
+	if (m_tail.empty() && m_head.symbolId() != Symbols::List) {
 		return handle_lookup(m_head, env);
 	}
-	// handle begin special-form
-	else if (m_head.isSymbol() && m_head.asSymbol() == "begin") {
+
+	// a list of numbers evaluates to itself
+	if (m_head.symbolId() == Symbols::List && m_tail.packing() != Unpacked)
+		return tailList();
+
+	// special forms are dispatched on the interned id of the head
+	switch (m_head.symbolId()) {
+	case Symbols::Begin:
 		return handle_begin(env);
-	}
-	// handle define special-form
-	else if (m_head.isSymbol() && m_head.asSymbol() == "define") {
-		//defineUsed = true;
+	case Symbols::Define:
 		return handle_define(env);
-	}
-	else if (m_head.isSymbol() && m_head.asSymbol() == "lambda") {
+	case Symbols::Lambda:
 		return handle_lambda(env);
-	}
-	else if (m_head.isSymbol() && m_head.asSymbol() == "apply") {
+	case Symbols::Apply:
 		return handle_apply(env);
-	}
-	else if (m_head.isSymbol() && m_head.asSymbol() == "map") {
-		return handle_map(env);
-	}
-	else if (m_head.isSymbol() && m_head.asSymbol() == "set-property") {
+	case Symbols::Map:
+		return handle_map(env, false);
+	case Symbols::ParallelMap:
+		return handle_map(env, true);
+	case Symbols::SetProperty:
 		return handle_setProperty(env);
-	}
-	else if (m_head.isSymbol() && m_head.asSymbol() == "get-property") {
+	case Symbols::GetProperty:
 		return handle_getProperty(env);
-	}
-	else if (m_head.isSymbol() && m_head.asSymbol() == "discrete-plot") {
+	case Symbols::DiscretePlot:
 		return handle_discretePlot(env);
-	}
-	else if (m_head.isSymbol() && m_head.asSymbol() == "continuous-plot") {
+	case Symbols::ContinuousPlot:
 		return handle_continousPlot(env);
+	default:
+		break;
 	}
+
 	// else attempt to treat as procedure
-	else
-	{
-		// temporary empy expression 
-		Expression temp = env.get_exp(m_head);
 
-		// evaluating expression after lambda 	
-		if (env.is_known(m_head) && temp.m_head.asSymbol() == "lambda")
-		{
-			//unsigned in = temp.m_tail[0].listLength();
-			//if (temp.m_tail[0].listLength() != 1 && in != m_tail.size())
-			//	throw SemanticError("Error in Lambda: number of arguments don't match the number of parameters");
-
-			int tempSize = m_tail.size();
-			for (int input = 0; input < tempSize; ++input)
-			{
-				Expression post_Lamb_eval(Atom("define"));
-				post_Lamb_eval.addToTail(temp.m_tail[0].m_tail[input]);
-				post_Lamb_eval.addToTail(m_tail[input]);
-				post_Lamb_eval.eval(copyEnv);
-			}
+	// a call of a lambda binds the arguments, evaluated in the caller's
+	// environment, to the slots of a frame deferring everything else to it;
+	// holding the closure keeps the body alive should an argument rebind
+	// the head
+	std::shared_ptr<const Closure> closure = env.find_closure(m_head);
+	if (closure)
+	{
+		if (m_tail.size() > closure->arity())
+			throw SemanticError("Error in call to lambda: invalid number of arguments");
 
-			return temp.m_tail[1].eval(copyEnv);
-		} // end of lambda evaluation 
+		Environment frame(&env, *closure);
+		for (auto arg = m_tail.begin(); arg != m_tail.end(); ++arg)
+			frame.bind_param(arg->eval(env));
 
-		std::vector<Expression> results;
-		for (Expression::IteratorType it = m_tail.begin(); it != m_tail.end(); ++it) {
-			results.push_back(it->eval(env));
-		}
+		return closure->body().eval(frame);
+	} // end of lambda evaluation 
 
-		return apply(m_head, results, env);
+	std::vector<Expression> results;
+	results.reserve(m_tail.size());
+	for (auto it = m_tail.begin(); it != m_tail.end(); ++it) {
+		results.push_back(it->eval(env));
 	}
+
+	return apply(m_head, std::move(results), env);
 }
 
 
+// print primitive i of a graphics buffer as its element would print
+static void printGraphic(std::ostream & out, const Graphics & graphics, std::size_t i)
+{
+	switch (graphics.kind(i)) {
+	case Graphics::Point: {
+		Graphics::PointData p = graphics.point(i);
+		out << "((" << Atom(p.x) << ") (" << Atom(p.y) << "))";
+		break;
+	}
+	case Graphics::Line: {
+		Graphics::LineData l = graphics.line(i);
+		out << "(((" << Atom(l.x1) << ") (" << Atom(l.y1) << ")) (("
+			<< Atom(l.x2) << ") (" << Atom(l.y2) << ")))";
+		break;
+	}
+	case Graphics::Text:
+		out << "(\"" << graphics.text(i).text << "\")";
+		break;
+	}
+}
+
 std::ostream & operator<<(std::ostream & out, const Expression & exp) {
 
-	Environment env;
 	if (!exp.head().isNone())
 		out << "(";
 
 	if (exp.head().isStringLiteral())
 		out << "\"";
 
-	if (exp.head().asSymbol() != "lambda" && exp.head().asSymbol() != "list"
-		&& exp.head().asSymbol() != "define" && exp.head().asSymbol() != "begin")
+	SymbolId id = exp.head().symbolId();
+	bool keyword = (id == Symbols::Lambda) || (id == Symbols::List)
+		|| (id == Symbols::Define) || (id == Symbols::Begin);
+
+	if (!keyword)
 		out << exp.head();
 
 
-	if (env.is_proc(exp.head()) && exp.head().asSymbol() != "lambda" && exp.head().asSymbol() != "list"
-		&& exp.head().asSymbol() != "define" && exp.head().asSymbol() != "begin")
+	if (Environment::is_builtin_proc(exp.head()) && !keyword)
 		out << " ";
 
-	for (auto e = exp.tailConstBegin(); e != exp.tailConstEnd();) {
+	if (const Graphics * graphics = exp.graphics()) {
+		for (std::size_t i = 0; i < graphics->size(); ++i) {
+			if (i > 0)
+				out << " ";
+			printGraphic(out, *graphics, i);
+		}
+	}
+	else if (exp.tailPacking() != Expression::Unpacked) {
+		for (int i = 0; i < exp.listLength(); ++i) {
+			if (i > 0)
+				out << " ";
+			out << exp.listElement(i);
+		}
+	}
+	else {
+		for (auto e = exp.tailConstBegin(); e != exp.tailConstEnd();) {
 
-		out << *e;
-		++e;
-		if (e != exp.tailConstEnd())
-			out << " ";
+			out << *e;
+			++e;
+			if (e != exp.tailConstEnd())
+				out << " ";
+		}
 	}
 
 	if (exp.head().isStringLiteral())
@@ -910,11 +1635,19 @@ bool Expression::operator==(const Expression & exp) const noexcept {
 
 	result = result && (m_tail.size() == exp.m_tail.size());
 
-	if (result) {
-		for (auto lefte = m_tail.begin(), righte = exp.m_tail.begin();
-			(lefte != m_tail.end()) && (righte != exp.m_tail.end());
-			++lefte, ++righte) {
-			result = result && (*lefte == *righte);
+	// shared storage holds equal elements
+	if (result && !m_tail.sameStorage(exp.m_tail)) {
+		if (m_tail.packing() == Unpacked && exp.m_tail.packing() == Unpacked) {
+			for (auto lefte = m_tail.begin(), righte = exp.m_tail.begin();
+				(lefte != m_tail.end()) && (righte != exp.m_tail.end());
+				++lefte, ++righte) {
+				result = result && (*lefte == *righte);
+			}
+		}
+		else {
+			// packed elements are compared without unpacking them
+			for (std::size_t i = 0; result && i < m_tail.size(); ++i)
+				result = (m_tail.at(i) == exp.m_tail.at(i));
 		}
 	}
 
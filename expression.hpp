@@ -4,16 +4,20 @@ Defines the Expression type and assiciated functions.
 #ifndef EXPRESSION_HPP
 #define EXPRESSION_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
-#include <map>
 #include<iterator>
 #include<utility>
 #include <iomanip>
 //#include <sstream>
 
 #include "token.hpp"
+#include "arena.hpp"
 #include "atom.hpp"
+#include "graphics.hpp"
 #include "message_queue.h"
 
 // forward declare Environment
@@ -24,11 +28,39 @@ class Environment;
 
 An expression is an atom called the head followed by a (possibly empty) 
 list of expressions called the tail.
+
+Tails and property lists are reference counted and shared between copies,
+so copying an Expression is O(1) whatever its size. Shared storage is never
+modified: an Expression copies it before its first change (copy-on-write).
+They are allocated from the Arena current when they are created.
+
+The tail of a list of Numbers, or of Complex Numbers, may be packed: held
+as contiguous doubles, 8 bytes per Number and 16 per Complex Number,
+instead of as Expressions. A packed tail reads the same as any other:
+iterating over it unpacks the Expressions once, on first use, and
+appending an element that does not fit unpacks it for good. listLength,
+tailList, listElement, equality, printing and appending numbers work on
+the packed numbers directly.
+
+The list a plot evaluates to holds its points, lines and texts packed in
+a Graphics buffer the same way: its elements are built from the buffer on
+first use, while printing and graphics() read the buffer itself.
  */
 class Expression {
 public:
 
-  typedef std::vector<Expression>::const_iterator ConstIteratorType;
+  typedef std::vector<Expression, ArenaAllocator<Expression> >::const_iterator ConstIteratorType;
+
+  /// the storage of a packed tail, always on the heap
+  typedef std::vector<double> Numbers;
+
+  /// how the tail of an expression is held
+  enum Packing {
+    Unpacked,     ///< as Expressions
+    PackedReal,   ///< as the value of each Number
+    PackedComplex, ///< as the real then imaginary part of each Complex Number
+    PackedGraphics ///< as the primitives of a Graphics buffer
+  };
 
   /// Default construct and Expression, whose type in NoneType
   Expression();
@@ -38,12 +70,52 @@ public:
   */
   Expression(const Atom & a);
 
-  /// deep-copy construct an expression (recursive)
+  /// Construct an Expression taking over the given Atom as head
+  Expression(Atom && a);
+
+  /*! Construct an Expression with given head and tail
+    \param a the atom to make the head
+    \param tail the expressions of the tail, moved into the Expression
+  */
+  Expression(const Atom & a, std::vector<Expression> tail);
+
+  /*! Construct a list with a packed tail.
+    \param numbers the Numbers, or the real and imaginary parts of the
+    Complex Numbers, of the tail
+    \param complex true if the tail holds Complex Numbers
+    \return the list
+  */
+  static Expression packedList(Numbers numbers, bool complex = false);
+
+  /*! Construct a list of graphic primitives held in a buffer.
+    \param graphics the primitives, moved into the list
+    \return the list
+  */
+  static Expression graphicsList(Graphics graphics);
+
+  /*! Construct a list of the given elements, packed when they are all
+    Numbers or all Complex Numbers without tail or properties.
+    \param items the elements, moved into the list
+    \return the list
+  */
+  static Expression makeList(std::vector<Expression> items);
+
+  /// copy construct an expression, sharing its tail and properties
   Expression(const Expression & a);
 
-  /// deep-copy assign an expression  (recursive)
+  /// move construct an expression, leaving a empty
+  Expression(Expression && a) noexcept;
+
+  /// destroy an expression; subtrees are released without recursing
+  /// deeper than a fixed bound, so any depth can be destroyed
+  ~Expression();
+
+  /// copy assign an expression, sharing its tail and properties
   Expression & operator=(const Expression & a);
 
+  /// move assign an expression, leaving a empty
+  Expression & operator=(Expression && a) noexcept;
+
   /// return a reference to the head Atom
   Atom & head();
 
@@ -53,8 +125,18 @@ public:
   /// append Atom to tail of the expression
   void append(const Atom & a);
 
+  /// append Atom to tail of the expression, taking it over
+  void append(Atom && a);
+
+  /// append a copy of an Expression to the tail
   void addToTail(const Expression & a);
 
+  /// append an Expression to the tail, taking it over
+  void addToTail(Expression && a);
+
+  /// make room for n elements in the tail, so appending them allocates once
+  void reserveTail(std::size_t n);
+
   bool isListEmpty() const noexcept;
 
   int listLength() const noexcept;
@@ -62,11 +144,45 @@ public:
   /// return a pointer to the last expression in the tail, or nullptr
   Expression * tail();
 
-  /// return a const-iterator to the beginning of tail
-  ConstIteratorType tailConstBegin() const noexcept;
+  /// return a const-iterator to the beginning of tail, unpacking it
+  ConstIteratorType tailConstBegin() const;
+
+  /// return a const-iterator to the tail end, unpacking it
+  ConstIteratorType tailConstEnd() const;
+
+  /// how the tail is held
+  Packing tailPacking() const noexcept;
+
+  /// the first number of a packed tail, nullptr if the tail is not packed
+  /// as numbers
+  const double * packedTail() const noexcept;
 
-  /// return a const-iterator to the tail end
-  ConstIteratorType tailConstEnd() const noexcept;
+  /// the buffer the whole tail is packed in, nullptr if it is not
+  const Graphics * graphics() const noexcept;
+
+  /*! Get an element of the tail without unpacking it.
+    \param i the index of the element, less than listLength()
+    \return a copy of the element
+  */
+  Expression listElement(std::size_t i) const;
+
+  /*! Make a list of part of the tail, sharing its storage (O(1)).
+    \param first the index of the first element to keep
+    \return a list holding the tail from first on, without properties
+  */
+  Expression tailList(std::size_t first = 0) const;
+
+  /// identity of the tail storage: equal non-null ids mean equal tails
+  const void * tailId() const;
+
+  /// true if any property has been set on the expression
+  bool hasProperties() const noexcept;
+
+  /*! Copy the expression out of any arena, so that keeping it does not
+    keep the arena alive. Parts already on the heap stay shared.
+    \return the copy
+  */
+  Expression heapCopy() const;
 
   /// convienience member to determine if head atom is a number
   bool isHeadNumber() const noexcept;
@@ -75,15 +191,67 @@ public:
   bool isHeadSymbol() const noexcept;
 
   /// Evaluate expression using a post-order traversal (recursive)
-  Expression eval(Environment & env);
+  Expression eval(Environment & env) const;
 
   /// equality comparison for two expressions (recursive)
   bool operator==(const Expression & exp) const noexcept;
 
+  /*! \enum ObjectName
+  \brief The object-name of each graphic primitive, recognized when it is set
+         so that readers do not compare strings.
+  */
+  enum ObjectName {
+    NoObject,    ///< object-name is unset or names no graphic primitive
+    PointObject, ///< "point"
+    LineObject,  ///< "line"
+    TextObject,  ///< "text"
+    LabelObject  ///< "label"
+  };
+
+  /*! \enum GraphicProperty
+  \brief The numeric properties of the graphic primitives, held unboxed
+         when set to a plain number.
+  */
+  enum GraphicProperty {
+    SizeProperty,         ///< "size"
+    ThicknessProperty,    ///< "thickness"
+    TextScaleProperty,    ///< "text-scale"
+    TextRotationProperty, ///< "text-rotation"
+    NumGraphicProperties
+  };
+
+  /// the graphic primitive named by the object-name property, or NoObject
+  ObjectName objectName() const noexcept;
+
+  /*! Get a numeric graphic property without building an Expression.
+    \param property the property
+    \param value set to its value if it is a plain number
+    \return true if the property is set to a plain number
+  */
+  bool graphicProperty(GraphicProperty property, double & value) const noexcept;
+
+  /*! Determine if a property is set.
+    \param tag the name of the property
+    \return true if it is set, possibly to an Expression of NoneType
+  */
+  bool hasProperty(const std::string & tag) const;
+
+  /*! Get a property.
+    \param tag the name of the property
+    \return its value, or an Expression of NoneType if it is not set
+  */
+  Expression property(const std::string & tag) const;
+
   // returns the corresponding property of expression 
   std::pair<std::string, Expression> get_property(std::string const & target);
   void setProperty(std::string tag, Expression property);
 
+  /*! Replace the properties of the expression by those of another, sharing
+    them until either expression sets a property (O(1)).
+    \param other the expression to take the properties of
+  */
+  void shareProperties(const Expression & other);
+
 
 private:
 
@@ -91,28 +259,160 @@ private:
   Atom m_head;
   //Atom list_head;
 
+  // A view of the elements [offset, end) of a vector shared between
+  // expressions. The vector is copied before the first change made while
+  // it is shared or viewed from an offset.
+  typedef std::vector<Expression, ArenaAllocator<Expression> > TailVector;
+
+  // the vector of a Tail and the count of tails sharing it
+  struct TailBlock;
+
+  class Tail {
+  public:
+    typedef TailVector::const_iterator const_iterator;
+
+    Tail() noexcept: m_block(nullptr), m_offset(0) {}
+    explicit Tail(std::vector<Expression> && items);
+    Tail(Numbers && numbers, Packing packing);
+    explicit Tail(std::shared_ptr<const Graphics> && graphics);
+
+    Tail(const Tail & other) noexcept: m_block(other.m_block), m_offset(other.m_offset) {
+      if (m_block != nullptr)
+        retain();
+    }
+    Tail(Tail && other) noexcept: m_block(other.m_block), m_offset(other.m_offset) {
+      other.m_block = nullptr;
+      other.m_offset = 0;
+    }
+    ~Tail() {
+      if (m_block != nullptr)
+        release();
+    }
+
+    Tail & operator=(const Tail & other) noexcept;
+    Tail & operator=(Tail && other) noexcept;
+
+    std::size_t size() const noexcept;
+    bool empty() const noexcept { return size() == 0; }
+    const Expression & operator[](std::size_t i) const { return *(begin() + i); }
+
+    // iterating unpacks a packed tail
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    Packing packing() const noexcept;
+
+    // the numbers of a packed tail from the offset on, or nullptr
+    const double * numbers() const noexcept;
+
+    // the buffer of a tail packed as graphics from offset 0, or nullptr
+    const Graphics * graphics() const noexcept;
+
+    // element i, without unpacking
+    Expression at(std::size_t i) const;
+
+    // the view without its first n elements, sharing the vector
+    Tail dropFirst(std::size_t n) const;
+
+    // storage identity, nullptr when empty
+    const void * id() const;
+
+    // the view with storage allocated in an arena copied to the heap
+    Tail heapCopy() const;
+    bool sameStorage(const Tail & other) const noexcept {
+      return m_block == other.m_block && m_offset == other.m_offset;
+    }
+
+    // a number fitting a packed tail is appended to its numbers
+    void push_back(const Expression & exp) {
+      if (!pushNumber(exp))
+        items().push_back(exp);
+    }
+    void push_back(Expression && exp) {
+      if (!pushNumber(exp))
+        items().push_back(std::move(exp));
+    }
+    void reserve(std::size_t n) { items().reserve(n); }
+    void clear() noexcept;
+    Expression & back() { return items().back(); }
+
+  private:
+    TailBlock * m_block;
+    std::uint32_t m_offset;
+
+    // take or drop a reference to the block, which is not null; the last
+    // reference destroys it without recursing deeper than a fixed bound
+    void retain() const noexcept;
+    void release() noexcept;
+
+    // the vector, unshared and from offset 0, ready to modify
+    TailVector & items();
+
+    // append the number of exp to a packed tail it fits, and return true
+    bool pushNumber(const Expression & exp);
+  };
+
+  // The properties, allocated only when one is set. The object-name and
+  // numeric properties of the graphic primitives are held in fixed fields;
+  // any other property is keyed by its interned name.
+  struct PropertyTable;
+
+  // A counted reference to a PropertyTable shared between expressions, or
+  // nullptr when there are no properties. The table is copied before the
+  // first change made while it is shared.
+  class Properties {
+  public:
+    Properties() noexcept: m_table(nullptr) {}
+    Properties(const Properties & other) noexcept: m_table(other.m_table) {
+      if (m_table != nullptr)
+        retain();
+    }
+    Properties(Properties && other) noexcept: m_table(other.m_table) { other.m_table = nullptr; }
+    ~Properties() {
+      if (m_table != nullptr)
+        release();
+    }
+
+    Properties & operator=(const Properties & other) noexcept;
+    Properties & operator=(Properties && other) noexcept;
+
+    const PropertyTable * get() const noexcept { return m_table; }
+
+    // the table, unshared, ready to modify; created if there is none
+    PropertyTable & unshared();
+
+    // replace the table by one allocated on the heap, unless it already is
+    void moveToHeap();
+
+  private:
+    PropertyTable * m_table;
+
+    // take or drop a reference to the table, which is not null
+    void retain() const noexcept;
+    void release() noexcept;
+  };
+
   // the tail list is expressed as a vector for access efficiency
   // and cache coherence, at the cost of wasted memory.
-  std::vector<Expression> m_tail;
+  Tail m_tail;
 
-  // the property list stores all the property and types of those properties
-  // inside the map 
-  std::map <std::string, Expression > m_property;
+  // the properties, shared like the tail
+  Properties m_property;
+
+  Expression(const Atom & a, Tail tail);
 
-  // convenience typedef
-  typedef std::vector<Expression>::iterator IteratorType;
   
   // internal helper methods
-  Expression handle_lookup(const Atom & head, const Environment & env);
-  Expression handle_define(Environment & env);
-  Expression handle_begin(Environment & env);
-  Expression handle_lambda(Environment & env);
-  Expression handle_apply(Environment & env);
-  Expression handle_map(Environment & env);
-  Expression handle_setProperty(Environment & env);
-  Expression handle_getProperty(Environment & env);
-  Expression handle_discretePlot(Environment & env);
-  Expression handle_continousPlot(Environment & env);
+  Expression handle_lookup(const Atom & head, const Environment & env) const;
+  Expression handle_define(Environment & env) const;
+  Expression handle_begin(Environment & env) const;
+  Expression handle_lambda(Environment & env) const;
+  Expression handle_apply(Environment & env) const;
+  Expression handle_map(Environment & env, bool parallel) const;
+  Expression handle_setProperty(Environment & env) const;
+  Expression handle_getProperty(Environment & env) const;
+  Expression handle_discretePlot(Environment & env) const;
+  Expression handle_continousPlot(Environment & env) const;
 };
 
 /// Render expression to output stream
@@ -121,7 +421,16 @@ std::ostream & operator<<(std::ostream & out, const Expression & exp);
 /// inequality comparison for two expressions (recursive)
 bool operator!=(const Expression & left, const Expression & right) noexcept;
 
-Expression list(const std::vector<Expression> & args);
+Expression list(std::vector<Expression> args);
+
+/*! Call the built-in procedure a symbol names.
+  \param op the symbol
+  \param args the evaluated arguments
+  \param env the environment to look op up in
+  \return the result of the procedure
+  \throws SemanticError if op does not name a procedure, or from the procedure
+*/
+Expression apply(const Atom & op, std::vector<Expression> args, const Environment & env);
 
   
 #endif
@@ -1,5 +1,10 @@
 #include "catch.hpp"
 
+#include <complex>
+#include <sstream>
+#include <vector>
+
+#include "environment.hpp"
 #include "expression.hpp"
 
 TEST_CASE( "Test default expression", "[expression]" ) {
@@ -50,3 +55,181 @@ TEST_CASE("Test complex number expression", "[expression]")
 	REQUIRE(exp.head().isComplexNumber());
 }*/
 
+
+TEST_CASE("Test move expression", "[expression]")
+{
+  Expression exp(Atom("list"));
+  exp.append(Atom(1.0));
+  exp.addToTail(Expression(Atom(2.0)));
+  exp.setProperty("note", Expression(Atom(3.0)));
+  Expression copy(exp);
+
+  Expression moved(std::move(exp));
+  REQUIRE(moved == copy);
+  REQUIRE(moved.listLength() == 2);
+  REQUIRE(moved.get_property("note").second == Expression(3.0));
+  REQUIRE(exp.isListEmpty());
+
+  Expression assigned;
+  assigned = std::move(moved);
+  REQUIRE(assigned == copy);
+
+  std::vector<Expression> tail = {Expression(1.0), Expression(2.0)};
+  REQUIRE(Expression(Atom("list"), tail) == copy);
+}
+
+TEST_CASE("Test structural sharing", "[expression]")
+{
+  Expression exp(Atom("list"));
+  for (int i = 0; i < 5; ++i)
+    exp.append(Atom(double(i)));
+  exp.setProperty("note", Expression(Atom(1.0)));
+
+  INFO("copies share the tail");
+  Expression copy(exp);
+  REQUIRE(copy.tailId() == exp.tailId());
+
+  INFO("a modified copy leaves the original alone");
+  copy.append(Atom(5.0));
+  copy.setProperty("note", Expression(Atom(2.0)));
+  REQUIRE(copy.tailId() != exp.tailId());
+  REQUIRE(exp.listLength() == 5);
+  REQUIRE(copy.listLength() == 6);
+  REQUIRE(exp.get_property("note").second == Expression(1.0));
+  REQUIRE(copy.get_property("note").second == Expression(2.0));
+
+  INFO("tailList shares the remaining elements");
+  Expression rest = exp.tailList(1);
+  REQUIRE(rest.listLength() == 4);
+  REQUIRE(rest.tailId() == &*(exp.tailConstBegin() + 1));
+  REQUIRE(*rest.tailConstBegin() == Expression(1.0));
+  REQUIRE(rest.get_property("note").second == Expression());
+  REQUIRE(exp.tailList(5).isListEmpty());
+
+  rest.append(Atom(9.0));
+  REQUIRE(exp.listLength() == 5);
+  REQUIRE(rest.listLength() == 5);
+}
+
+TEST_CASE("Test graphic properties", "[expression]")
+{
+  Atom point("point"), circle("circle");
+  point.setStringLiteral();
+  circle.setStringLiteral();
+
+  Expression exp(Atom(1.0));
+  double value = -1;
+  REQUIRE(exp.objectName() == Expression::NoObject);
+  REQUIRE(!exp.graphicProperty(Expression::SizeProperty, value));
+  REQUIRE(!exp.hasProperties());
+
+  INFO("the names of the primitives and plain numbers are held unboxed");
+  exp.setProperty("object-name", Expression(point));
+  exp.setProperty("size", Expression(2.0));
+  REQUIRE(exp.objectName() == Expression::PointObject);
+  REQUIRE(exp.graphicProperty(Expression::SizeProperty, value));
+  REQUIRE(value == 2.0);
+  REQUIRE(exp.property("object-name") == Expression(point));
+  REQUIRE(exp.property("size") == Expression(2.0));
+  REQUIRE(exp.get_property("size").first == "size");
+  REQUIRE(!exp.graphicProperty(Expression::ThicknessProperty, value));
+
+  INFO("other values of well-known properties are kept as they are");
+  Expression sizes(Atom("list"));
+  sizes.append(Atom(1.0));
+  exp.setProperty("size", sizes);
+  exp.setProperty("object-name", Expression(circle));
+  REQUIRE(!exp.graphicProperty(Expression::SizeProperty, value));
+  REQUIRE(exp.property("size") == sizes);
+  REQUIRE(exp.objectName() == Expression::NoObject);
+  REQUIRE(exp.property("object-name") == Expression(circle));
+
+  exp.setProperty("size", Expression(3.0));
+  REQUIRE(exp.graphicProperty(Expression::SizeProperty, value));
+  REQUIRE(value == 3.0);
+  REQUIRE(exp.property("size") == Expression(3.0));
+
+  INFO("unset properties, and properties set to nothing");
+  REQUIRE(exp.property("thickness") == Expression());
+  REQUIRE(exp.get_property("thickness").first == "");
+  exp.setProperty("note", Expression());
+  REQUIRE(exp.get_property("note").first == "note");
+  REQUIRE(exp.get_property("other").first == "");
+
+  INFO("copies share the properties until one is set");
+  Expression copy(exp);
+  copy.setProperty("size", Expression(4.0));
+  copy.setProperty("object-name", Expression(point));
+  REQUIRE(exp.property("size") == Expression(3.0));
+  REQUIRE(exp.objectName() == Expression::NoObject);
+  REQUIRE(copy.property("size") == Expression(4.0));
+  REQUIRE(copy.objectName() == Expression::PointObject);
+  REQUIRE(copy.property("note") == Expression());
+  REQUIRE(copy.get_property("note").first == "note");
+}
+
+TEST_CASE("Test packed lists", "[expression]")
+{
+  Expression::Numbers numbers = {1, 2, 3};
+  Expression packed = Expression::packedList(numbers);
+
+  std::vector<Expression> items = {Expression(1.), Expression(2.), Expression(3.)};
+  Expression unpacked(Atom("list"), items);
+
+  REQUIRE(packed.tailPacking() == Expression::PackedReal);
+  REQUIRE(unpacked.tailPacking() == Expression::Unpacked);
+  REQUIRE(packed.listLength() == 3);
+  REQUIRE(packed.packedTail()[2] == 3);
+  REQUIRE(unpacked.packedTail() == nullptr);
+
+  INFO("a packed list reads like any other");
+  REQUIRE(packed == unpacked);
+  REQUIRE(unpacked == packed);
+  REQUIRE(packed.listElement(1) == Expression(2.));
+  std::ostringstream out;
+  out << packed;
+  REQUIRE(out.str() == "((1) (2) (3))");
+  REQUIRE(*(packed.tailConstBegin() + 2) == Expression(3.));
+  REQUIRE(packed.tailPacking() == Expression::PackedReal);
+
+  INFO("views and copies share the numbers");
+  Expression rest = packed.tailList(1);
+  REQUIRE(rest.packedTail() == packed.packedTail() + 1);
+  REQUIRE(rest == Expression::packedList({2, 3}));
+
+  INFO("appending a number keeps a list packed, a copy apart");
+  Expression appended = rest;
+  appended.addToTail(Expression(4.));
+  REQUIRE(appended.tailPacking() == Expression::PackedReal);
+  REQUIRE(appended == Expression::packedList({2, 3, 4}));
+  REQUIRE(rest.listLength() == 2);
+  REQUIRE(packed.listLength() == 3);
+
+  INFO("appending anything else unpacks it");
+  appended.addToTail(Expression(Atom("a")));
+  REQUIRE(appended.tailPacking() == Expression::Unpacked);
+  REQUIRE(appended.listLength() == 4);
+  REQUIRE(appended.listElement(2) == Expression(4.));
+  REQUIRE(appended.listElement(3) == Expression(Atom("a")));
+
+  INFO("complex numbers pack in pairs");
+  Expression complex = Expression::makeList({Expression(std::complex<double>(1, 2)),
+    Expression(std::complex<double>(3, 4))});
+  REQUIRE(complex.tailPacking() == Expression::PackedComplex);
+  REQUIRE(complex.listLength() == 2);
+  REQUIRE(complex.packedTail()[3] == 4);
+  REQUIRE(complex.listElement(1) == Expression(std::complex<double>(3, 4)));
+
+  INFO("mixed elements and properties are not packed");
+  REQUIRE(Expression::makeList({Expression(1.), Expression(std::complex<double>(1, 2))})
+    .tailPacking() == Expression::Unpacked);
+  Expression marked(1.);
+  marked.setProperty("note", Expression(2.));
+  REQUIRE(Expression::makeList({Expression(1.), marked}).tailPacking() == Expression::Unpacked);
+  REQUIRE(Expression::makeList({}).isListEmpty());
+
+  INFO("a packed list evaluates to itself");
+  Environment env;
+  REQUIRE(packed.eval(env) == packed);
+  REQUIRE(packed.eval(env).packedTail() == packed.packedTail());
+}
@@ -0,0 +1,70 @@
+#include "graphics.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+void Graphics::addPoint(double x, double y, double size) {
+  order(Point, m_pointStyles.size());
+  m_points.push_back(x);
+  m_points.push_back(y);
+  m_pointStyles.push_back(style(size, 0));
+}
+
+void Graphics::addLine(double x1, double y1, double x2, double y2, double thickness) {
+  order(Line, m_lineStyles.size());
+  m_lines.push_back(x1);
+  m_lines.push_back(y1);
+  m_lines.push_back(x2);
+  m_lines.push_back(y2);
+  m_lineStyles.push_back(style(thickness, 0));
+}
+
+void Graphics::addText(const std::string & text, double x, double y, double scale, double rotation) {
+  order(Text, m_textStyles.size());
+  m_texts.push_back(x);
+  m_texts.push_back(y);
+  m_textStyles.push_back(style(scale, rotation));
+  m_characters += text;
+  m_textEnds.push_back(static_cast<std::uint32_t>(m_characters.size()));
+}
+
+Graphics::PointData Graphics::point(std::size_t i) const noexcept {
+  std::size_t k = m_order[i] & IndexMask;
+  return PointData{m_points[2 * k], m_points[2 * k + 1], m_styles[m_pointStyles[k]].width};
+}
+
+Graphics::LineData Graphics::line(std::size_t i) const noexcept {
+  std::size_t k = m_order[i] & IndexMask;
+  const double * ends = &m_lines[4 * k];
+  return LineData{ends[0], ends[1], ends[2], ends[3], m_styles[m_lineStyles[k]].width};
+}
+
+Graphics::TextData Graphics::text(std::size_t i) const {
+  std::size_t k = m_order[i] & IndexMask;
+  std::size_t begin = k > 0 ? m_textEnds[k - 1] : 0;
+  const Style & s = m_styles[m_textStyles[k]];
+  return TextData{m_characters.substr(begin, m_textEnds[k] - begin),
+    m_texts[2 * k], m_texts[2 * k + 1], s.width, s.rotation};
+}
+
+std::uint32_t Graphics::style(double width, double rotation) {
+
+  // plots use a handful of styles, and mostly the last one again; they are
+  // compared bit for bit, so that -0 is kept apart from 0
+  for (std::size_t s = m_styles.size(); s > 0; --s) {
+    const Style & candidate = m_styles[s - 1];
+    if (std::memcmp(&candidate.width, &width, sizeof width) == 0
+      && std::memcmp(&candidate.rotation, &rotation, sizeof rotation) == 0)
+      return static_cast<std::uint32_t>(s - 1);
+    if (m_styles.size() - s >= 8)
+      break;
+  }
+  m_styles.push_back(Style{width, rotation});
+  return static_cast<std::uint32_t>(m_styles.size() - 1);
+}
+
+void Graphics::order(Kind kind, std::size_t index) {
+  if (index > IndexMask)
+    throw std::length_error("Graphics: too many primitives of one kind");
+  m_order.push_back(static_cast<std::uint32_t>(kind) << KindShift | static_cast<std::uint32_t>(index));
+}
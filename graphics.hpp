@@ -0,0 +1,106 @@
+/*! \file graphics.hpp
+Defines the flat buffer of graphic primitives the plot procedures produce.
+ */
+#ifndef GRAPHICS_HPP
+#define GRAPHICS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*! \class Graphics
+\brief Points, lines and texts in drawing order, held as arrays of numbers
+       rather than as Expressions.
+
+Each kind of primitive keeps its coordinates in one array and refers to its
+style (the size of a point, the thickness of a line, the scale and rotation
+of a text) by its index in a small table of the styles used, so adding a
+primitive allocates nothing once the arrays have grown. The characters of
+all texts are kept in one string.
+
+A list may hold a Graphics as its tail (see Expression::graphicsList): it
+then reads as the list of the primitives make-point, make-line and
+make-text would build, without building them unless asked for an element.
+ */
+class Graphics {
+public:
+
+  /// the kinds of primitives
+  enum Kind : unsigned char { Point, Line, Text };
+
+  /// a point: its position and size
+  struct PointData {
+    double x, y, size;
+  };
+
+  /// a line: its ends and thickness
+  struct LineData {
+    double x1, y1, x2, y2, thickness;
+  };
+
+  /// a text: its characters, the position of its center, its scale and rotation
+  struct TextData {
+    std::string text;
+    double x, y, scale, rotation;
+  };
+
+  /// add a point, drawn after those added before
+  void addPoint(double x, double y, double size);
+
+  /// add a line, drawn after those added before
+  void addLine(double x1, double y1, double x2, double y2, double thickness);
+
+  /// add a text, drawn after those added before
+  void addText(const std::string & text, double x, double y, double scale, double rotation);
+
+  /// the number of primitives
+  std::size_t size() const noexcept { return m_order.size(); }
+
+  /// the kind of primitive i
+  Kind kind(std::size_t i) const noexcept { return static_cast<Kind>(m_order[i] >> KindShift); }
+
+  /// primitive i, which is a point
+  PointData point(std::size_t i) const noexcept;
+
+  /// primitive i, which is a line
+  LineData line(std::size_t i) const noexcept;
+
+  /// primitive i, which is a text
+  TextData text(std::size_t i) const;
+
+  /// the number of distinct styles used
+  std::size_t styles() const noexcept { return m_styles.size(); }
+
+private:
+
+  static const unsigned KindShift = 30;
+  static const std::uint32_t IndexMask = (1u << KindShift) - 1;
+
+  struct Style {
+    double width;    // size, thickness or scale
+    double rotation; // of a text
+  };
+
+  // the kind and index within its kind of each primitive, in drawing order
+  std::vector<std::uint32_t> m_order;
+
+  std::vector<double> m_points;         // x, y of each point
+  std::vector<std::uint32_t> m_pointStyles;
+  std::vector<double> m_lines;          // x1, y1, x2, y2 of each line
+  std::vector<std::uint32_t> m_lineStyles;
+  std::vector<double> m_texts;          // x, y of each text
+  std::vector<std::uint32_t> m_textStyles;
+  std::vector<std::uint32_t> m_textEnds; // where the characters of each text end
+  std::string m_characters;
+
+  std::vector<Style> m_styles;
+
+  // the index of a style, added if it is new
+  std::uint32_t style(double width, double rotation);
+
+  // record the next primitive of a kind, count of that kind before it
+  void order(Kind kind, std::size_t index);
+};
+
+#endif
@@ -0,0 +1,56 @@
+#include "bench.hpp"
+
+#include <sstream>
+#include <string>
+
+#include "interpreter.hpp"
+
+// the definitions the start-up file made before the graphic primitives were
+// built in, under other names
+static const std::string interpreted = "(begin"
+  " (define old-point (lambda (x y) (set-property \"size\" 0 (set-property \"object-name\" \"point\" (list x y)))))"
+  " (define old-line (lambda (p1 p2) (set-property \"thickness\" 1 (set-property \"object-name\" \"line\" (list p1 p2)))))"
+  " (define old-text (lambda (str) (set-property \"text-rotation\" 0 (set-property \"text-scale\" 1"
+  " (set-property \"position\" (define location (old-point 0 0)) (set-property \"object-name\" \"text\" (str)))))))"
+  ")";
+
+// the mean time of one evaluation of program, after the interpreted
+// definitions, over 10 evaluations
+static double timeProgram(Bench & bench, const std::string & label, const std::string & program) {
+
+  Interpreter interp;
+  std::istringstream definitions(interpreted);
+  interp.parseStream(definitions);
+  interp.evaluate();
+
+  std::istringstream iss(program);
+  interp.parseStream(iss);
+
+  return bench.run(label, 10, [&] {
+    doNotOptimize(interp.evaluate());
+  });
+}
+
+// drawing 10k lines between points and 10k texts through the built-in
+// primitives and through the lambdas they replace
+BENCHMARK_CASE(graphic_primitives) {
+
+  const std::string points = "(range 0 9999 1)";
+  const double count = 1e4;
+
+  for (auto prefix : { "make-", "old-" }) {
+    const std::string point = std::string(prefix) + "point";
+    const std::string line = std::string(prefix) + "line";
+    const std::string text = std::string(prefix) + "text";
+    const std::string suffix = prefix == std::string("make-") ? " (native)" : " (interpreted)";
+
+    double lines = timeProgram(bench, "10k lines" + suffix,
+      "(begin (define draw (lambda (x) (" + line + " (" + point + " x 0) (" + point + " x x))))"
+      " (map draw " + points + "))");
+    bench.report("per line" + suffix, lines / count, "ns");
+
+    double texts = timeProgram(bench, "10k texts" + suffix,
+      "(map " + text + " " + points + ")");
+    bench.report("per text" + suffix, texts / count, "ns");
+  }
+}
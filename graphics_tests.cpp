@@ -0,0 +1,59 @@
+#include "catch.hpp"
+
+#include <cmath>
+
+#include "graphics.hpp"
+
+TEST_CASE("Test graphics keeps primitives in order", "[graphics]") {
+
+  Graphics graphics;
+  graphics.addLine(0, 1, 2, 3, 0.5);
+  graphics.addText("title", -1, -2, 2, 0.25);
+  graphics.addPoint(4, 5, 0.5);
+  graphics.addText("", 6, 7, 1, 0);
+  graphics.addText("y", 8, 9, 1, 0);
+
+  REQUIRE(graphics.size() == 5);
+  REQUIRE(graphics.kind(0) == Graphics::Line);
+  REQUIRE(graphics.kind(1) == Graphics::Text);
+  REQUIRE(graphics.kind(2) == Graphics::Point);
+
+  Graphics::LineData l = graphics.line(0);
+  REQUIRE(l.x1 == 0);
+  REQUIRE(l.y1 == 1);
+  REQUIRE(l.x2 == 2);
+  REQUIRE(l.y2 == 3);
+  REQUIRE(l.thickness == 0.5);
+
+  Graphics::TextData t = graphics.text(1);
+  REQUIRE(t.text == "title");
+  REQUIRE(t.x == -1);
+  REQUIRE(t.y == -2);
+  REQUIRE(t.scale == 2);
+  REQUIRE(t.rotation == 0.25);
+
+  Graphics::PointData p = graphics.point(2);
+  REQUIRE(p.x == 4);
+  REQUIRE(p.y == 5);
+  REQUIRE(p.size == 0.5);
+
+  REQUIRE(graphics.text(3).text == "");
+  REQUIRE(graphics.text(4).text == "y");
+}
+
+TEST_CASE("Test graphics shares styles", "[graphics]") {
+
+  Graphics graphics;
+  for (int i = 0; i < 1000; ++i) {
+    graphics.addLine(i, 0, i, i, 0);
+    graphics.addPoint(i, i, 0.5);
+  }
+  REQUIRE(graphics.size() == 2000);
+  REQUIRE(graphics.styles() == 2);
+
+  // -0 is drawn as 0, but prints differently, so it is kept apart
+  graphics.addPoint(0, 0, -0.0);
+  REQUIRE(graphics.styles() == 3);
+  REQUIRE(std::signbit(graphics.point(2000).size));
+  REQUIRE(!std::signbit(graphics.line(0).thickness));
+}
@@ -1,33 +1,150 @@
 #include "interpreter.hpp"
 
 // system includes
+#include <iterator>
+#include <sstream>
 #include <stdexcept>
+#include <utility>
 
 // module includes
+#include "arena.hpp"
 #include "token.hpp"
 #include "parse.hpp"
 #include "expression.hpp"
 #include "environment.hpp"
+#include "optimize.hpp"
 #include "semantic_error.hpp"
 
 bool Interpreter::parseStream(std::istream & expression) noexcept {
 
-	TokenSequenceType tokens = tokenize(expression);
+	std::string text((std::istreambuf_iterator<char>(expression)), std::istreambuf_iterator<char>());
 
+	return parseBuffer(text.data(), text.data() + text.size());
+};
+
+bool Interpreter::parseBuffer(const char * begin, const char * end) noexcept {
+
+	Tokenizer tokens(begin, end);
+
+	// the AST keeps the arena of its parse alive
+	ArenaScope scope(arenas ? std::make_shared<Arena>() : nullptr);
 
 	ast = parse(tokens);
+	optimize();
 
 	return (ast != Expression());
-};
+}
 
+ParseResult Interpreter::parseNext(StreamParser & input) noexcept {
+
+	ArenaScope scope(arenas ? std::make_shared<Arena>() : nullptr);
+
+	ParseResult result = input.next(ast);
+	optimize();
+
+	return result;
+}
+
+
+void Interpreter::setMode(EvalMode newMode) noexcept {
+	mode = newMode;
+}
+
+void Interpreter::useArenas(bool enable) noexcept {
+	arenas = enable;
+}
+
+void Interpreter::useFolding(bool enable) noexcept {
+	folding = enable;
+}
+
+std::size_t Interpreter::foldedNodes() const noexcept {
+	return folded;
+}
+
+void Interpreter::optimize() {
+
+	program.reset();
+	folded = 0;
+	if (folding && ast != Expression())
+		folded = foldConstants(ast, env);
+}
 
 Expression Interpreter::evaluate() {
 
-	return ast.eval(env);
+	// temporaries are released with the arena; the result keeps it alive
+	// until the consumer lets go of it
+	ArenaScope scope(arenas ? std::make_shared<Arena>() : nullptr);
+
+	switch (mode) {
+	case BytecodeMode:
+		return evaluateBytecode(env);
+	case DifferentialMode:
+		return evaluateDifferential();
+	case StackMode:
+		return stack.run(ast, env);
+	default:
+		return ast.eval(env);
+	}
+}
+
+Expression Interpreter::evaluateBytecode(Environment & target) {
+
+	if (!program)
+		program = compileProgram(ast, target);
+
+	return vm.run(program, target);
+}
+
+Expression Interpreter::evaluateDifferential() {
+
+	// the VM runs on a copy so both evaluators start from the same bindings
+	Environment shadow(env);
+
+	Expression treeResult, vmResult;
+	bool treeThrew = false, vmThrew = false;
+	std::string treeError, vmError;
+
+	try {
+		treeResult = ast.eval(env);
+	}
+	catch (const SemanticError & ex) {
+		treeThrew = true;
+		treeError = ex.what();
+	}
+
+	try {
+		vmResult = evaluateBytecode(shadow);
+	}
+	catch (const SemanticError & ex) {
+		vmThrew = true;
+		vmError = ex.what();
+	}
+
+	if (treeThrew != vmThrew || treeError != vmError || !(treeResult == vmResult)) {
+		std::ostringstream msg;
+		msg << "Differential evaluation mismatch: tree walker gave ";
+		if (treeThrew) msg << "\"" << treeError << "\""; else msg << treeResult;
+		msg << ", bytecode gave ";
+		if (vmThrew) msg << "\"" << vmError << "\""; else msg << vmResult;
+		throw std::logic_error(msg.str());
+	}
+
+	if (treeThrew)
+		throw SemanticError(treeError);
+
+	return treeResult;
+}
+
+void Interpreter::load(const Prelude & prelude) {
+
+	env.add_all(prelude.environment());
+	program.reset();
 }
 
 void Interpreter::clear() {
 	env.reset();
+	program.reset();
 }
 
 void Interpreter::interrupt() {
@@ -48,18 +165,15 @@ void Interpreter::Kernal()
 	{
 		std::string inputMsg;
 		inputMessage.wait_and_pop(inputMsg);
-		std::istringstream expression(inputMsg);
-
-
 		if (inputMsg == "%stop" || inputMsg == "%exit" || inputMsg == "%reset")
 		{
 			break;
 		}
 
-		if (!parseStream(expression)) {
+		if (!parseBuffer(inputMsg.data(), inputMsg.data() + inputMsg.size())) {
 			outputMsg.isExpression = false;
 			outputMsg.error = "Error: Invalid Expression. Could not parse.";
-			outputMessage.push(outputMsg);
+			outputMessage.push(std::move(outputMsg));
 
 		}
 		else
@@ -67,7 +181,7 @@ void Interpreter::Kernal()
 			try {
 				outputMsg.expMsg = evaluate();
 				outputMsg.isExpression = true;
-				outputMessage.push(outputMsg);
+				outputMessage.push(std::move(outputMsg));
 				continue;
 
 			}
@@ -75,7 +189,7 @@ void Interpreter::Kernal()
 			{
 				outputMsg.isExpression = false;
 				outputMsg.error = ex.what();
-				outputMessage.push(outputMsg);
+				outputMessage.push(std::move(outputMsg));
 
 			}
 		}
@@ -8,13 +8,20 @@ It maintains an environment during evaluation.
 #define INTERPRETER_HPP
 
 // system includes
+#include <cstddef>
 #include <istream>
+#include <memory>
 #include <string>
 
 // module includes
+#include "bytecode.hpp"
 #include "environment.hpp"
+#include "evaluator.hpp"
 #include "expression.hpp"
 #include "message_queue.h"
+#include "parse.hpp"
+#include "prelude.hpp"
+#include "vm.hpp"
 
 struct messageOut
 {
@@ -39,12 +46,57 @@ The eval method updates Environment and returns last result.
 class Interpreter {
 public:
 
+  /*! \enum EvalMode
+  \brief How evaluate runs the AST.
+  */
+  enum EvalMode {
+    TreeWalkMode,    ///< walk the Expression tree (the reference evaluator)
+    BytecodeMode,    ///< compile to bytecode and run it on the VirtualMachine
+    DifferentialMode, ///< run both and throw std::logic_error if they disagree
+    StackMode        ///< walk the tree on the StackEvaluator, to any depth
+  };
+
+  /*! Select how evaluate runs the AST, TreeWalkMode by default.
+    \param mode the evaluation mode
+   */
+  void setMode(EvalMode mode) noexcept;
+
+  /*! Select whether each parse and each evaluation allocates its
+    expressions from a fresh Arena (the default) or from the heap.
+    \param enable true to use arenas
+   */
+  void useArenas(bool enable) noexcept;
+
+  /*! Select whether each parsed expression goes through foldConstants
+    before it is evaluated (the default).
+    \param enable true to fold constants
+   */
+  void useFolding(bool enable) noexcept;
+
+  /// the number of nodes foldConstants replaced in the last parsed expression
+  std::size_t foldedNodes() const noexcept;
+
   /*! Parse into an internal Expression from a stream
     \param expression the raw text stream repreenting the candidate expression
     \return true on successful parsing 
    */
   bool parseStream(std::istream &expression) noexcept;
 
+  /*! Parse into an internal Expression from the characters in [begin, end),
+    tokenizing them in place
+    \param begin the first character of the candidate expression
+    \param end one past the last character
+    \return true on successful parsing
+   */
+  bool parseBuffer(const char * begin, const char * end) noexcept;
+
+  /*! Parse into an internal Expression the next top-level expression of a
+    stream holding any number of them
+    \param input the parser reading the stream
+    \return whether an expression was parsed, was invalid or the input ended
+   */
+  ParseResult parseNext(StreamParser & input) noexcept;
+
   /*! Evaluate the Expression by walking the tree, returning the result.
     \return the Expression resulting from the evaluation in the current environment
     \throws SemanticError when a semantic error is encountered
@@ -52,16 +104,39 @@ public:
   Expression evaluate();
   void interrupt();
 
+  /*! Add the definitions made by a prelude to the environment, as if its
+    program had been evaluated in a default environment.
+    \param prelude the prelude, which must have been evaluated without error
+   */
+  void load(const Prelude & prelude);
+
   void Kernal();//inputQueue input);
   void clear();
 
 private:
 
+  // a Prelude evaluates its program in an interpreter and keeps the
+  // resulting environment
+  friend class Prelude;
+
   // the environment
   Environment env;
 
   // the AST
   Expression ast;
+
+  // evaluation mode, the bytecode of ast (compiled on demand) and its VM
+  EvalMode mode = TreeWalkMode;
+  bool arenas = true;
+  bool folding = true;
+  std::size_t folded = 0;
+  std::shared_ptr<Function> program;
+  VirtualMachine vm;
+  StackEvaluator stack;
+
+  void optimize();
+  Expression evaluateBytecode(Environment & target);
+  Expression evaluateDifferential();
 };
 
 #endif
@@ -1,20 +1,27 @@
 #include "catch.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <sstream>
 #include <fstream>
 #include <iostream>
 #include <thread>
+#include <vector>
 
 #include "semantic_error.hpp"
 #include "interpreter.hpp"
 #include "expression.hpp"
+#include "prelude.hpp"
+#include "startup_config.hpp"
+#include "thread_pool.hpp"
 
 Expression run(const std::string & program){
   
   std::istringstream iss(program);
     
   Interpreter interp;
+  interp.setMode(Interpreter::DifferentialMode);
     
   bool ok = interp.parseStream(iss);
   if(!ok){
@@ -99,6 +106,29 @@ TEST_CASE( "Test Interpreter parser with extra input", "[interpreter]" ) {
   REQUIRE(ok == false);
 }
 
+TEST_CASE( "Test Interpreter parsing a stream one expression at a time", "[interpreter]" ) {
+
+  std::string program = "(define r 10)\n(* pi (* r r))\n(r r)\n(- r 1)\n";
+  std::istringstream iss(program);
+  StreamParser input(iss);
+
+  Interpreter interp;
+
+  REQUIRE(interp.parseNext(input) == ParsedExpression);
+  REQUIRE(interp.evaluate() == Expression(10.));
+
+  REQUIRE(interp.parseNext(input) == ParsedExpression);
+  REQUIRE(interp.evaluate() == Expression(std::atan2(0, -1) * 100));
+
+  REQUIRE(interp.parseNext(input) == ParsedExpression);
+  REQUIRE_THROWS_AS(interp.evaluate(), SemanticError);
+
+  REQUIRE(interp.parseNext(input) == ParsedExpression);
+  REQUIRE(interp.evaluate() == Expression(9.));
+
+  REQUIRE(interp.parseNext(input) == EndOfInput);
+}
+
 TEST_CASE( "Test Interpreter parser with single non-keyword", "[interpreter]" ) {
 
   std::string program = "hello";
@@ -326,6 +356,249 @@ TEST_CASE("Test lambda functions", "[interpreter]")
 
 
 }
+TEST_CASE("Test lambda call frames", "[interpreter]")
+{
+	// parameters without an argument are looked up in the caller
+	REQUIRE(run("(begin (define y 10) (define f (lambda (x y) (+ x y))) (f 1))") == Expression(11.));
+
+	// a definition in the body rebinds a parameter for the rest of the call
+	REQUIRE(run("(begin (define f (lambda (x) (begin (define x (* x 2)) x))) (f 4))") == Expression(8.));
+
+	// a lambda passed as an argument is called through the parameter
+	REQUIRE(run("(begin (define sq (lambda (x) (* x x))) (define twice (lambda (g x) (g (g x)))) (twice sq 3))")
+		== Expression(81.));
+
+	// calls see the bindings of their caller
+	REQUIRE(run("(begin (define g (lambda (x) (* x y))) (define h (lambda (y) (g 2))) (map h (list 1 2)))")
+		== run("(list 2 4)"));
+
+	Interpreter interp;
+	std::istringstream iss("(begin (define f (lambda (x) x)) (f 1 2))");
+	REQUIRE(interp.parseStream(iss));
+	REQUIRE_THROWS_AS(interp.evaluate(), SemanticError);
+}
+
+TEST_CASE("Test lambda call rebinding its own name", "[interpreter]")
+{
+	// the call uses the lambda bound when it started
+	std::string program = "(begin (define f (lambda (x) (+ x 1))) (f (define f 3)))";
+	Expression result = run(program);
+	REQUIRE(result == Expression(4.));
+}
+
+TEST_CASE("Test loading a prelude", "[interpreter]")
+{
+  // the value of program in interp, printed
+  auto value = [](Interpreter & interp, const std::string & program) {
+    std::istringstream iss(program);
+    REQUIRE(interp.parseStream(iss));
+    std::ostringstream out;
+    out << interp.evaluate();
+    return out.str();
+  };
+
+  const Prelude startup(STARTUP_SOURCE);
+  REQUIRE(startup.ok());
+  REQUIRE(startup.result().head().symbolId() == Symbols::Lambda);
+
+  {
+    INFO("the prelude defines what evaluating its program does");
+    Interpreter loaded, evaluated;
+    loaded.load(startup);
+    value(evaluated, STARTUP_SOURCE);
+    for (auto program : { "(get-property \"size\" (make-point 1 2))",
+                          "(make-line (make-point 0 0) (make-point 1 1))",
+                          "(get-property \"position\" (make-text \"hi\"))",
+                          "(get-property \"object-name\" (make-label \"hi\"))" }) {
+      INFO(program);
+      REQUIRE(value(loaded, program) == value(evaluated, program));
+    }
+  }
+
+  {
+    INFO("definitions made after loading do not reach the prelude");
+    Interpreter first, second;
+    first.load(startup);
+    value(first, "(define one 1)");
+    first.clear();
+    first.load(startup);
+    second.load(startup);
+    REQUIRE_THROWS_AS(value(first, "(one)"), SemanticError);
+    REQUIRE_THROWS_AS(value(second, "(one)"), SemanticError);
+    REQUIRE(value(first, "(get-property \"size\" (make-point 1 2))") == "(0)");
+    REQUIRE(!startup.environment().is_known(Atom("one")));
+  }
+
+  {
+    INFO("a program that fails leaves an empty prelude");
+    Prelude unparsed("(begin");
+    REQUIRE(!unparsed.ok());
+    REQUIRE(unparsed.error() == "Error: Invalid Program. Could not parse.");
+
+    Prelude failed("(begin (define a 1) (undefined 2))");
+    REQUIRE(!failed.ok());
+    REQUIRE(failed.result() == Expression());
+    REQUIRE(!failed.environment().is_known(Atom("a")));
+  }
+}
+
+TEST_CASE("Test numeric lists are packed", "[interpreter]")
+{
+  {
+    INFO("range, list and map of numbers pack their results");
+    REQUIRE(run("(range 0 3 1)").tailPacking() == Expression::PackedReal);
+    REQUIRE(run("(list 1 2)").tailPacking() == Expression::PackedReal);
+    REQUIRE(run("(list I I)").tailPacking() == Expression::PackedComplex);
+    REQUIRE(run("(map sqrt (list 4 9))").tailPacking() == Expression::PackedReal);
+    REQUIRE(run("(map sqrt (list -4 -9))").tailPacking() == Expression::PackedComplex);
+    REQUIRE(run("(begin (define f (lambda (x) (* 2 x))) (map f (range 0 3 1)))")
+      == Expression::packedList({0, 2, 4, 6}));
+    REQUIRE(run("(join (range 0 1 1) (list 2))").tailPacking() == Expression::PackedReal);
+    REQUIRE(run("(append (rest (range 0 2 1)) 3)") == Expression::packedList({1, 2, 3}));
+  }
+
+  {
+    INFO("mixed elements fall back to generic lists");
+    Expression mixed = run("(append (range 0 1 1) I)");
+    REQUIRE(mixed.tailPacking() == Expression::Unpacked);
+    REQUIRE(mixed.listLength() == 3);
+    REQUIRE(mixed.listElement(2) == Expression(std::complex<double>(0, 1)));
+    REQUIRE(run("(list 1 I)").tailPacking() == Expression::Unpacked);
+    REQUIRE(run("(join (range 0 1 1) (list (list 2)))").tailPacking() == Expression::Unpacked);
+    REQUIRE(run("(first (list (range 0 1 1) 2))") == Expression::packedList({0, 1}));
+  }
+}
+
+TEST_CASE("Test arithmetic over lists", "[interpreter]")
+{
+  // each call over a list, and the lambda mapped over the list that
+  // computes it element by element
+  struct Case { std::string call, lambda, list; };
+  std::vector<Case> cases = {
+    {"(+ (list 1 2 3) 10)", "(+ x 10)", "(list 1 2 3)"},
+    {"(+ 1 (range 0 9 1) (range 10 19 1) I)", "(+ 1 x (+ x 10) I)", "(range 0 9 1)"},
+    {"(* (range 1 9 1) (range 1 9 1) (+ 1 I))", "(* x x (+ 1 I))", "(range 1 9 1)"},
+    {"(* (list I (* 2 I)) (list I (* 2 I)))", "(* x x)", "(list I (* 2 I))"},
+    {"(- (range -2 2 1))", "(- x)", "(range -2 2 1)"},
+    {"(- (list I (- I) (+ 3 I)))", "(- x)", "(list I (- I) (+ 3 I))"},
+    {"(- (range 0 4 1) (+ 1 I))", "(- x (+ 1 I))", "(range 0 4 1)"},
+    {"(- (list I (+ 1 I)) 2)", "(- x 2)", "(list I (+ 1 I))"},
+    {"(- 2 (list I (+ 1 I)))", "(- 2 x)", "(list I (+ 1 I))"},
+    {"(/ (range 0 4 1))", "(/ x)", "(range 0 4 1)"},
+    {"(/ (list I (+ 1 I)))", "(/ x)", "(list I (+ 1 I))"},
+    {"(/ 3 (range 1 5 1))", "(/ 3 x)", "(range 1 5 1)"},
+    {"(/ (range 1 5 1) (+ 2 I))", "(/ x (+ 2 I))", "(range 1 5 1)"},
+    {"(/ (list I (+ 1 I)) 2)", "(/ x 2)", "(list I (+ 1 I))"},
+    {"(^ (range 0 4 1) 2)", "(^ x 2)", "(range 0 4 1)"},
+    {"(^ I (range 0 4 1))", "(^ I x)", "(range 0 4 1)"},
+    {"(^ (list I (+ 1 I)) (list I (+ 1 I)))", "(^ x x)", "(list I (+ 1 I))"},
+    {"(sqrt (range 0 4 1))", "(sqrt x)", "(range 0 4 1)"},
+    {"(sqrt (range -2 2 1))", "(sqrt x)", "(range -2 2 1)"},
+    {"(sqrt (list I (- I)))", "(sqrt x)", "(list I (- I))"},
+    {"(ln (range 0 4 1))", "(ln x)", "(range 0 4 1)"},
+    {"(sin (range -3 3 0.5))", "(sin x)", "(range -3 3 0.5)"},
+    {"(cos (range -3 3 0.5))", "(cos x)", "(range -3 3 0.5)"},
+    {"(tan (range -3 3 0.5))", "(tan x)", "(range -3 3 0.5)"},
+    {"(+ (list 1 I) 1)", "(+ x 1)", "(list 1 I)"},
+    {"(+ (list (list 1 2) 3) 1)", "(+ x 1)", "(list (list 1 2) 3)"},
+  };
+
+  for (auto & c : cases) {
+    INFO(c.call);
+    REQUIRE(run(c.call) == run("(begin (define f (lambda (x) " + c.lambda + ")) (map f " + c.list + "))"));
+  }
+
+  {
+    INFO("lists of numbers stay packed");
+    REQUIRE(run("(* 2 (range 0 3 1))") == Expression::packedList({0, 2, 4, 6}));
+    REQUIRE(run("(+ (range 0 3 1) I)").tailPacking() == Expression::PackedComplex);
+    REQUIRE(run("(+ (list) 1)") == run("(list)"));
+  }
+
+  std::vector<std::string> errors = {
+    "(+ (list 1 2) (list 1))",
+    "(- (list 1 2) (range 0 2 1))",
+    "(* (list 1 2) a)",
+    "(ln (list 1 -1))",
+    "(sin (list I))",
+    "(- (list 1) 2 3)",
+  };
+
+  for (auto & program : errors) {
+    INFO(program);
+    Interpreter interp;
+    std::istringstream iss(program);
+    REQUIRE(interp.parseStream(iss));
+    REQUIRE_THROWS_AS(interp.evaluate(), SemanticError);
+  }
+}
+
+TEST_CASE("Test graphic primitives match their interpreted definitions", "[interpreter]")
+{
+  // the definitions the start-up file used to make
+  const std::string interpreted = "(begin"
+    " (define old-point (lambda (x y) (set-property \"size\" 0 (set-property \"object-name\" \"point\" (list x y)))))"
+    " (define old-line (lambda (p1 p2) (set-property \"thickness\" 1 (set-property \"object-name\" \"line\" (list p1 p2)))))"
+    " (define old-text (lambda (str) (set-property \"text-rotation\" 0 (set-property \"text-scale\" 1"
+    " (set-property \"position\" (define location (old-point 0 0)) (set-property \"object-name\" \"text\" (str)))))))"
+    ")";
+
+  Interpreter interp;
+  std::istringstream definitions(interpreted);
+  REQUIRE(interp.parseStream(definitions));
+  interp.evaluate();
+
+  // the printed value of program
+  auto value = [&interp](const std::string & program) {
+    std::istringstream iss(program);
+    REQUIRE(interp.parseStream(iss));
+    std::ostringstream out;
+    out << interp.evaluate();
+    return out.str();
+  };
+
+  std::vector<std::string> primitives = {
+    "(make-point 1 (- 2))",
+    "(make-point (list 1) \"a\")",
+    "(make-line (make-point 0 0) (make-point 3 4))",
+    "(make-text \"hello\")",
+    "(make-text 5)",
+    "(make-text (make-point 1 2))",
+    "(set-property \"size\" 3 (make-point 1 1))",
+    "(make-point 1 1)",
+    "(make-text (set-property \"text-scale\" 2 \"a\"))",
+    "(set-property \"position\" (make-point 1 1) (make-text \"b\"))",
+    "(make-text \"c\")",
+  };
+  std::vector<std::string> tags = {
+    "object-name", "size", "thickness", "position", "text-scale", "text-rotation", "other"
+  };
+
+  for (auto & native : primitives) {
+    std::string old = native;
+    for (auto name : { "point", "line", "text" }) {
+      std::string from = std::string("make-") + name, to = std::string("old-") + name;
+      for (std::size_t at; (at = old.find(from)) != std::string::npos; )
+        old.replace(at, from.size(), to);
+    }
+    INFO(native);
+    REQUIRE(value(native) == value(old));
+    for (auto & tag : tags) {
+      INFO(tag);
+      std::string get = "(get-property \"" + tag + "\" ";
+      REQUIRE(value(get + native + ")") == value(get + old + ")"));
+      REQUIRE(value(get + "(get-property \"position\" " + native + "))")
+        == value(get + "(get-property \"position\" " + old + "))"));
+    }
+  }
+
+  for (auto program : { "(make-point 1)", "(make-point 1 2 3)", "(make-line (make-point 0 0))",
+                        "(make-text)", "(make-text \"a\" \"b\")", "(define make-point 1)" }) {
+    INFO(program);
+    REQUIRE_THROWS_AS(value(program), SemanticError);
+  }
+}
+
 TEST_CASE("Semantic errors for set-property", "[interpreter]")
 {
 	Interpreter interp;
@@ -578,6 +851,77 @@ TEST_CASE("Semantic Errors for map procedure", "[interpreter]")
 	}
 }
 
+TEST_CASE("Test parallel map", "[interpreter]")
+{
+  // a few workers, so the chunks really run on other threads
+  const std::size_t workers = ThreadPool::shared().workers();
+  ThreadPool::resizeShared(3);
+
+  std::vector<std::string> programs = {
+    "(pmap / (range 1 1000 1))",
+    "(pmap - (list 1 I (list 2 3)))",
+    "(begin (define f (lambda (x) (* x x I))) (pmap f (range 0 1000 0.5)))",
+    "(begin (define f (lambda (x) (begin (define y (+ x 1)) (* y y)))) (pmap f (range 0 999 1)))",
+    "(begin (define y 2) (define f (lambda (x) (^ x y))) (pmap f (range 0 999 1)))",
+    "(begin (define f (lambda (x) (first x))) (pmap f (list (list 1) (list \"a\" 2))))",
+    "(pmap + (list))",
+  };
+
+  for (auto & program : programs) {
+    INFO(program);
+    std::string mapped = program;
+    mapped.replace(mapped.find("(pmap"), 5, "(map");
+    REQUIRE(run(program) == run(mapped));
+  }
+
+  {
+    INFO("a define in the lambda does not escape it");
+    REQUIRE(run("(begin (define y 5) (define f (lambda (x) (define y x))) (pmap f (range 0 99 1)) y)")
+      == Expression(5.));
+  }
+
+  {
+    INFO("the error of the first failing element is thrown, as map throws it");
+    auto firstError = [](const std::string & form, const std::string & at300, const std::string & at700) {
+      std::string elements;
+      for (int i = 0; i < 1000; ++i)
+        elements += i == 300 ? at300 : (i == 700 ? at700 : " (list 1)");
+      Interpreter interp;
+      std::istringstream iss("(begin (define f (lambda (x) (sqrt (first x)))) (" + form + " f (list" + elements + ")))");
+      REQUIRE(interp.parseStream(iss));
+      try {
+        interp.evaluate();
+      }
+      catch (const SemanticError & error) {
+        return std::string(error.what());
+      }
+      return std::string();
+    };
+    REQUIRE(firstError("pmap", " (list)", " (list \"a\")") == firstError("map", " (list)", " (list \"a\")"));
+    REQUIRE(firstError("pmap", " (list \"a\")", " (list)") == firstError("map", " (list \"a\")", " (list)"));
+    REQUIRE(firstError("pmap", " (list)", " (list \"a\")") != firstError("pmap", " (list \"a\")", " (list)"));
+  }
+
+  std::vector<std::string> errors = {
+    "(pmap + 3)",
+    "(pmap 3 (list 1 2 3))",
+    "(pmap pi (list 1 2 3))",
+    "(pmap + (list 1 2 3) (list 1 2 3))",
+    "(begin (define f (lambda (x y) (+ x y))) (pmap f (list 1 2 3)))",
+    "(begin (define f (lambda (x) (ln x))) (pmap f (range -10 10 1)))",
+  };
+
+  for (auto & program : errors) {
+    INFO(program);
+    Interpreter interp;
+    std::istringstream iss(program);
+    REQUIRE(interp.parseStream(iss));
+    REQUIRE_THROWS_AS(interp.evaluate(), SemanticError);
+  }
+
+  ThreadPool::resizeShared(workers);
+}
+
 TEST_CASE("test discrete plot", "[interpreter]") {
 
 	Interpreter interp;
@@ -607,11 +951,157 @@ TEST_CASE("test continuous plot", "[interpreter]") {
 	
 }
 
+TEST_CASE("Test continuous plot samples", "[interpreter]")
+{
+  const std::size_t workers = ThreadPool::shared().workers();
+  const std::string f = "(define f (lambda (x) (sin (* 3 x))))";
+
+  // the same plot, whether sampled on one thread or on several
+  std::vector<std::string> programs = {
+    "(begin " + f + " (continuous-plot f (list -2 2)))",
+    "(begin " + f + " (continuous-plot f (list -2 2) (list (list \"samples\" 2000) (list \"title\" \"A\"))))",
+  };
+  for (auto & program : programs) {
+    INFO(program);
+    ThreadPool::resizeShared(0);
+    Expression sequential = run(program);
+    ThreadPool::resizeShared(3);
+    REQUIRE(run(program) == sequential);
+  }
+
+  {
+    INFO("more samples draw more lines");
+    REQUIRE(run(programs[1]).listLength() > run(programs[0]).listLength() + 3800);
+  }
+
+  {
+    INFO("samples is the number of uniform intervals, each tested at its midpoint and bisected as the curve bends");
+    const std::string line = "(define g (lambda (x) (+ (* 2 x) 1)))";
+    Expression ten = run("(begin " + line + " (continuous-plot g (list -2 2) (list (list \"samples\" 10))))");
+    Expression twenty = run("(begin " + line + " (continuous-plot g (list -2 2) (list (list \"samples\" 20))))");
+    REQUIRE(twenty.listLength() == ten.listLength() + 2 * 10);
+
+    // the plot draws the same layout before its curve whatever the function
+    const std::size_t layout = ten.graphics()->size() - 2 * 10;
+    Expression wave = run("(begin " + f + " (continuous-plot f (list -2 2) (list (list \"samples\" 10))))");
+    const Graphics & graphics = *wave.graphics();
+    REQUIRE(graphics.size() > layout + 2 * 10);
+
+    std::vector<double> starts;
+    for (std::size_t i = layout; i < graphics.size(); ++i) {
+      REQUIRE(graphics.kind(i) == Graphics::Line);
+      starts.push_back(graphics.line(i).x1);
+    }
+    const double left = starts.front(), right = graphics.line(graphics.size() - 1).x2;
+    for (int i = 0; i < 10; ++i) {
+      double x = left + (right - left) * i / 10;
+      INFO(x);
+      REQUIRE(std::any_of(starts.begin(), starts.end(),
+        [x](double start) { return std::abs(start - x) < 1e-9; }));
+    }
+  }
+
+  std::vector<std::string> errors = {
+    "(begin " + f + " (continuous-plot f (list -2 2) (list (list \"samples\" 0))))",
+    "(begin " + f + " (continuous-plot f (list -2 2) (list (list \"samples\" 2.5))))",
+    "(begin " + f + " (continuous-plot f (list -2 2) (list (list \"samples\" \"many\"))))",
+    "(begin (define f (lambda (x) (ln x))) (continuous-plot f (list -2 2)))",
+  };
+  for (auto & program : errors) {
+    INFO(program);
+    Interpreter interp;
+    std::istringstream iss(program);
+    REQUIRE(interp.parseStream(iss));
+    REQUIRE_THROWS_AS(interp.evaluate(), SemanticError);
+  }
+
+  ThreadPool::resizeShared(workers);
+}
+
+TEST_CASE("Test plots are graphics", "[interpreter]")
+{
+  std::vector<std::string> programs = {
+    "(discrete-plot (list (list 1 2) (list 3 4)) (list (list \"title\" \"A\")))",
+    "(discrete-plot (list (list -1 -2) (list 3 4)) (list))",
+    "(begin (define f (lambda (x) (* x x))) (continuous-plot f (list -1 1)))",
+  };
+
+  for (auto & program : programs) {
+    INFO(program);
+    Expression plot = run(program);
+    REQUIRE(plot.graphics() != nullptr);
+    REQUIRE(plot.listLength() == static_cast<int>(plot.graphics()->size()));
+
+    // the elements, and the printing, are those of the old list of make-point,
+    // make-line and make-text results
+    Expression elements(plot.head());
+    for (auto e = plot.tailConstBegin(); e != plot.tailConstEnd(); ++e) {
+      REQUIRE(e->property("object-name").head().isStringLiteral());
+      elements.addToTail(*e);
+    }
+    REQUIRE(elements.graphics() == nullptr);
+    REQUIRE(elements == plot);
+
+    std::ostringstream packed, unpacked;
+    packed << plot;
+    unpacked << elements;
+    REQUIRE(packed.str() == unpacked.str());
+  }
+
+  {
+    INFO("a point is drawn by a line from the x axis and a point");
+    Expression plot = run(programs[1]);
+    const Graphics & graphics = *plot.graphics();
+    std::size_t last = graphics.size() - 1;
+    REQUIRE(graphics.kind(last) == Graphics::Point);
+    REQUIRE(graphics.kind(last - 1) == Graphics::Line);
+    REQUIRE(graphics.line(last - 1).y1 == 0);
+    REQUIRE(graphics.line(last - 1).y2 == graphics.point(last).y);
+    REQUIRE(graphics.point(last).size == 0.5);
+  }
+
+  {
+    INFO("the texts of plots, such as tick labels, are not interned");
+    const std::size_t interned = SymbolTable::getInstance().size();
+    for (int i = 1; i <= 20; ++i) {
+      std::string n = std::to_string(i * 7.25);
+      Expression plot = run("(discrete-plot (list (list -" + n + " 1) (list " + n + " 2)) (list))");
+      std::ostringstream out;
+      for (auto e = plot.tailConstBegin(); e != plot.tailConstEnd(); ++e)
+        out << *e;
+    }
+    REQUIRE(SymbolTable::getInstance().size() == interned);
+  }
+}
+
 TEST_CASE("interpreter reset", "[interpreter]") {
 	Interpreter interp;
 	interp.clear();
 }
 
+TEST_CASE("Test interpreter copies", "[interpreter]") {
+
+  // as the notebook keeps a copy to reset its kernel to
+  Interpreter interp;
+  interp.setMode(Interpreter::StackMode);
+  std::istringstream first("(define f (lambda (x) (+ x 1)))");
+  REQUIRE(interp.parseStream(first));
+  interp.evaluate();
+  Interpreter reset = interp;
+
+  std::istringstream second("(begin (define y (f 1)) (f y))");
+  REQUIRE(interp.parseStream(second));
+  REQUIRE(interp.evaluate() == Expression(3.));
+
+  interp = reset;
+  std::istringstream third("(f 10)");
+  REQUIRE(interp.parseStream(third));
+  REQUIRE(interp.evaluate() == Expression(11.));
+  std::istringstream fourth("(y)");
+  REQUIRE(interp.parseStream(fourth));
+  REQUIRE_THROWS_AS(interp.evaluate(), SemanticError);
+}
+
 TEST_CASE( "Test some semantically invalid expresions", "[interpreter]" ) {
   
   std::vector<std::string> programs = {"(@ none)", // so such procedure
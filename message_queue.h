@@ -8,6 +8,7 @@ www.justsoftwaresolutions.co.uk/threading/implementing-a-thread-safe-queue-using
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <utility>
 #include "expression.hpp"
 
 /*struct messageOut
@@ -37,6 +38,15 @@ public:
     the_condition_variable.notify_one();
   }
 
+  // move message into queue, blocks until available
+  void push(MessageType&& message)
+  {
+    std::unique_lock<std::mutex> lock(the_mutex);
+    the_queue.push(std::move(message));
+    lock.unlock();
+    the_condition_variable.notify_one();
+  }
+
   // check if queue is empty, blocks until available
   bool empty() const
   {
@@ -53,7 +63,7 @@ public:
 	return false;
       }
 
-    popped_value=the_queue.front();
+    popped_value=std::move(the_queue.front());
     the_queue.pop();
     return true;
   }
@@ -67,7 +77,7 @@ public:
 	the_condition_variable.wait(lock);
       }
 
-    popped_value=the_queue.front();
+    popped_value=std::move(the_queue.front());
     the_queue.pop();
   }
 
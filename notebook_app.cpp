@@ -1,5 +1,13 @@
 #include "notebook_app.hpp"
 
+// the definitions of the start-up file, evaluated once and shared by every
+// notebook
+static const Prelude & startupPrelude()
+{
+	static const Prelude prelude(STARTUP_SOURCE);
+	return prelude;
+}
+
 NotebookApp::NotebookApp(QWidget *parent) :QWidget(parent)
 {
 	inputWidget = new InputWidget;
@@ -21,8 +29,13 @@ NotebookApp::NotebookApp(QWidget *parent) :QWidget(parent)
 
 	
 
-	// put make-point/line/text procedure into env map after reading in the file
-	eval_from_file(STARTUP_FILE);
+	// put make-label into env map from the start-up file; make-point/line/text
+	// are built in
+	const Prelude & prelude = startupPrelude();
+	if (prelude.ok())
+		interp.load(prelude);
+	else
+		error(prelude.error());
 	interp.interrupt();
 	resetInterp = interp;
 	guiThread = new std::thread(&Interpreter::Kernal, &interp);
@@ -142,6 +155,7 @@ void NotebookApp::connectSlots()
 	connect(this, SIGNAL(makePointReady(std::vector<double>)), outputWidget, SLOT(plotPoint(std::vector<double>)));
 	connect(this, SIGNAL(makeLineReady(std::vector<double>)), outputWidget, SLOT(plotLine(std::vector<double>)));
 	connect(this, SIGNAL(makeTextReady(QString, double, double,double,double)), outputWidget, SLOT(showText(QString, double, double,double,double)));
+	connect(this, SIGNAL(graphicsReady(const Graphics &)), outputWidget, SLOT(drawGraphics(const Graphics &)));
 	connect(this, SIGNAL(initializeScreen()), outputWidget, SLOT(clearScreen()));
 	connect(startButton, SIGNAL(released()), this, SLOT(start()));
 	connect(stopButton, SIGNAL(released()), this, SLOT(stop()));
@@ -187,15 +201,24 @@ void NotebookApp::eval_from_file(std::string filename) {
 	eval_from_stream(ifs);
 }
 
+// the number a numeric graphic property is set to, or 0
+static double graphicNumber(const Expression & exp, Expression::GraphicProperty property, const std::string & tag)
+{
+	double value;
+	if (exp.graphicProperty(property, value))
+		return value;
+	return exp.property(tag).head().asNumber();
+}
+
 void NotebookApp::whichSignal(Expression exp)
 {
 	std::vector<Expression> tempParameters; // for graphics
 
 	// if the input is make-point: takes 3 inputs (x,y,size) and emit those as signal 
-	if (exp.get_property("object-name").second.head().asStringLiteral() == "point")
+	if (exp.objectName() == Expression::PointObject)
 	{
 		plotParameters.clear();
-		size = exp.get_property("size").second.head().asNumber();
+		size = graphicNumber(exp, Expression::SizeProperty, "size");
 		for (auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e)
 			tempParameters.push_back(*e);
 		
@@ -216,10 +239,10 @@ void NotebookApp::whichSignal(Expression exp)
 
 	}
 	// if the input is make-line: takes 5 inputs (x1,y1,x2,y2,thickness) and emit those as signal
-	else if (exp.get_property("object-name").second.head().asStringLiteral() == "line")
+	else if (exp.objectName() == Expression::LineObject)
 	{
 		plotParameters.clear();
-		thickness = exp.get_property("thickness").second.head().asNumber();
+		thickness = graphicNumber(exp, Expression::ThicknessProperty, "thickness");
 
 		if (thickness < 0)
 			error("Error: in make-line: thickness must be positive");
@@ -240,15 +263,15 @@ void NotebookApp::whichSignal(Expression exp)
 			qDebug() <<"final parameters: " << plotParameters[i];
 		emit(makeLineReady(plotParameters));
 	}
-	else if (exp.get_property("object-name").second.head().asStringLiteral() == "text")
+	else if (exp.objectName() == Expression::TextObject)
 	{
 		QString text = QString::fromStdString(exp.head().asStringLiteral());
 
 
 		//obtain the position of the text 
-		Expression position = exp.get_property("position").second;
+		Expression position = exp.property("position");
 
-		if (position.get_property("object-name").second.head().asStringLiteral() != "point")
+		if (position.objectName() != Expression::PointObject)
 			error("Error in make-text: object-name of position property not a point");
 
 		for (auto e = position.tailConstBegin(); e != position.tailConstEnd(); ++e)
@@ -257,34 +280,31 @@ void NotebookApp::whichSignal(Expression exp)
 		x = tempParameters[0].head().asNumber();
 		y = tempParameters[1].head().asNumber();
 
-		Expression textScale = exp.get_property("text-scale").second;
-
-		if (textScale.head().asNumber() < 0)
+		scale = graphicNumber(exp, Expression::TextScaleProperty, "text-scale");
+		if (scale < 0)
 			scale = 1;
-		else
-			scale = textScale.head().asNumber();
-
-		Expression textRotation = exp.get_property("text-rotation").second;
 
-		if (!textRotation.isHeadNumber())
-			phi = 0;
-		else
-			phi = textRotation.head().asNumber();
+		phi = graphicNumber(exp, Expression::TextRotationProperty, "text-rotation");
 
 		QString test("this is a test");
 
 		emit(makeTextReady(text, x, y,scale,phi));
 
 	}
+	// a plot is drawn from its buffer, without building its elements
+	else if (const Graphics * graphics = exp.graphics())
+	{
+		emit(graphicsReady(*graphics));
+	}
 	//recursion for evaluating list of properties 
-	else if (exp.head().asSymbol() == "list") 
+	else if (exp.head().symbolId() == Symbols::List) 
 	{
 		for (auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e)
 			whichSignal(*e);
 	}
 	else // regular expression 
 	{
-		if (exp.head().asSymbol() != "lambda")
+		if (exp.head().symbolId() != Symbols::Lambda)
 		{
 			std::stringstream stream;
 			stream << exp;
@@ -29,6 +29,7 @@ signals:
 	void makeLineReady(std::vector<double> parameters);
 	void makeTextReady(QString text, double x, double y, double scale, double phi);
 	void makeLabelReady(QString text, double x, double y, double scale, double phi);
+	void graphicsReady(const Graphics & graphics);
 	void initializeScreen();
 
 	public slots: 
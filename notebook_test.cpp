@@ -9,7 +9,9 @@ private slots:
 
   void initTestCase();
   void testDiscretePlotLayout();
+  void testContinuousPlot();
   void testMakeText();
+  void testMakePointAndLine();
 
   // TODO: implement additional tests here
 private:
@@ -189,6 +191,44 @@ void NotebookTest::testDiscretePlotLayout() {
 	QCOMPARE(findPoints(scene, QPointF(10, -10), 0.6), 1);
 }
 
+void NotebookTest::testContinuousPlot() {
+
+	std::string program = R"( 
+(begin
+    (define f (lambda (x) x))
+    (continuous-plot f (list -2 2) (list (list "samples" 10))))
+)";
+
+	auto inputWidget = notebook.findChild<InputWidget *>("input");
+	auto outputWidget = notebook.findChild<OutputWidget *>("output");
+	inputWidget->setPlainText(QString::fromStdString(program));
+	QTest::keyClick(inputWidget, Qt::Key_Return, Qt::ShiftModifier);
+
+	auto view = outputWidget->findChild<QGraphicsView *>();
+	QVERIFY2(view, "Could not find QGraphicsView as child of OutputWidget");
+
+	auto scene = view->scene();
+
+	// 4 box lines + 2 axes + 20 curve lines (a line is only tested at the
+	// midpoints of its 10 uniform intervals) + 4 tick labels = 30
+	auto items = scene->items();
+	QCOMPARE(items.size(), 30);
+
+	foreach(auto item, items) {
+		item->setFlag(QGraphicsItem::ItemIsSelectable);
+	}
+
+	// check the ordinate max label
+	QCOMPARE(findText(scene, QPointF(-12, -10), 0, QString("2")), 1);
+
+	// check the curve, between two of its samples, away from the axes
+	QCOMPARE(intersectsLine(scene, QPointF(5.5, -5.5), 0.1), 1);
+
+	// check the curve ends at the corners of the box
+	QCOMPARE(intersectsLine(scene, QPointF(-10, 10), 0.1), 3);
+	QCOMPARE(intersectsLine(scene, QPointF(10, -10), 0.1), 3);
+}
+
 void NotebookTest::testMakeText() {
 
 	std::string program = R"( 
@@ -218,6 +258,34 @@ void NotebookTest::testMakeText() {
 	QCOMPARE(findText(scene, QPointF(4, 7), 0, QString("Hello World!")), 1);
 }
 
+void NotebookTest::testMakePointAndLine() {
+
+	std::string program = R"( 
+(list (set-property "size" 2 (make-point 4 7))
+      (make-line (make-point 0 0) (make-point 20 0)))
+)";
+
+	auto inputWidget = notebook.findChild<InputWidget *>("input");
+	auto outputWidget = notebook.findChild<OutputWidget *>("output");
+	inputWidget->setPlainText(QString::fromStdString(program));
+	QTest::keyClick(inputWidget, Qt::Key_Return, Qt::ShiftModifier);
+
+	auto view = outputWidget->findChild<QGraphicsView *>();
+	QVERIFY2(view, "Could not find QGraphicsView as child of OutputWidget");
+
+	auto scene = view->scene();
+
+	auto items = scene->items();
+	QCOMPARE(items.size(), 2);
+
+	foreach(auto item, items) {
+		item->setFlag(QGraphicsItem::ItemIsSelectable);
+	}
+
+	QCOMPARE(findPoints(scene, QPointF(4, 7), 1.1), 1);
+	QCOMPARE(findLines(scene, QRectF(0, 0, 20, 0), 0.1), 1);
+}
+
 
 
 QTEST_MAIN(NotebookTest)
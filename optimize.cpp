@@ -0,0 +1,174 @@
+#include "optimize.hpp"
+
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "semantic_error.hpp"
+
+namespace {
+
+// a number or complex literal, without properties
+bool isConstant(const Expression & exp) {
+  return exp.isListEmpty() && (exp.head().isNumber() || exp.head().isComplexNumber())
+    && !exp.hasProperties();
+}
+
+// add every symbol exp defines or binds as a lambda parameter to bound
+void collectBindings(const Expression & exp, std::unordered_set<SymbolId> & bound) {
+
+  // walked with an explicit stack, programs may nest arbitrarily deep
+  std::vector<const Expression *> pending(1, &exp);
+  while (!pending.empty()) {
+    const Expression & e = *pending.back();
+    pending.pop_back();
+
+    SymbolId id = e.head().symbolId();
+    if ((id == Symbols::Define || id == Symbols::Lambda) && !e.isListEmpty()) {
+      const Expression & target = *e.tailConstBegin();
+      bound.insert(target.head().symbolId());
+      for (auto p = target.tailConstBegin(); p != target.tailConstEnd(); ++p)
+        bound.insert(p->head().symbolId());
+    }
+
+    for (auto c = e.tailConstBegin(); c != e.tailConstEnd(); ++c)
+      pending.push_back(&*c);
+  }
+}
+
+// subexpressions nested deeper are left as they are
+const unsigned MAX_FOLD_DEPTH = 1000;
+
+class Folder {
+public:
+
+  Folder(const Expression & program, const Environment & env): m_env(env), m_count(0), m_depth(0) {
+    collectBindings(program, m_bound);
+  }
+
+  std::size_t count() const { return m_count; }
+
+  // the folded form of exp; inLambda is true within a lambda body
+  Expression fold(const Expression & exp, bool inLambda) {
+
+    if (exp.isListEmpty()) {
+      const Expression * value = inLambda ? nullptr : constantValue(exp.head());
+      if (value == nullptr)
+        return exp;
+      ++m_count;
+      return *value;
+    }
+
+    // the arguments to leave unfolded, as a bit mask of their positions
+    unsigned kept = 0;
+    switch (exp.head().symbolId()) {
+    case Symbols::Define:
+      kept = 1;
+      break;
+    case Symbols::Lambda:
+      if (exp.listLength() != 2)
+        return exp;
+      return foldArguments(exp, 1, true);
+    case Symbols::Apply:
+    case Symbols::Map:
+    case Symbols::ParallelMap:
+      kept = 1;
+      break;
+    case Symbols::ContinuousPlot:
+      kept = 3;
+      break;
+    default:
+      break;
+    }
+
+    Expression result = foldArguments(exp, kept, inLambda);
+    if (kept == 0 && m_env.is_proc(result.head()))
+      return call(result);
+    return result;
+  }
+
+private:
+
+  const Environment & m_env;
+  std::unordered_set<SymbolId> m_bound;
+  std::size_t m_count;
+  unsigned m_depth;
+
+  // the value of a built-in constant that may be folded, or nullptr
+  const Expression * constantValue(const Atom & atom) const {
+
+    static const Environment defaults;
+
+    if (!atom.isSymbol() || m_bound.count(atom.symbolId()) != 0)
+      return nullptr;
+
+    const Expression * builtin = defaults.find_exp(atom);
+    const Expression * current = m_env.find_exp(atom);
+    if (builtin == nullptr || current == nullptr || !(*builtin == *current))
+      return nullptr;
+    return current;
+  }
+
+  // exp with each argument not in the kept mask folded; exp itself if
+  // nothing changed
+  Expression foldArguments(const Expression & exp, unsigned kept, bool inLambda) {
+
+    if (m_depth >= MAX_FOLD_DEPTH)
+      return exp;
+    ++m_depth;
+
+    std::vector<Expression> args;
+    args.reserve(exp.listLength());
+
+    bool changed = false;
+    unsigned position = 0;
+    for (auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e, ++position) {
+      if (position < 32 && (kept & (1u << position))) {
+        args.push_back(*e);
+        continue;
+      }
+      std::size_t before = m_count;
+      args.push_back(fold(*e, inLambda));
+      changed = changed || (m_count != before);
+    }
+    --m_depth;
+
+    if (!changed)
+      return exp;
+    return Expression(exp.head(), std::move(args));
+  }
+
+  // the value of a call of a built-in procedure if it can be folded
+  Expression call(const Expression & exp) {
+
+    std::vector<Expression> args;
+    args.reserve(exp.listLength());
+    for (auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e) {
+      if (!isConstant(*e))
+        return exp;
+      args.push_back(*e);
+    }
+
+    Expression value;
+    try {
+      value = m_env.get_proc(exp.head())(std::move(args));
+    }
+    catch (const SemanticError &) {
+      return exp;
+    }
+
+    if (!isConstant(value))
+      return exp;
+    ++m_count;
+    return value;
+  }
+};
+
+} // namespace
+
+std::size_t foldConstants(Expression & program, const Environment & env) {
+
+  Folder folder(program, env);
+  program = folder.fold(program, false);
+  return folder.count();
+}
@@ -0,0 +1,42 @@
+/*! \file optimize.hpp
+Defines the optimization pass run over a parsed Expression before it is
+evaluated.
+ */
+#ifndef OPTIMIZE_HPP
+#define OPTIMIZE_HPP
+
+#include <cstddef>
+
+#include "environment.hpp"
+#include "expression.hpp"
+
+/*! \fn foldConstants
+\brief replace calls of built-in procedures over constant arguments by
+       their value
+
+A call is folded when its head is a built-in procedure, every argument is a
+number or complex literal (possibly folded itself), and the call returns a
+number or complex number without properties. Built-in procedures cannot be
+redefined or shadowed, so the value is the one evaluation would produce. A
+call that throws is left alone for its error to surface at run time.
+
+The built-in constants (pi, e, I) are folded only where their binding is
+known: in code run directly by the program, when the environment still
+binds them to their default value and the program neither defines nor
+takes them as a lambda parameter. Lambda bodies are evaluated in the
+environment of each caller, which may rebind them, so inside lambdas only
+calls over literals are folded.
+
+Arguments the special forms read without evaluating them (names, lambda
+parameters, the procedure of apply and map, the bounds of a continuous
+plot) are left as they are, as is anything nested more than a thousand
+levels deep.
+
+\param program the expression, as returned by parse; replaced by the folded
+       expression, sharing the subtrees that did not change
+\param env the environment the program will be evaluated in
+\returns the number of nodes replaced by a constant
+ */
+std::size_t foldConstants(Expression & program, const Environment & env);
+
+#endif
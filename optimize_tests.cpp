@@ -0,0 +1,115 @@
+#include "catch.hpp"
+
+#include <sstream>
+#include <string>
+
+#include "interpreter.hpp"
+#include "optimize.hpp"
+#include "parse.hpp"
+#include "semantic_error.hpp"
+
+static Expression parseProgram(const std::string & program) {
+
+  std::istringstream iss(program);
+  Expression exp = parse(tokenize(iss));
+  REQUIRE(exp != Expression());
+  return exp;
+}
+
+// the folded program and its folded node count
+static std::size_t fold(const std::string & program, const std::string & expected) {
+
+  Environment env;
+  Expression exp = parseProgram(program);
+  std::size_t count = foldConstants(exp, env);
+
+  REQUIRE(exp == parseProgram(expected));
+  return count;
+}
+
+// the value of a program evaluated with and without folding, which must agree
+static Expression evaluateBoth(const std::string & program) {
+
+  Interpreter folding, plain;
+  plain.useFolding(false);
+
+  std::istringstream iss(program);
+  REQUIRE(folding.parseStream(iss));
+  iss.clear();
+  iss.str(program);
+  REQUIRE(plain.parseStream(iss));
+
+  Expression result = folding.evaluate();
+  REQUIRE(result == plain.evaluate());
+  return result;
+}
+
+TEST_CASE( "Test folding calls over literals", "[optimize]" ) {
+
+  REQUIRE(fold("(+ 1 2)", "(3)") == 1);
+  REQUIRE(fold("(* 2 (/ 1 4) (- 4))", "(-2)") == 3);
+  REQUIRE(fold("(list (sqrt 4) a)", "(list 2 a)") == 1);
+  REQUIRE(fold("(+ a (* 2 3))", "(+ a 6)") == 1);
+  REQUIRE(fold("(begin (define x (^ 2 10)) x)", "(begin (define x 1024) x)") == 1);
+
+  // lists are not folded
+  REQUIRE(fold("(length (list 1 2))", "(length (list 1 2))") == 0);
+
+  // calls that fail are left for evaluation to report
+  REQUIRE(fold("(sqrt 1 2)", "(sqrt 1 2)") == 0);
+  REQUIRE_THROWS_AS(evaluateBoth("(sqrt 1 2)"), SemanticError);
+}
+
+TEST_CASE( "Test folding built-in constants", "[optimize]" ) {
+
+  REQUIRE(fold("(* 2 pi)", "(6.283185307179586)") == 2);
+  REQUIRE(fold("(+ e 0)", "(2.718281828459045)") == 2);
+
+  {
+    INFO("only calls over literals are folded in lambda bodies");
+    REQUIRE(fold("(lambda (x) (* x pi (/ 1 2)))", "(lambda (x) (* x pi 0.5))") == 1);
+  }
+
+  {
+    INFO("constants the program rebinds are not folded");
+    REQUIRE(fold("(begin (define pi 3) (* 2 pi))", "(begin (define pi 3) (* 2 pi))") == 0);
+    REQUIRE(fold("(begin (define f (lambda (e) (+ e 1))) (f e))",
+                 "(begin (define f (lambda (e) (+ e 1))) (f e))") == 0);
+  }
+
+  {
+    INFO("constants the environment rebound are not folded");
+    Environment env;
+    env.add_exp(Atom("pi"), Expression(3.));
+    Expression exp = parseProgram("(* 2 pi)");
+    REQUIRE(foldConstants(exp, env) == 0);
+  }
+}
+
+TEST_CASE( "Test folding leaves unevaluated arguments", "[optimize]" ) {
+
+  REQUIRE(fold("(continuous-plot f (list (- 1) 1) (list (list \"title\" (+ 1 2))))",
+               "(continuous-plot f (list (- 1) 1) (list (list \"title\" 3)))") == 1);
+  REQUIRE(fold("(map pi (list pi))", "(map pi (list 3.141592653589793))") == 1);
+  REQUIRE(fold("(define pi (+ 1 2))", "(define pi 3)") == 1);
+}
+
+TEST_CASE( "Test folded programs evaluate as before", "[optimize]" ) {
+
+  REQUIRE(evaluateBoth("(begin (define f (lambda (x) (* x (/ 1 4) pi))) (map f (list 1 2 3)))")
+          .listLength() == 3);
+  REQUIRE(evaluateBoth("(begin (define g (lambda (x) (* x pi))) (define h (lambda (pi) (g 2))) (h 1))")
+          == Expression(2.));
+  REQUIRE(evaluateBoth("(+ (* 2 I) (ln e))") != Expression());
+  REQUIRE(evaluateBoth("(set-property \"size\" (* 2 3) (list 0 0))") != Expression());
+
+  Interpreter interp;
+  std::istringstream define("(define pi 3)");
+  REQUIRE(interp.parseStream(define));
+  interp.evaluate();
+
+  std::istringstream use("(* 2 pi)");
+  REQUIRE(interp.parseStream(use));
+  REQUIRE(interp.foldedNodes() == 0);
+  REQUIRE(interp.evaluate() == Expression(6.));
+}
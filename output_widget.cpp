@@ -30,10 +30,7 @@ void OutputWidget::showResult(QString output)
 
 void OutputWidget::plotPoint(std::vector<double> parameters)
 {
-	QPen blackPen(Qt::black);
-	blackPen.setWidth(0);
-	//std::vector<double> parameter(parameters.begin(), parameters.end());
-	scene->addEllipse(parameters[0]-parameters[2]/2, parameters[1]-parameters[2]/2, parameters[2], parameters[2], blackPen ,blackBrush);
+	addPoint(parameters[0], parameters[1], parameters[2]);
 	outputWindow->fitInView(scene->itemsBoundingRect(), Qt::KeepAspectRatio);
 }
 
@@ -41,10 +38,7 @@ void OutputWidget::plotPoint(std::vector<double> parameters)
 
 void OutputWidget::plotLine(std::vector<double> parameters)
 {
-
-	QPen blackPen(Qt::black);
-	blackPen.setWidth(parameters[4]);
-	scene->addLine(parameters[0], parameters[1], parameters[2], parameters[3], blackPen);
+	addLine(parameters[0], parameters[1], parameters[2], parameters[3], parameters[4]);
 	outputWindow->fitInView(scene->itemsBoundingRect(), Qt::KeepAspectRatio);
 }
 
@@ -52,6 +46,53 @@ void OutputWidget::showText(QString text, double x, double y, double scale, doub
 {
 	qDebug() << "now we at showtext";
 	qDebug() << "x: " << x << " y: " << y;
+	addText(text, x, y, scale, phi);
+	outputWindow->fitInView(scene->itemsBoundingRect(), Qt::KeepAspectRatio);
+}
+
+// a whole plot, read straight from its buffer and fitted in view once
+void OutputWidget::drawGraphics(const Graphics & graphics)
+{
+	for (std::size_t i = 0; i < graphics.size(); ++i)
+	{
+		switch (graphics.kind(i))
+		{
+		case Graphics::Point: {
+			Graphics::PointData p = graphics.point(i);
+			addPoint(p.x, p.y, p.size);
+			break;
+		}
+		case Graphics::Line: {
+			Graphics::LineData l = graphics.line(i);
+			addLine(l.x1, l.y1, l.x2, l.y2, l.thickness);
+			break;
+		}
+		case Graphics::Text: {
+			Graphics::TextData t = graphics.text(i);
+			addText(QString::fromStdString(t.text), t.x, t.y, t.scale, t.rotation);
+			break;
+		}
+		}
+	}
+	outputWindow->fitInView(scene->itemsBoundingRect(), Qt::KeepAspectRatio);
+}
+
+void OutputWidget::addPoint(double x, double y, double size)
+{
+	QPen blackPen(Qt::black);
+	blackPen.setWidth(0);
+	scene->addEllipse(x - size / 2, y - size / 2, size, size, blackPen, blackBrush);
+}
+
+void OutputWidget::addLine(double x1, double y1, double x2, double y2, double thickness)
+{
+	QPen blackPen(Qt::black);
+	blackPen.setWidth(thickness);
+	scene->addLine(x1, y1, x2, y2, blackPen);
+}
+
+void OutputWidget::addText(QString text, double x, double y, double scale, double phi)
+{
 	QGraphicsTextItem *resultText = new QGraphicsTextItem(text);
 	auto outputFont = QFont("Monospace");
 	outputFont.setStyleHint(QFont::TypeWriter);
@@ -64,7 +105,6 @@ void OutputWidget::showText(QString text, double x, double y, double scale, doub
 	resultText->setTransformOriginPoint(resultText->boundingRect().center());
 	resultText->setRotation(phi*(180 / (std::atan2(0, -1))));
 	scene->addItem(resultText);
-	outputWindow->fitInView(scene->itemsBoundingRect(), Qt::KeepAspectRatio);
 }
 
 void OutputWidget::clearScreen()
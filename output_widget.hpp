@@ -18,6 +18,8 @@
 #include <QMainWindow>
 #include <QPushButton>
 
+#include "graphics.hpp"
+
 class OutputWidget : public QWidget {
 
 	Q_OBJECT
@@ -32,6 +34,7 @@ public:
 	void plotPoint(std::vector<double> parameters);
 	void plotLine(std::vector<double> parameters);
 	void showText(QString text, double x, double y,double scale,double phi);
+	void drawGraphics(const Graphics & graphics);
 	void clearScreen();
 private:
 
@@ -40,6 +43,11 @@ private:
 	QBrush blackBrush = Qt::black;
 	QPainter * plots;
 
+	// add a primitive to the scene, without fitting the view to it
+	void addPoint(double x, double y, double size);
+	void addLine(double x1, double y1, double x2, double y2, double thickness);
+	void addText(QString text, double x, double y, double scale, double phi);
+
 protected:
 	void resizeEvent(QResizeEvent* event);
 
@@ -0,0 +1,69 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "interpreter.hpp"
+#include "thread_pool.hpp"
+
+// the mean time of one evaluation of program over 10 evaluations
+static double timeProgram(Bench & bench, const std::string & label, const std::string & program) {
+
+  Interpreter interp;
+  std::istringstream iss(program);
+  interp.parseStream(iss);
+
+  return bench.run(label, 10, [&] {
+    doNotOptimize(interp.evaluate());
+  });
+}
+
+// a lambda of a few dozen operations mapped over 100k points, sequentially
+// and in parallel with 1 to N threads, where N is the number of cores but
+// at least 4
+BENCHMARK_CASE(parallel_map) {
+
+  const std::string program = "(begin (define f (lambda (x) (begin (define y (sin x))"
+    " (+ (* y y) (cos x) (sqrt (+ 1 (* x x))) (ln (+ 2 x)))))) (MAP f (range 0 99999 1)))";
+  auto with = [&program](const std::string & form) {
+    std::string p = program;
+    return p.replace(p.find("MAP"), 3, form);
+  };
+
+  const std::size_t workers = ThreadPool::shared().workers();
+  const std::size_t threads = std::max<std::size_t>(4, std::thread::hardware_concurrency());
+
+  double map = timeProgram(bench, "map over 100k", with("map"));
+  for (std::size_t n = 1; n <= threads; ++n) {
+    ThreadPool::resizeShared(n - 1);
+    const std::string suffix = ", " + std::to_string(n) + " thread" + (n > 1 ? "s" : "");
+    double pmap = timeProgram(bench, "pmap over 100k" + suffix, with("pmap"));
+    bench.report("speedup over map" + suffix, map / pmap, "x");
+  }
+  ThreadPool::resizeShared(workers);
+}
+
+// continuous-plot of the same function with 10k samples, on 1 to N threads
+BENCHMARK_CASE(parallel_plot) {
+
+  const std::string program = "(begin (define f (lambda (x) (begin (define y (sin x))"
+    " (+ (* y y) (cos x) (sqrt (+ 1 (* x x))) (ln (+ 2 x)))))) (continuous-plot f (list -1 1)"
+    " (list (list \"samples\" 10000))))";
+
+  const std::size_t workers = ThreadPool::shared().workers();
+  const std::size_t threads = std::max<std::size_t>(4, std::thread::hardware_concurrency());
+
+  double single = 0;
+  for (std::size_t n = 1; n <= threads; ++n) {
+    ThreadPool::resizeShared(n - 1);
+    const std::string suffix = ", " + std::to_string(n) + " thread" + (n > 1 ? "s" : "");
+    double plot = timeProgram(bench, "continuous-plot of 10k samples" + suffix, program);
+    if (n == 1)
+      single = plot;
+    else
+      bench.report("speedup" + suffix, single / plot, "x");
+  }
+  ThreadPool::resizeShared(workers);
+}
@@ -1,38 +1,52 @@
 #include "parse.hpp"
 
+#include <cctype>
 #include <stack>
 
-bool setHead(Expression &exp, const Token &token, bool &isStringLiteral) {
+bool setHead(Expression &exp, const TokenSpan &token, bool &isStringLiteral) {
 
-  Atom a(token);
+  Atom a = isStringLiteral ? Atom::fromStringLiteral(token.text) : Atom::fromText(token.text);
 
-  if (isStringLiteral)
-	  a.setStringLiteral();
- 
   exp.head() = a;
 
   return !a.isNone();
 }
 
-bool append(Expression *exp, const Token &token, bool &isStringKind) {
+bool append(Expression *exp, const TokenSpan &token, bool &isStringKind) {
 
-  Atom a(token);
+  Atom a = isStringKind ? Atom::fromStringLiteral(token.text) : Atom::fromText(token.text);
 
-  if (isStringKind)
-	  a.setStringLiteral();
+  bool ok = !a.isNone();
+  exp->append(std::move(a));
 
-  exp->append(a);
-
-  return !a.isNone();
+  return ok;
 }
 
-Expression parse(const TokenSequenceType &tokens) noexcept {
+// pulls the tokens of a TokenSequenceType as TokenSpans
+class SequenceSource {
+public:
+  SequenceSource(const TokenSequenceType &tokens): m_pos(tokens.begin()), m_end(tokens.end()) {}
+
+  bool next(TokenSpan &token) {
+    if (m_pos == m_end)
+      return false;
+    token.type = m_pos->type();
+    m_text = m_pos->asString();
+    token.text = StringSpan(m_text);
+    ++m_pos;
+    return true;
+  }
 
-  Expression ast;
+private:
+  TokenSequenceType::const_iterator m_pos;
+  TokenSequenceType::const_iterator m_end;
+  std::string m_text;
+};
 
-  // cannot parse empty
-  if (tokens.empty())
-    return Expression();
+template <typename Source>
+Expression parseFrom(Source &source) noexcept {
+
+  Expression ast;
 
   bool athead = false;
   bool stringLiteral = false;
@@ -43,12 +57,13 @@ Expression parse(const TokenSequenceType &tokens) noexcept {
   std::size_t num_tokens_seen = 0;
   std::size_t num_quotes_seen = 0;
 
-  for (auto &t : tokens) {
+  TokenSpan t;
+  while (source.next(t)) {
 
-    if (t.type() == Token::OPEN) {
+    if (t.type == Token::OPEN) {
       athead = true;
     } 
-	else if (t.type() == Token::CLOSE) {
+	else if (t.type == Token::CLOSE) {
       if (stack.empty() || num_quotes_seen%2 == 1) {
         return Expression();
       }
@@ -59,7 +74,7 @@ Expression parse(const TokenSequenceType &tokens) noexcept {
         break;
       }
     }
-	else if (t.type() == Token::STRINGLITERAL)
+	else if (t.type == Token::STRINGLITERAL)
 	{
 		stringLiteral = true;
 		num_quotes_seen++;
@@ -99,9 +114,71 @@ Expression parse(const TokenSequenceType &tokens) noexcept {
     num_tokens_seen += 1;
   }
 
-  if (stack.empty() && (num_tokens_seen == tokens.size())) {
+  // cannot parse empty, and nothing may follow the expression
+  if (stack.empty() && (num_tokens_seen > 0) && !source.next(t)) {
     return ast;
   }
 
   return Expression();
+}
+
+Expression parse(const TokenSequenceType &tokens) noexcept {
+
+  SequenceSource source(tokens);
+  return parseFrom(source);
+}
+
+Expression parse(Tokenizer &tokens) noexcept {
+
+  return parseFrom(tokens);
 };
+
+StreamParser::StreamParser(std::istream &input) : m_input(input) {}
+
+ParseResult StreamParser::next(Expression &exp) {
+
+  exp = Expression();
+  m_text.clear();
+
+  std::streambuf *buffer = m_input.rdbuf();
+  int depth = 0;
+  bool comment = false;
+  bool started = false;
+
+  // read up to the paren closing a top-level expression, keeping comments
+  // so that the tokenizer treats them as it does in a whole program
+  while (true) {
+    int c = buffer->sbumpc();
+    if (c == std::char_traits<char>::eof()) {
+      m_input.setstate(std::ios_base::eofbit);
+      break;
+    }
+    m_text.push_back(static_cast<char>(c));
+
+    if (comment) {
+      comment = (c != '\n');
+    }
+    else if (c == ';') {
+      comment = true;
+    }
+    else if (c == '(') {
+      started = true;
+      ++depth;
+    }
+    else if (c == ')') {
+      started = true;
+      if (--depth <= 0)
+        break;
+    }
+    else if (!std::isspace(c)) {
+      started = true;
+    }
+  }
+
+  if (!started)
+    return EndOfInput;
+
+  Tokenizer tokens(m_text);
+  exp = parse(tokens);
+  return (exp != Expression()) ? ParsedExpression : InvalidExpression;
+}
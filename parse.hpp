@@ -1,9 +1,13 @@
 /*! \file parse.hpp
-Defines the parse function.
+Defines the parse function and the StreamParser reading one expression at a
+time from a stream.
  */
 #ifndef PARSE_HPP
 #define PARSE_HPP
 
+#include <istream>
+#include <string>
+
 #include "token.hpp"
 #include "expression.hpp"
 
@@ -15,4 +19,54 @@ Defines the parse function.
  */
 Expression parse(const TokenSequenceType & tokens) noexcept;
 
+/*! \fn parse
+\brief parse the tokens pulled from a tokenizer into an expression
+
+Tokens are consumed as they are parsed, without building a sequence first.
+
+\param tokens, the tokenizer over the input buffer
+\returns the expression resulting from parsing or the None Expression on failure
+ */
+Expression parse(Tokenizer & tokens) noexcept;
+
+/*! \enum ParseResult
+\brief The outcome of reading one expression from a StreamParser.
+*/
+enum ParseResult {
+  ParsedExpression,  //< a top-level expression was parsed
+  InvalidExpression, //< the text up to the end of an expression did not parse
+  EndOfInput         //< only white space and comments were left
+};
+
+/*! \class StreamParser
+\brief Parses a stream holding any number of top-level expressions, one
+expression at a time.
+
+Each expression is parsed as soon as its closing paren has been read, so a
+caller can evaluate it while the rest of the input has still to arrive.
+Only the text of one expression is held in memory, however long the input.
+
+An invalid expression does not stop the parser; the next call resumes after
+the paren that ended it.
+*/
+class StreamParser {
+public:
+
+  /// Construct a parser reading from input, which must outlive it
+  explicit StreamParser(std::istream & input);
+
+  /*! Read and parse the next top-level expression.
+    \param exp set to the expression, or to the None Expression if there is
+    none or it is invalid
+    \return whether an expression was parsed, was invalid or the input ended
+   */
+  ParseResult next(Expression & exp);
+
+private:
+  std::istream & m_input;
+
+  // the text of the expression being read
+  std::string m_text;
+};
+
 #endif
@@ -0,0 +1,39 @@
+#include "bench.hpp"
+
+#include <sstream>
+#include <string>
+
+#include "interpreter.hpp"
+
+// a list literal of one million numbers in the forms found in data files
+static const std::string & numberList() {
+
+  static std::string script;
+  if (script.empty()) {
+    std::ostringstream out;
+    out << "(list";
+    for (int i = 0; i < 1000000; ++i) {
+      switch (i % 4) {
+      case 0: out << ' ' << i; break;
+      case 1: out << ' ' << -i * 0.125; break;
+      case 2: out << ' ' << i << ".0625e-3"; break;
+      default: out << " +" << (i % 1000) << '.' << (i % 7) << "E+2"; break;
+      }
+    }
+    out << ")";
+    script = out.str();
+  }
+  return script;
+}
+
+// parsing a data-heavy list literal is dominated by classifying numbers
+BENCHMARK_CASE(parse_number_list) {
+
+  const std::string & script = numberList();
+  Interpreter interp;
+
+  double ns = bench.run("parse 1M-number list", 5, [&] {
+    doNotOptimize(interp.parseBuffer(script.data(), script.data() + script.size()));
+  });
+  bench.report("per number", ns / 1e6, "ns");
+}
@@ -57,3 +57,40 @@ TEST_CASE( "Test empty parens", "[parse]" ) {
   REQUIRE(parse(tokens) == Expression());
 }
 
+
+TEST_CASE( "Test stream parser with several expressions", "[parse]" ) {
+
+  std::istringstream iss("(define a 1) ; first\n(+ a ; split\n 2)\n\n(junk)) (list)\n  ; done\n");
+  StreamParser input(iss);
+  Expression exp;
+
+  REQUIRE(input.next(exp) == ParsedExpression);
+  REQUIRE(exp.head().asSymbol() == "define");
+
+  REQUIRE(input.next(exp) == ParsedExpression);
+  REQUIRE(exp.head().asSymbol() == "+");
+  REQUIRE(exp.listLength() == 2);
+
+  REQUIRE(input.next(exp) == ParsedExpression);
+  REQUIRE(exp.head().asSymbol() == "junk");
+
+  // the extra paren is invalid, parsing resumes after it
+  REQUIRE(input.next(exp) == InvalidExpression);
+  REQUIRE(exp == Expression());
+
+  REQUIRE(input.next(exp) == ParsedExpression);
+  REQUIRE(exp.head().asSymbol() == "list");
+
+  REQUIRE(input.next(exp) == EndOfInput);
+  REQUIRE(input.next(exp) == EndOfInput);
+}
+
+TEST_CASE( "Test stream parser with truncated input", "[parse]" ) {
+
+  std::istringstream iss("(begin (define a 1)");
+  StreamParser input(iss);
+  Expression exp;
+
+  REQUIRE(input.next(exp) == InvalidExpression);
+  REQUIRE(input.next(exp) == EndOfInput);
+}
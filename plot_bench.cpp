@@ -0,0 +1,142 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "curve_sampler.hpp"
+#include "interpreter.hpp"
+
+// the largest distance, in plot units, of f from the polyline through the
+// samples, checked at 100k points
+static double plotError(const std::vector<CurveSampler::Point> & samples,
+  const std::function<double(double)> & f) {
+
+  double low = samples.front().y, high = samples.front().y;
+  for (auto & p : samples) {
+    low = std::min(low, p.y);
+    high = std::max(high, p.y);
+  }
+  const double xScale = 20 / (samples.back().x - samples.front().x);
+  const double yScale = 20 / (high - low);
+
+  double error = 0;
+  std::size_t segment = 0;
+  const double left = samples.front().x, right = samples.back().x;
+  for (int i = 0; i <= 100000; ++i) {
+    double x = left + (right - left) * i / 100000;
+    while (segment + 2 < samples.size() && samples[segment + 1].x < x)
+      ++segment;
+    const CurveSampler::Point & a = samples[segment];
+    const CurveSampler::Point & b = samples[segment + 1];
+    double dx = (b.x - a.x) * xScale, dy = (b.y - a.y) * yScale;
+    double cross = dx * (f(x) - a.y) * yScale - dy * (x - a.x) * xScale;
+    error = std::max(error, std::abs(cross) / std::hypot(dx, dy));
+  }
+  return error;
+}
+
+// the evaluations continuous-plot spends on a few curves, and how far the
+// drawing strays from them, adaptively and over 50 uniform intervals
+BENCHMARK_CASE(curve_sampling) {
+
+  struct Curve {
+    std::string name;
+    double left, right;
+    std::function<double(double)> f;
+  };
+  const std::vector<Curve> curves = {
+    {"2x+1 on [-2,2]", -2, 2, [](double x) { return 2 * x + 1; }},
+    {"x^2 on [-1,1]", -1, 1, [](double x) { return x * x; }},
+    {"sin x on [-10,10]", -10, 10, [](double x) { return std::sin(x); }},
+    {"sqrt |x| on [-1,1]", -1, 1, [](double x) { return std::sqrt(std::abs(x)); }},
+    {"sin 1/x on [0.05,1]", 0.05, 1, [](double x) { return std::sin(1 / x); }},
+    {"exp 20x on [0,1]", 0, 1, [](double x) { return std::exp(20 * x); }},
+  };
+
+  for (auto & curve : curves) {
+    std::size_t evaluations = 0;
+    auto function = [&](const std::vector<double> & xs) {
+      evaluations += xs.size();
+      std::vector<double> ys;
+      for (double x : xs)
+        ys.push_back(curve.f(x));
+      return ys;
+    };
+
+    CurveSampler adaptive;
+    auto samples = adaptive.sample(curve.left, curve.right, function);
+    bench.report(curve.name + ", adaptive evaluations", evaluations, "");
+    bench.report(curve.name + ", adaptive error", 1000 * plotError(samples, curve.f), "milliunits");
+
+    CurveSampler uniform;
+    uniform.intervals = 50;
+    uniform.maxSamples = 0;
+    evaluations = 0;
+    samples = uniform.sample(curve.left, curve.right, function);
+    bench.report(curve.name + ", uniform evaluations", evaluations, "");
+    bench.report(curve.name + ", uniform error", 1000 * plotError(samples, curve.f), "milliunits");
+  }
+
+  Interpreter interp;
+  std::istringstream iss("(begin (define f (lambda (x) (sin x))) (continuous-plot f (list -10 10)))");
+  interp.parseStream(iss);
+  bench.run("continuous-plot of sin x", 100, [&] {
+    doNotOptimize(interp.evaluate());
+  });
+}
+
+// a discrete plot of 10k points, and printing it from its buffer against
+// printing the same elements built as Expressions
+BENCHMARK_CASE(plot_output) {
+
+  Interpreter interp;
+  std::istringstream iss("(begin (define f (lambda (x) (list x (sin x)))) "
+    "(define data (map f (range 0 10000 1))) (discrete-plot data (list)))");
+  interp.parseStream(iss);
+  Expression plot = interp.evaluate();
+
+  std::istringstream again("(discrete-plot data (list))");
+  interp.parseStream(again);
+  bench.run("discrete-plot of 10k points", 10, [&] {
+    doNotOptimize(interp.evaluate());
+  });
+
+  Expression elements(plot.head());
+  for (auto e = plot.tailConstBegin(); e != plot.tailConstEnd(); ++e)
+    elements.addToTail(*e);
+
+  bench.run("printing it from its buffer", 10, [&] {
+    std::ostringstream out;
+    out << plot;
+    doNotOptimize(out.str().size());
+  });
+  bench.run("printing it as elements", 10, [&] {
+    std::ostringstream out;
+    out << elements;
+    doNotOptimize(out.str().size());
+  });
+}
+
+// a discrete plot of 1M points, given in order of x and in no order
+BENCHMARK_CASE(discrete_plot) {
+
+  Interpreter interp;
+  std::istringstream iss("(begin (define f (lambda (x) (list x (sin x)))) "
+    "(define g (lambda (x) (list (sin x) x))) "
+    "(define ordered (map f (range 0 999999 1))) "
+    "(define unordered (map g (range 0 999999 1))))");
+  interp.parseStream(iss);
+  interp.evaluate();
+
+  for (std::string data : {"ordered", "unordered"}) {
+    std::istringstream plot("(discrete-plot " + data + " (list (list \"title\" \"sin\")))");
+    interp.parseStream(plot);
+    bench.run("discrete-plot of 1M points, " + data, 5, [&] {
+      doNotOptimize(interp.evaluate());
+    });
+  }
+}
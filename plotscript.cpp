@@ -119,6 +119,33 @@ int eval_from_stream(std::istream & stream, Interpreter *interp){
   return EXIT_SUCCESS;
 }
 
+// evaluate each top-level expression of the stream as soon as it is read,
+// carrying on after errors
+int eval_each_from_stream(std::istream & stream, Interpreter *interp){
+
+  StreamParser input(stream);
+  int status = EXIT_SUCCESS;
+
+  ParseResult result;
+  while((result = interp->parseNext(input)) != EndOfInput){
+    if(result == InvalidExpression){
+      error("Invalid Expression. Could not parse.");
+      status = EXIT_FAILURE;
+      continue;
+    }
+    try{
+      Expression exp = interp->evaluate();
+      std::cout << exp << std::endl;
+    }
+    catch(const SemanticError & ex){
+      std::cerr << ex.what() << std::endl;
+      status = EXIT_FAILURE;
+    }
+  }
+
+  return status;
+}
+
 int eval_from_file(std::string filename, Interpreter *interp){
       
   std::ifstream ifs(filename);
@@ -138,6 +165,29 @@ int eval_from_command(std::string argexp, Interpreter *interp){
   return eval_from_stream(expression,interp);
 }
 
+// the definitions of the start-up file, evaluated the first time they are
+// loaded
+const Prelude & startup_prelude(){
+
+  static const Prelude prelude(STARTUP_SOURCE);
+  return prelude;
+}
+
+// load the start-up definitions, printing the value of the start-up file as
+// evaluating it does
+int load_startup(Interpreter *interp){
+
+  const Prelude & prelude = startup_prelude();
+  if(!prelude.ok()){
+    std::cerr << prelude.error() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  interp->load(prelude);
+  std::cout << prelude.result() << std::endl;
+  return EXIT_SUCCESS;
+}
+
 // A REPL is a repeated read-eval-print loop
 void repl(Interpreter *interp, bool &threadReset){
 
@@ -145,13 +195,10 @@ void repl(Interpreter *interp, bool &threadReset){
 	
 	std::thread *thr1;
 	if (threadReset == true) {
-		eval_from_file(STARTUP_FILE, interp);
+		load_startup(interp);
 		thr1 = new std::thread(&Interpreter::Kernal, interp);
 	}
 	
-	Interpreter * newInterp = interp;
-	//newInterp = interp; // replacing with new interpreter for resetting  
-
 	while (!std::cin.eof()) {
 
 		global_status_flag = 0;
@@ -197,18 +244,21 @@ void repl(Interpreter *interp, bool &threadReset){
 				}
 				thr1->join();
 			}
+			delete thr1;
 			interp->clear();
-			interp = newInterp;
+			interp->load(startup_prelude());
 			thr1 = new std::thread(&Interpreter::Kernal, interp);
 			continue;
 		}
 		while (!outputMessage.try_pop(output)) {
 			if (global_status_flag > 0) {
+				// the kernel may still be evaluating, so its interpreter is
+				// left to it and a fresh one takes over
 				thr1->detach();
-				thr1->~thread();
-				interp->clear();
-				interp = new Interpreter;
-				interp = newInterp;
+				delete thr1;
+				Interpreter * fresh = new Interpreter;
+				fresh->load(startup_prelude());
+				interp = fresh;
 				thr1 = new std::thread(&Interpreter::Kernal, interp);
 				error("interpreter kernel interrupted");
 				break;
@@ -234,6 +284,9 @@ int main(int argc, char *argv[])
 	bool threadReset = true;
 
 	if(argc == 2){
+    if(std::string(argv[1]) == "-s"){
+      return eval_each_from_stream(std::cin,interp);
+    }
     return eval_from_file(argv[1],interp);
   }
   else if(argc == 3){
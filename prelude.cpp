@@ -0,0 +1,26 @@
+#include "prelude.hpp"
+
+#include <utility>
+
+#include "interpreter.hpp"
+#include "semantic_error.hpp"
+
+Prelude::Prelude(const std::string & source) {
+
+  Interpreter interp;
+
+  if (!interp.parseBuffer(source.data(), source.data() + source.size())) {
+    m_error = "Error: Invalid Program. Could not parse.";
+    return;
+  }
+
+  try {
+    m_result = interp.evaluate().heapCopy();
+  }
+  catch (const SemanticError & ex) {
+    m_error = ex.what();
+    return;
+  }
+
+  m_env = std::move(interp.env);
+}
@@ -0,0 +1,49 @@
+/*! \file prelude.hpp
+Defines the prelude, a program evaluated once whose definitions are then
+loaded into any number of interpreters.
+ */
+#ifndef PRELUDE_HPP
+#define PRELUDE_HPP
+
+#include <string>
+
+#include "environment.hpp"
+#include "expression.hpp"
+
+/*! \class Prelude
+\brief The top-level definitions made by a program, such as the startup
+file, evaluated once in a default environment.
+
+Constructing a Prelude parses and evaluates its program. Loading it into an
+Interpreter (see Interpreter::load) then only copies the definitions, which
+share their expressions and the closures built for their lambdas, so an
+application can keep one Prelude and load it at every start and reset of
+its kernel.
+ */
+class Prelude {
+public:
+
+  /*! Parse and evaluate a program in a default environment.
+    \param source the text of the program
+   */
+  explicit Prelude(const std::string & source);
+
+  /// true if the program was parsed and evaluated without error
+  bool ok() const noexcept { return m_error.empty(); }
+
+  /// the message of the error the program failed with, or an empty string
+  const std::string & error() const noexcept { return m_error; }
+
+  /// the value of the program, or an Expression of NoneType on error
+  const Expression & result() const noexcept { return m_result; }
+
+  /// the environment holding the definitions made by the program
+  const Environment & environment() const noexcept { return m_env; }
+
+private:
+  Environment m_env;
+  Expression m_result;
+  std::string m_error;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#include "bench.hpp"
+
+#include <fstream>
+
+#include "interpreter.hpp"
+#include "prelude.hpp"
+#include "startup_config.hpp"
+
+// starting a kernel with the definitions of the start-up file, by reading
+// and evaluating the file as it used to be, and by loading the compiled-in
+// prelude; plotscript and notebook both start and reset this way
+BENCHMARK_CASE(startup) {
+
+  const std::size_t iterations = 10000;
+
+  double file = bench.run("read and evaluate startup file", iterations, [] {
+    Interpreter interp;
+    std::ifstream ifs(STARTUP_FILE);
+    interp.parseStream(ifs);
+    doNotOptimize(interp.evaluate());
+  });
+
+  double first = bench.run("evaluate compiled-in prelude", iterations, [] {
+    Prelude prelude(STARTUP_SOURCE);
+    doNotOptimize(prelude);
+  });
+
+  const Prelude prelude(STARTUP_SOURCE);
+  double load = bench.run("load prelude", iterations, [&] {
+    Interpreter interp;
+    interp.load(prelude);
+    doNotOptimize(interp);
+  });
+
+  Interpreter interp;
+  double reset = bench.run("reset and load prelude", iterations, [&] {
+    interp.clear();
+    interp.load(prelude);
+  });
+
+  bench.report("file over first start", file / first, "x");
+  bench.report("file over later starts", file / load, "x");
+  bench.report("file over reset", file / reset, "x");
+}
@@ -0,0 +1,68 @@
+#include "symbol.hpp"
+
+#include <stdexcept>
+
+// names of the pre-interned symbols, in the order of the Symbols enum
+static const char * const KNOWN_SYMBOLS[Symbols::NumKnown] = {
+  "begin",
+  "define",
+  "lambda",
+  "apply",
+  "map",
+  "pmap",
+  "set-property",
+  "get-property",
+  "discrete-plot",
+  "continuous-plot",
+  "list"
+};
+
+SymbolTable & SymbolTable::getInstance() {
+  static SymbolTable inst;
+  return inst;
+}
+
+SymbolTable::SymbolTable(): m_size(0) {
+
+  for (auto & chunk : m_chunks)
+    chunk.store(nullptr, std::memory_order_relaxed);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (SymbolId id = 0; id < Symbols::NumKnown; ++id)
+    append(KNOWN_SYMBOLS[id]);
+}
+
+SymbolTable::~SymbolTable() {
+
+  for (auto & chunk : m_chunks)
+    delete[] chunk.load(std::memory_order_relaxed);
+}
+
+SymbolId SymbolTable::intern(const std::string & name) {
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto result = m_ids.find(name);
+  if (result != m_ids.end())
+    return result->second;
+
+  return append(name);
+}
+
+SymbolId SymbolTable::append(const std::string & name) {
+
+  const std::size_t id = m_size.load(std::memory_order_relaxed);
+  if (id >= ChunkSize * MaxChunks)
+    throw std::length_error("SymbolTable: too many symbols");
+
+  std::string * chunk = m_chunks[id >> ChunkBits].load(std::memory_order_relaxed);
+  if (chunk == nullptr) {
+    chunk = new std::string[ChunkSize];
+    m_chunks[id >> ChunkBits].store(chunk, std::memory_order_release);
+  }
+  chunk[id & (ChunkSize - 1)] = name;
+  m_size.store(id + 1, std::memory_order_release);
+
+  m_ids.emplace(name, static_cast<SymbolId>(id));
+  return static_cast<SymbolId>(id);
+}
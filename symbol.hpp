@@ -0,0 +1,105 @@
+/*! \file symbol.hpp
+Defines the SymbolTable used to intern symbol names.
+
+Every symbol name is interned once into a process-wide table and referred to
+by a small integer SymbolId afterwards, so that comparing, hashing and
+copying symbols never touches the characters of the name. String literals
+are not interned (see Atom), so the table only grows with the names a
+program is written with.
+ */
+#ifndef SYMBOL_HPP
+#define SYMBOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/*! \typedef SymbolId
+\brief The interned identity of a symbol name.
+*/
+typedef std::uint32_t SymbolId;
+
+/*! \namespace Symbols
+\brief Ids of the symbols the interpreter dispatches on, interned up front
+       in this order.
+*/
+namespace Symbols {
+  enum : SymbolId {
+    Begin,
+    Define,
+    Lambda,
+    Apply,
+    Map,
+    ParallelMap,
+    SetProperty,
+    GetProperty,
+    DiscretePlot,
+    ContinuousPlot,
+    List,
+    NumKnown, //< the number of pre-interned symbols
+
+    None = 0xffffffffu //< never names a symbol
+  };
+}
+
+/*! \class SymbolTable
+\brief The process-wide, thread-safe table of interned symbol names.
+
+Names are never removed, so a reference returned by name() stays valid for
+the lifetime of the program. Interning takes a lock; looking a name up by
+id does not, as names are only ever appended, in chunks that never move.
+ */
+class SymbolTable {
+public:
+
+  /// return the single instance of the table
+  static SymbolTable & getInstance();
+
+  /*! Intern a symbol name.
+    \param name the symbol name
+    \return the id of name, the same for every call with an equal name
+   */
+  SymbolId intern(const std::string & name);
+
+  /*! Get the name of an interned symbol.
+    \param id an id returned by intern
+    \return the interned name
+   */
+  const std::string & name(SymbolId id) const noexcept {
+    return m_chunks[id >> ChunkBits].load(std::memory_order_acquire)[id & (ChunkSize - 1)];
+  }
+
+  /// the number of names interned
+  std::size_t size() const noexcept { return m_size.load(std::memory_order_acquire); }
+
+private:
+
+  static const unsigned ChunkBits = 10;
+  static const std::size_t ChunkSize = std::size_t(1) << ChunkBits;
+  static const std::size_t MaxChunks = 4096;
+
+  SymbolTable();
+  ~SymbolTable();
+
+  SymbolTable(const SymbolTable &) = delete;
+  SymbolTable & operator=(const SymbolTable &) = delete;
+
+  // id to name, by chunks of ChunkSize names allocated as they are needed;
+  // an id reaches another thread with an expression holding it, after its
+  // name was written
+  std::atomic<std::string *> m_chunks[MaxChunks];
+  std::atomic<std::size_t> m_size;
+
+  // name to id, under the lock
+  std::unordered_map<std::string, SymbolId> m_ids;
+
+  std::mutex m_mutex;
+
+  // add a name under the lock, returning its id
+  SymbolId append(const std::string & name);
+};
+
+#endif
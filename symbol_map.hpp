@@ -0,0 +1,233 @@
+/*! \file symbol_map.hpp
+Defines the hash table from interned symbols used by Environment.
+ */
+#ifndef SYMBOL_MAP_HPP
+#define SYMBOL_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "symbol.hpp"
+
+/*! \class SymbolMap
+\brief An open-addressing hash table from SymbolId to T.
+
+The table holds 8-byte (symbol, value location) slots, probed linearly and
+kept at most half full, so a lookup reads one or two adjacent slots and then
+the value. Symbol ids are small consecutive integers, so they are spread over
+the table by Fibonacci hashing.
+
+The values live in blocks of doubling size that are never reallocated:
+inserting moves no value, growing the table rehashes only the slots, and a
+pointer to a value stays valid until the map is cleared or destroyed.
+Entries are never removed one at a time.
+ */
+template <typename T>
+class SymbolMap {
+public:
+
+  typedef std::pair<SymbolId, T> value_type;
+
+  /// construct an empty map, allocating nothing
+  SymbolMap() noexcept: m_size(0), m_shift(32) {}
+
+  /// copy the entries of another map
+  SymbolMap(const SymbolMap & other): SymbolMap() {
+    insertAll(other);
+  }
+
+  /// take over the entries of another map, leaving it empty
+  SymbolMap(SymbolMap && other) noexcept:
+    m_table(std::move(other.m_table)), m_blocks(std::move(other.m_blocks)),
+    m_size(other.m_size), m_shift(other.m_shift) {
+    other.m_table.clear();
+    other.m_blocks.clear();
+    other.m_size = 0;
+    other.m_shift = 32;
+  }
+
+  /// replace the entries by those of another map
+  SymbolMap & operator=(const SymbolMap & other) {
+    if (this != &other) {
+      SymbolMap copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  /// replace the entries by those of another map, leaving it empty
+  SymbolMap & operator=(SymbolMap && other) noexcept {
+    if (this != &other) {
+      m_table = std::move(other.m_table);
+      m_blocks = std::move(other.m_blocks);
+      m_size = other.m_size;
+      m_shift = other.m_shift;
+      other.m_table.clear();
+      other.m_blocks.clear();
+      other.m_size = 0;
+      other.m_shift = 32;
+    }
+    return *this;
+  }
+
+  /// the number of entries
+  std::size_t size() const noexcept { return m_size; }
+
+  /// true if there are no entries
+  bool empty() const noexcept { return m_size == 0; }
+
+  /*! Find the value of a symbol.
+    \param id the symbol
+    \return a pointer to its value, or nullptr
+   */
+  T * find(SymbolId id) noexcept {
+    return const_cast<T *>(static_cast<const SymbolMap &>(*this).find(id));
+  }
+
+  /// \copydoc find(SymbolId)
+  const T * find(SymbolId id) const noexcept {
+
+    if (m_table.empty())
+      return nullptr;
+
+    const std::size_t mask = m_table.size() - 1;
+    for (std::size_t i = home(id); ; i = (i + 1) & mask) {
+      const Slot & slot = m_table[i];
+      if (slot.key == id)
+        return value(slot);
+      if (slot.key == Symbols::None)
+        return nullptr;
+    }
+  }
+
+  /// the number of entries for id, 0 or 1
+  std::size_t count(SymbolId id) const noexcept { return find(id) != nullptr ? 1 : 0; }
+
+  /*! Insert a value for a symbol that has none, with a single probe of the
+    table.
+    \param id the symbol
+    \param args the arguments to construct the value from, used only if
+    the value is inserted
+    \return a pointer to the value of id, and whether it was inserted
+   */
+  template <typename... Args>
+  std::pair<T *, bool> try_emplace(SymbolId id, Args &&... args) {
+
+    if (2 * (m_size + 1) > m_table.size())
+      grow();
+
+    const std::size_t mask = m_table.size() - 1;
+    std::size_t i = home(id);
+    for (; m_table[i].key != Symbols::None; i = (i + 1) & mask) {
+      if (m_table[i].key == id)
+        return std::make_pair(value(m_table[i]), false);
+    }
+
+    // a full block is followed by one twice its size
+    if (m_blocks.empty() || m_blocks.back().size() == m_blocks.back().capacity()) {
+      m_blocks.emplace_back();
+      m_blocks.back().reserve(std::size_t(8) << (m_blocks.size() - 1));
+    }
+    m_blocks.back().emplace_back(std::piecewise_construct, std::forward_as_tuple(id),
+      std::forward_as_tuple(std::forward<Args>(args)...));
+    ++m_size;
+
+    m_table[i].key = id;
+    m_table[i].location = static_cast<std::uint32_t>(
+      ((m_blocks.size() - 1) << OFFSET_BITS) | (m_blocks.back().size() - 1));
+    return std::make_pair(value(m_table[i]), true);
+  }
+
+  /*! Get the value of a symbol, inserting a default constructed one if
+    there is none.
+    \param id the symbol
+    \return a reference to the value
+   */
+  T & operator[](SymbolId id) {
+    return *try_emplace(id).first;
+  }
+
+  /*! Determine if a predicate holds for every entry, visiting them in
+    insertion order.
+    \param pred called with each (symbol, value) pair
+    \return false as soon as pred does
+   */
+  template <typename Predicate>
+  bool all_of(Predicate pred) const {
+    for (auto & block : m_blocks) {
+      for (auto & entry : block) {
+        if (!pred(entry))
+          return false;
+      }
+    }
+    return true;
+  }
+
+  /// remove every entry, keeping the table
+  void clear() noexcept {
+    m_blocks.clear();
+    m_size = 0;
+    for (auto & slot : m_table)
+      slot.key = Symbols::None;
+  }
+
+private:
+
+  // a value is located by its block, in the high bits, and its offset in
+  // the block; the largest block holds 8 << 24 = 2^OFFSET_BITS values
+  static const unsigned OFFSET_BITS = 27;
+
+  struct Slot {
+    SymbolId key;
+    std::uint32_t location;
+  };
+
+  std::vector<Slot> m_table;
+  std::vector<std::vector<value_type> > m_blocks;
+  std::size_t m_size;
+
+  // 32 - log2 of the table size
+  unsigned m_shift;
+
+  // the preferred slot of id
+  std::size_t home(SymbolId id) const noexcept {
+    return static_cast<std::uint32_t>(id * 2654435769u) >> m_shift;
+  }
+
+  T * value(const Slot & slot) const noexcept {
+    const std::vector<value_type> & block = m_blocks[slot.location >> OFFSET_BITS];
+    return const_cast<T *>(&block[slot.location & ((1u << OFFSET_BITS) - 1)].second);
+  }
+
+  // double the table (to at least 8 slots) and rehash its slots
+  void grow() {
+
+    std::vector<Slot> old(std::move(m_table));
+    std::size_t size = old.empty() ? 8 : 2 * old.size();
+    m_table.assign(size, Slot{Symbols::None, 0});
+    for (m_shift = 32; size > 1; size >>= 1)
+      --m_shift;
+
+    const std::size_t mask = m_table.size() - 1;
+    for (auto & slot : old) {
+      if (slot.key == Symbols::None)
+        continue;
+      std::size_t i = home(slot.key);
+      while (m_table[i].key != Symbols::None)
+        i = (i + 1) & mask;
+      m_table[i] = slot;
+    }
+  }
+
+  void insertAll(const SymbolMap & other) {
+    other.all_of([this](const value_type & entry) {
+      try_emplace(entry.first, entry.second);
+      return true;
+    });
+  }
+};
+
+#endif
@@ -0,0 +1,152 @@
+#include "thread_pool.hpp"
+
+// the tasks of a batch left to finish, and the call of the thread running it
+struct ThreadPool::Batch {
+  const std::function<void(std::size_t)> * task;
+  std::atomic<std::size_t> remaining;
+  std::mutex mutex;
+  std::condition_variable done;
+};
+
+namespace {
+
+  // the pool and queue of a worker thread
+  struct Worker {
+    const ThreadPool * pool;
+    std::size_t queue;
+  };
+
+  thread_local Worker current = {nullptr, 0};
+
+  std::size_t defaultWorkers() {
+    unsigned cores = std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 0;
+  }
+
+  std::unique_ptr<ThreadPool> & sharedPool() {
+    static std::unique_ptr<ThreadPool> pool(new ThreadPool(defaultWorkers()));
+    return pool;
+  }
+}
+
+ThreadPool::ThreadPool(std::size_t workers) : m_queued(0), m_stopping(false) {
+
+  for (std::size_t i = 0; i <= workers; ++i)
+    m_queues.emplace_back(new Queue);
+
+  m_threads.reserve(workers);
+  for (std::size_t i = 0; i < workers; ++i)
+    m_threads.emplace_back(&ThreadPool::work, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_wake.notify_all();
+  for (auto & thread : m_threads)
+    thread.join();
+}
+
+void ThreadPool::run(std::size_t count, const std::function<void(std::size_t)> & task) {
+
+  if (count == 0)
+    return;
+
+  if (m_threads.empty()) {
+    for (std::size_t i = 0; i < count; ++i)
+      task(i);
+    return;
+  }
+
+  Batch batch;
+  batch.task = &task;
+  batch.remaining.store(count);
+
+  // deal a run of consecutive tasks to each queue, starting with our own;
+  // counting them first, a worker finding one queued never finds none left
+  const std::size_t queues = m_queues.size();
+  const std::size_t own = ownQueue();
+  m_queued.fetch_add(count);
+  for (std::size_t k = 0; k < queues; ++k) {
+    Queue & queue = *m_queues[(own + k) % queues];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    for (std::size_t i = k * count / queues; i < (k + 1) * count / queues; ++i)
+      queue.tasks.push_back(Task{&batch, i});
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+  }
+  m_wake.notify_all();
+
+  // help until no task is left to take, then wait for the others; the
+  // batch is only released once the last task let go of its mutex
+  while (batch.remaining.load() > 0 && runOne(own)) {
+  }
+  std::unique_lock<std::mutex> lock(batch.mutex);
+  batch.done.wait(lock, [&batch] { return batch.remaining.load() == 0; });
+}
+
+ThreadPool & ThreadPool::shared() {
+  return *sharedPool();
+}
+
+void ThreadPool::resizeShared(std::size_t workers) {
+  std::unique_ptr<ThreadPool> & pool = sharedPool();
+  pool.reset();
+  pool.reset(new ThreadPool(workers));
+}
+
+void ThreadPool::work(std::size_t i) {
+
+  current = Worker{this, i};
+
+  for (;;) {
+    if (runOne(i))
+      continue;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_wake.wait(lock, [this] { return m_stopping || m_queued.load() > 0; });
+    if (m_stopping)
+      return;
+  }
+}
+
+bool ThreadPool::runOne(std::size_t i) {
+
+  const std::size_t queues = m_queues.size();
+  Task task = {nullptr, 0};
+
+  for (std::size_t k = 0; k < queues && task.batch == nullptr; ++k) {
+    Queue & queue = *m_queues[(i + k) % queues];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+      continue;
+    if (k == 0) {
+      task = queue.tasks.back();
+      queue.tasks.pop_back();
+    }
+    else {
+      task = queue.tasks.front();
+      queue.tasks.pop_front();
+    }
+  }
+
+  if (task.batch == nullptr)
+    return false;
+
+  m_queued.fetch_sub(1);
+  (*task.batch->task)(task.index);
+
+  Batch & batch = *task.batch;
+  std::lock_guard<std::mutex> lock(batch.mutex);
+  if (batch.remaining.fetch_sub(1) == 1)
+    batch.done.notify_all();
+  return true;
+}
+
+std::size_t ThreadPool::ownQueue() const noexcept {
+  return current.pool == this ? current.queue : m_queues.size() - 1;
+}
@@ -0,0 +1,98 @@
+/*! \file thread_pool.hpp
+Defines the pool of worker threads the interpreter runs parallel work on.
+ */
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*! \class ThreadPool
+\brief A fixed set of worker threads running batches of tasks, where a
+thread out of tasks steals them from the others.
+
+Each worker has its own queue of tasks, and there is one more queue for the
+threads outside the pool. A batch is dealt over the queues of all threads
+that can run it. A thread takes the task it queued last from its own queue
+and, when that is empty, steals the oldest task of another queue, so the
+work spreads to threads that finish early.
+
+The thread running a batch runs its tasks too until they are all done, so
+a pool without workers runs everything in the calling thread, and a task
+may itself run a batch on the same pool without deadlocking.
+ */
+class ThreadPool {
+public:
+
+  /*! Start the workers.
+    \param workers the number of threads besides the calling ones
+   */
+  explicit ThreadPool(std::size_t workers);
+
+  /// stop the workers, once their current tasks are done
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool & operator=(const ThreadPool &) = delete;
+
+  /// the number of worker threads
+  std::size_t workers() const noexcept { return m_threads.size(); }
+
+  /*! Run task(0), ..., task(count - 1), in any order and on any thread of
+    the pool or on the calling thread, and return once they are all done.
+    \param count the number of tasks
+    \param task the task, which must not throw
+   */
+  void run(std::size_t count, const std::function<void(std::size_t)> & task);
+
+  /// the pool shared by the interpreters, with a worker per additional core
+  static ThreadPool & shared();
+
+  /*! Replace the workers of the shared pool, which must not be running a
+    batch.
+    \param workers the number of threads besides the calling ones
+   */
+  static void resizeShared(std::size_t workers);
+
+private:
+
+  struct Batch;
+
+  struct Task {
+    Batch * batch;
+    std::size_t index;
+  };
+
+  // the tasks queued by one thread, owned by the back and stolen from the front
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue> > m_queues; // one per worker, then the outside one
+  std::vector<std::thread> m_threads;
+
+  // the number of queued tasks, and the wake up call of idle workers
+  std::atomic<std::size_t> m_queued;
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  bool m_stopping;
+
+  // the worker loop of thread i
+  void work(std::size_t i);
+
+  // run one task from queue i, or stolen from another; false if there is none
+  bool runOne(std::size_t i);
+
+  // the queue of the calling thread
+  std::size_t ownQueue() const noexcept;
+};
+
+#endif
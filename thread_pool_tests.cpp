@@ -0,0 +1,48 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+TEST_CASE( "Test thread pool runs every task once", "[thread_pool]" ) {
+
+  for (std::size_t workers : {0, 1, 3}) {
+    INFO(workers << " workers");
+    ThreadPool pool(workers);
+    REQUIRE(pool.workers() == workers);
+
+    for (std::size_t count : {0, 1, 7, 1000}) {
+      INFO(count << " tasks");
+      std::vector<std::atomic<int> > runs(count);
+      for (auto & r : runs)
+        r.store(0);
+      pool.run(count, [&runs](std::size_t i) { ++runs[i]; });
+      for (std::size_t i = 0; i < count; ++i)
+        REQUIRE(runs[i].load() == 1);
+    }
+  }
+}
+
+TEST_CASE( "Test thread pool tasks running batches", "[thread_pool]" ) {
+
+  ThreadPool pool(2);
+  std::atomic<int> total(0);
+
+  pool.run(8, [&](std::size_t i) {
+    pool.run(i, [&](std::size_t) { ++total; });
+  });
+  REQUIRE(total.load() == 28);
+
+  {
+    INFO("batches from threads outside the pool");
+    total.store(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+      threads.emplace_back([&] { pool.run(100, [&](std::size_t) { ++total; }); });
+    for (auto & thread : threads)
+      thread.join();
+    REQUIRE(total.load() == 400);
+  }
+}
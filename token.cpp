@@ -2,7 +2,9 @@
 
 // system includes
 #include <cctype>
+#include <cstring>
 #include <iostream>
+#include <iterator>
 
 // define constants for special characters
 const char OPENCHAR = '(';
@@ -33,73 +35,134 @@ std::string Token::asString() const{
 }
 
 
-// add token to sequence unless it is empty, clears token
-void store_ifnot_empty(std::string & token, TokenSequenceType & seq){
-  if(!token.empty()){
-    seq.emplace_back(token);
-    token.clear();
+TokenSequenceType tokenize(std::istream & seq){
+  std::string text((std::istreambuf_iterator<char>(seq)), std::istreambuf_iterator<char>());
+
+  TokenSequenceType tokens;
+  Tokenizer tokenizer(text);
+  TokenSpan token;
+  while(tokenizer.next(token)){
+    if(token.type == Token::STRING)
+      tokens.emplace_back(token.text.str());
+    else
+      tokens.emplace_back(token.type);
   }
+
+  return tokens;
 }
 
-TokenSequenceType tokenize(std::istream & seq){
-  TokenSequenceType tokens;
-  std::string token;
-  bool isStringLiteral = false;
-  int doubleQuoteMarkCount = 0;
-  
-  while(true){
-    char c = seq.get();
-    if(seq.eof()) break;
-    
-    if(c == COMMENTCHAR){
-      // chomp until the end of the line
-      while((!seq.eof()) && (c != '\n')){
-	c = seq.get();
+// how the tokenizer treats each character
+enum CharClass {ORDINARY, SPACE, DELIMITER, COMMENT};
+
+static CharClass classOf(char c){
+  switch(c){
+  case OPENCHAR:
+  case CLOSECHAR:
+  case STRINGCHAR:
+    return DELIMITER;
+  case COMMENTCHAR:
+    return COMMENT;
+  case ' ': case '\t': case '\n': case '\v': case '\f': case '\r':
+    return SPACE;
+  default:
+    return ORDINARY;
+  }
+}
+
+Tokenizer::Tokenizer(const char * begin, const char * end) noexcept:
+  m_pos(begin), m_end(end), m_isStringLiteral(false), m_quoteCount(0),
+  m_hasPending(false), m_pending(Token::OPEN) {}
+
+Tokenizer::Tokenizer(const std::string & text) noexcept:
+  Tokenizer(text.data(), text.data() + text.size()) {}
+
+bool Tokenizer::next(TokenSpan & token){
+
+  if(m_hasPending){
+    m_hasPending = false;
+    token.type = m_pending;
+    token.text = StringSpan();
+    return true;
+  }
+
+  // the pending characters are [start, end), after m_joined if joined
+  const char * start = nullptr;
+  const char * end = m_end;
+  bool joined = false;
+
+  while(m_pos != m_end){
+    char c = *m_pos;
+
+    switch(classOf(c)){
+    case ORDINARY:
+      if(!start) start = m_pos;
+      ++m_pos;
+      continue;
+
+    case SPACE:
+      if(m_isStringLiteral){
+        if(!start) start = m_pos;
+        ++m_pos;
+        continue;
       }
-      if(seq.eof()) break;
-    }
-    else if(c == OPENCHAR){
-      store_ifnot_empty(token, tokens);
-      tokens.push_back(Token::TokenType::OPEN);
-    }
-    else if(c == CLOSECHAR){
-      store_ifnot_empty(token, tokens);
-      tokens.push_back(Token::TokenType::CLOSE);
+      if(start || joined){
+        end = m_pos++;
+        break;
+      }
+      ++m_pos;
+      continue;
+
+    case COMMENT: {
+      // the characters on both sides of a comment form one token
+      if(start){
+        if(joined)
+          m_joined.append(start, m_pos);
+        else
+          m_joined.assign(start, m_pos);
+        joined = true;
+        start = nullptr;
+      }
+      const void * newline = std::memchr(m_pos, '\n', m_end - m_pos);
+      m_pos = newline ? static_cast<const char *>(newline) + 1 : m_end;
+      continue;
     }
-	else if (c == STRINGCHAR) {
-
-		isStringLiteral = true;
-		doubleQuoteMarkCount++;
-		store_ifnot_empty(token, tokens);
-		tokens.push_back(Token::TokenType::STRINGLITERAL);
-
-		if (doubleQuoteMarkCount >= 2 && doubleQuoteMarkCount % 2 == 0)
-			isStringLiteral = false;
-		/*doubleQuoteMarkCount++;
-
-		if(doubleQuoteMarkCount == 1)
-			isStringLiteral = true;
-
-		if (doubleQuoteMarkCount == 2)
-		{
-			token.push_back(c);
-			store_ifnot_empty(token, tokens);
-			isStringLiteral = false;
-		}
-		else
-			token.push_back(c);*/
-	}
-    else if(isspace(c)){
-		if (isStringLiteral == true)
-			token.push_back(c);
-		else
-			store_ifnot_empty(token, tokens);
+
+    case DELIMITER: {
+      Token::TokenType type = (c == OPENCHAR) ? Token::OPEN :
+        (c == CLOSECHAR) ? Token::CLOSE : Token::STRINGLITERAL;
+      if(type == Token::STRINGLITERAL){
+        m_isStringLiteral = true;
+        ++m_quoteCount;
+        if(m_quoteCount >= 2 && m_quoteCount % 2 == 0)
+          m_isStringLiteral = false;
+      }
+      end = m_pos++;
+      if(start || joined){
+        m_hasPending = true;
+        m_pending = type;
+        break;
+      }
+      token.type = type;
+      token.text = StringSpan();
+      return true;
     }
-    else{
-      token.push_back(c);
     }
+
+    // a pending token ends here
+    break;
   }
-  store_ifnot_empty(token, tokens);
 
-  return tokens;
+  if(!start && !joined)
+    return false;
+
+  token.type = Token::STRING;
+  if(joined){
+    if(start)
+      m_joined.append(start, end);
+    token.text = StringSpan(m_joined);
+  }
+  else{
+    token.text = StringSpan(start, end - start);
+  }
+  return true;
 }
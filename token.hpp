@@ -4,8 +4,10 @@ Defines the Token and TokenSequence types, and associated functions.
 #ifndef TOKEN_HPP
 #define TOKEN_HPP
 
+#include <cstddef>
 #include <deque>
 #include <istream>
+#include <string>
 
 /*! \class Token
   \brief Value class representing a token.
@@ -60,4 +62,84 @@ Ignores any whitespace and comments (from any ";" to end-of-line).
 */
 TokenSequenceType tokenize(std::istream & seq);
 
+/*! \class StringSpan
+  \brief A non-owning view of a run of characters, in the manner of
+  C++17 std::string_view.
+*/
+class StringSpan {
+public:
+
+  /// construct an empty span
+  StringSpan() noexcept: m_data(nullptr), m_size(0) {}
+
+  /// construct a span of size characters starting at data
+  StringSpan(const char * data, std::size_t size) noexcept: m_data(data), m_size(size) {}
+
+  /// construct a span of the characters of str, valid while str is unchanged
+  StringSpan(const std::string & str) noexcept: m_data(str.data()), m_size(str.size()) {}
+
+  const char * data() const noexcept { return m_data; }
+  std::size_t size() const noexcept { return m_size; }
+  bool empty() const noexcept { return m_size == 0; }
+  char operator[](std::size_t i) const noexcept { return m_data[i]; }
+  const char * begin() const noexcept { return m_data; }
+  const char * end() const noexcept { return m_data + m_size; }
+
+  /// copy the characters into a string
+  std::string str() const { return std::string(m_data, m_size); }
+
+private:
+  const char * m_data;
+  std::size_t m_size;
+};
+
+/*! \struct TokenSpan
+  \brief A token whose text, for STRING tokens, is a span into the
+  tokenized buffer.
+*/
+struct TokenSpan {
+  Token::TokenType type;
+  StringSpan text;
+};
+
+/*! \class Tokenizer
+  \brief Splits a character buffer into tokens one at a time, in a single
+  pass and without copying.
+
+  Produces the same tokens as tokenize. The buffer must outlive the
+  Tokenizer and the spans it returns. A span is only copied (into storage
+  valid until the next call) in the rare case of a comment splitting a
+  token in two.
+*/
+class Tokenizer {
+public:
+
+  /// tokenize the characters in [begin, end)
+  Tokenizer(const char * begin, const char * end) noexcept;
+
+  /// tokenize the characters of text, which must outlive the Tokenizer
+  explicit Tokenizer(const std::string & text) noexcept;
+
+  /*! Pull the next token.
+    \param token set to the next token if there is one
+    \return false when the input is exhausted
+   */
+  bool next(TokenSpan & token);
+
+private:
+  const char * m_pos;
+  const char * m_end;
+
+  // string literal state, as in tokenize
+  bool m_isStringLiteral;
+  int m_quoteCount;
+
+  // a delimiter found right after a STRING token, returned next
+  bool m_hasPending;
+  Token::TokenType m_pending;
+
+  // the characters of a token split by a comment
+  std::string m_joined;
+};
+
 #endif
@@ -0,0 +1,111 @@
+#include "bench.hpp"
+
+#include <cctype>
+#include <sstream>
+#include <string>
+
+#include "token.hpp"
+
+// a generated script of about 8 MB: nested lists of numbers, symbols,
+// string literals and comments
+static const std::string & generatedScript() {
+
+  static std::string script;
+  if (script.empty()) {
+    std::ostringstream out;
+    out << "(begin\n";
+    for (int i = 0; script.size() + out.tellp() < (8u << 20); ++i) {
+      out << "  ; point " << i << "\n"
+          << "  (define p" << i << " (set-property \"label\" \"point number " << i
+          << "\" (list " << i * 0.25 << " -" << i % 97 << ".5e-1 (+ x" << i << " 1))))\n";
+    }
+    out << ")\n";
+    script = out.str();
+  }
+  return script;
+}
+
+// the character-at-a-time tokenizer tokenize used to be, kept as the
+// reference point of the benchmark
+static TokenSequenceType streamTokenize(std::istream & seq) {
+
+  TokenSequenceType tokens;
+  std::string token;
+  bool isStringLiteral = false;
+  int doubleQuoteMarkCount = 0;
+
+  auto store = [&] {
+    if (!token.empty()) {
+      tokens.emplace_back(token);
+      token.clear();
+    }
+  };
+
+  while (true) {
+    char c = seq.get();
+    if (seq.eof()) break;
+
+    if (c == ';') {
+      while ((!seq.eof()) && (c != '\n'))
+        c = seq.get();
+      if (seq.eof()) break;
+    }
+    else if (c == '(') {
+      store();
+      tokens.push_back(Token::OPEN);
+    }
+    else if (c == ')') {
+      store();
+      tokens.push_back(Token::CLOSE);
+    }
+    else if (c == '"') {
+      isStringLiteral = true;
+      doubleQuoteMarkCount++;
+      store();
+      tokens.push_back(Token::STRINGLITERAL);
+      if (doubleQuoteMarkCount >= 2 && doubleQuoteMarkCount % 2 == 0)
+        isStringLiteral = false;
+    }
+    else if (isspace(c)) {
+      if (isStringLiteral)
+        token.push_back(c);
+      else
+        store();
+    }
+    else {
+      token.push_back(c);
+    }
+  }
+  store();
+
+  return tokens;
+}
+
+// tokenizer throughput over the generated script
+BENCHMARK_CASE(tokenize_throughput) {
+
+  const std::string & script = generatedScript();
+  double megabytes = script.size() / double(1 << 20);
+
+  double ns = bench.run("character stream into TokenSequenceType", 5, [&] {
+    std::istringstream iss(script);
+    doNotOptimize(streamTokenize(iss));
+  });
+  bench.report("character stream into TokenSequenceType", megabytes / (ns * 1e-9), "MB/s");
+
+  ns = bench.run("tokenize stream into TokenSequenceType", 5, [&] {
+    std::istringstream iss(script);
+    doNotOptimize(tokenize(iss));
+  });
+  bench.report("tokenize stream into TokenSequenceType", megabytes / (ns * 1e-9), "MB/s");
+
+  ns = bench.run("Tokenizer spans over the buffer", 5, [&] {
+    Tokenizer tokenizer(script);
+    TokenSpan token;
+    std::size_t count = 0;
+    while (tokenizer.next(token))
+      count += token.text.size();
+    doNotOptimize(count);
+  });
+  bench.report("Tokenizer spans over the buffer", megabytes / (ns * 1e-9), "MB/s");
+}
@@ -78,3 +78,66 @@ TEST_CASE( "Test tokenize", "[token]" ) {
   REQUIRE(tokens.empty());
 }
 
+
+TEST_CASE( "Test Tokenizer", "[token]" ) {
+  std::string input = "(define \"a b\" (+ 1 2))";
+
+  Tokenizer tokenizer(input);
+  TokenSpan token;
+
+  REQUIRE(tokenizer.next(token));
+  REQUIRE(token.type == Token::OPEN);
+
+  REQUIRE(tokenizer.next(token));
+  REQUIRE(token.type == Token::STRING);
+  REQUIRE(token.text.str() == "define");
+  // the span points into the input
+  REQUIRE(token.text.data() == input.data() + 1);
+
+  REQUIRE(tokenizer.next(token));
+  REQUIRE(token.type == Token::STRINGLITERAL);
+
+  REQUIRE(tokenizer.next(token));
+  REQUIRE(token.type == Token::STRING);
+  REQUIRE(token.text.str() == "a b");
+
+  REQUIRE(tokenizer.next(token));
+  REQUIRE(token.type == Token::STRINGLITERAL);
+
+  REQUIRE(tokenizer.next(token));
+  REQUIRE(token.type == Token::OPEN);
+
+  REQUIRE(tokenizer.next(token));
+  REQUIRE(token.text.str() == "+");
+  REQUIRE(tokenizer.next(token));
+  REQUIRE(token.text.str() == "1");
+  REQUIRE(tokenizer.next(token));
+  REQUIRE(token.text.str() == "2");
+
+  REQUIRE(tokenizer.next(token));
+  REQUIRE(token.type == Token::CLOSE);
+  REQUIRE(tokenizer.next(token));
+  REQUIRE(token.type == Token::CLOSE);
+
+  REQUIRE(!tokenizer.next(token));
+  REQUIRE(!tokenizer.next(token));
+}
+
+TEST_CASE( "Test Tokenizer joins a token split by a comment", "[token]" ) {
+  std::string input = "(ab;c\ncd ef; last";
+
+  Tokenizer tokenizer(input);
+  TokenSpan token;
+
+  REQUIRE(tokenizer.next(token));
+  REQUIRE(token.type == Token::OPEN);
+
+  REQUIRE(tokenizer.next(token));
+  REQUIRE(token.type == Token::STRING);
+  REQUIRE(token.text.str() == "abcd");
+
+  REQUIRE(tokenizer.next(token));
+  REQUIRE(token.text.str() == "ef");
+
+  REQUIRE(!tokenizer.next(token));
+}
@@ -0,0 +1,98 @@
+#include "bench.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "interpreter.hpp"
+#include "vector_math.hpp"
+
+// the mean time of one evaluation of program, with l bound to a list of
+// 100k Numbers and c to a list of 100k Complex Numbers
+static double timeProgram(Bench & bench, const std::string & label, const std::string & program) {
+
+  Interpreter interp;
+  interp.useFolding(false);
+  std::istringstream definitions("(begin (define l (range 1 100000 1)) (define c (* l (+ 1 I)))"
+    " (define f (lambda (x) (+ x 1))) (define g (lambda (x) (* x x)))"
+    " (define h (lambda (x) (sqrt x))) (define k (lambda (x) (sin x)))"
+    " (define z (lambda (x) (* x I))))");
+  interp.parseStream(definitions);
+  interp.evaluate();
+
+  std::istringstream iss(program);
+  interp.parseStream(iss);
+
+  return bench.run(label, 20, [&] {
+    doNotOptimize(interp.evaluate());
+  });
+}
+
+// arithmetic over a list of 100k numbers called on the list and mapped
+// over it with a lambda
+BENCHMARK_CASE(list_arithmetic) {
+
+  const double count = 100001;
+  const std::vector<std::pair<std::string, std::string> > programs = {
+    {"(+ l 1)", "(map f l)"},
+    {"(* l l)", "(map g l)"},
+    {"(sqrt l)", "(map h l)"},
+    {"(sin l)", "(map k l)"},
+    {"(* c I)", "(map z c)"},
+  };
+
+  for (auto & program : programs) {
+    double list = timeProgram(bench, program.first, program.first);
+    double map = timeProgram(bench, program.second, program.second);
+    bench.report(program.first + " per element", list / count, "ns");
+    bench.report(program.second + " per element", map / count, "ns");
+    bench.report(program.first + " speedup", map / list, "x");
+  }
+}
+
+// the kernels on arrays of 4096 doubles, which stay in cache, for each
+// instruction set the processor supports
+BENCHMARK_CASE(vector_kernels) {
+
+  using namespace VectorMath;
+
+  const std::size_t n = 4096;
+  std::vector<double> a(n), b(n), out(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    a[i] = i + 1.;
+    b[i] = n - i + .5;
+  }
+
+  const Isa best = supported();
+  for (Isa isa : {Portable, SSE2, AVX2}) {
+    if (isa > best)
+      continue;
+    use(isa);
+    const std::string suffix = std::string(", ") + name(isa);
+
+    double add = bench.run("add" + suffix, 20000, [&] {
+      apply(Add, a.data(), 1, b.data(), 1, out.data(), n);
+      doNotOptimize(out);
+    });
+    bench.report("add per element" + suffix, add / n, "ns");
+
+    double divide = bench.run("divide by a number" + suffix, 20000, [&] {
+      apply(Divide, a.data(), 1, b.data(), 0, out.data(), n);
+      doNotOptimize(out);
+    });
+    bench.report("divide per element" + suffix, divide / n, "ns");
+
+    double root = bench.run("sqrt" + suffix, 20000, [&] {
+      sqrt(a.data(), out.data(), n);
+      doNotOptimize(out);
+    });
+    bench.report("sqrt per element" + suffix, root / n, "ns");
+
+    double multiply = bench.run("complex multiply" + suffix, 20000, [&] {
+      applyComplex(Multiply, a.data(), 1, b.data(), 1, out.data(), n / 2);
+      doNotOptimize(out);
+    });
+    bench.report("complex multiply per element" + suffix, multiply / (n / 2), "ns");
+  }
+  use(best);
+}
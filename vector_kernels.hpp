@@ -0,0 +1,288 @@
+/*! \file vector_kernels.hpp
+Defines the kernels of VectorMath once for any instruction set, for the
+translation units compiling them for a particular one. Not part of the
+interface of VectorMath.
+
+A translation unit describes its instruction set by a Lanes type:
+
+    struct Lanes {
+      typedef ... Vector;                   // width doubles
+      static const std::size_t width;
+      static Vector load(const double *);
+      static Vector broadcast(double);
+      static void store(double *, Vector);
+      static Vector add(Vector, Vector);    // also subtract, multiply, divide
+      static Vector negate(Vector);
+      static Vector sqrt(Vector);
+      static bool nonNegative(Vector);
+      static Vector min(Vector, Vector);    // the first where neither is less
+      static Vector max(Vector, Vector);    // the first where neither is greater
+      // only for a width of two or more:
+      static Vector broadcastComplex(const double *); // real, imaginary, ...
+      static Vector multiplyComplex(Vector, Vector);
+    };
+
+and takes its table from KernelTable<Lanes>. Everything here has internal
+linkage, so each translation unit keeps the copy compiled for its own
+instruction set. Nothing here may need a function of a library header
+that is not inline: its copy compiled for a better instruction set could be
+the one linked for every translation unit. The tables hold only addresses,
+so they are initialized before the program runs, without running any code
+compiled for their instruction set.
+ */
+#ifndef VECTOR_KERNELS_HPP
+#define VECTOR_KERNELS_HPP
+
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+
+#include "vector_math.hpp"
+
+namespace VectorMath {
+
+  // the kernels for one instruction set
+  struct Kernels {
+    typedef void (*Binary)(const double *, std::size_t, const double *, std::size_t,
+      double *, std::size_t);
+
+    Binary binary[4];        // by Operation
+    Binary binaryComplex[3]; // Add, Subtract and Multiply
+    void (*negate)(const double *, double *, std::size_t);
+    void (*sqrt)(const double *, double *, std::size_t);
+    bool (*nonNegative)(const double *, std::size_t);
+    void (*pairBounds)(const double *, std::size_t, double *, double *);
+  };
+
+  // the AVX2 kernels, or nullptr if the build cannot compile them; only to
+  // be called once the processor is known to have AVX2
+  const Kernels * avx2Kernels() noexcept;
+
+  // the best instruction set of the processor and the build, asking
+  // cpuHasAvx2 before avx2 is called, and so before any AVX2 code runs
+  Isa detect(bool (*cpuHasAvx2)(), const Kernels * (*avx2)()) noexcept;
+
+  namespace {
+
+    struct AddOp {
+      static double apply(double a, double b) { return a + b; }
+      template <typename L>
+      static typename L::Vector lanes(typename L::Vector a, typename L::Vector b) {
+        return L::add(a, b);
+      }
+      template <typename L>
+      static typename L::Vector complexLanes(typename L::Vector a, typename L::Vector b) {
+        return L::add(a, b);
+      }
+      static void complex(const double * a, const double * b, double * out) {
+        out[0] = a[0] + b[0];
+        out[1] = a[1] + b[1];
+      }
+    };
+
+    struct SubtractOp {
+      static double apply(double a, double b) { return a - b; }
+      template <typename L>
+      static typename L::Vector lanes(typename L::Vector a, typename L::Vector b) {
+        return L::subtract(a, b);
+      }
+      template <typename L>
+      static typename L::Vector complexLanes(typename L::Vector a, typename L::Vector b) {
+        return L::subtract(a, b);
+      }
+      static void complex(const double * a, const double * b, double * out) {
+        out[0] = a[0] - b[0];
+        out[1] = a[1] - b[1];
+      }
+    };
+
+    struct MultiplyOp {
+      static double apply(double a, double b) { return a * b; }
+      template <typename L>
+      static typename L::Vector lanes(typename L::Vector a, typename L::Vector b) {
+        return L::multiply(a, b);
+      }
+      template <typename L>
+      static typename L::Vector complexLanes(typename L::Vector a, typename L::Vector b) {
+        return L::multiplyComplex(a, b);
+      }
+      // the product before the recovery of infinities std::complex does
+      // when both parts are NaN
+      static void complex(const double * a, const double * b, double * out) {
+        out[0] = a[0] * b[0] - a[1] * b[1];
+        out[1] = a[0] * b[1] + a[1] * b[0];
+      }
+    };
+
+    struct DivideOp {
+      static double apply(double a, double b) { return a / b; }
+      template <typename L>
+      static typename L::Vector lanes(typename L::Vector a, typename L::Vector b) {
+        return L::divide(a, b);
+      }
+    };
+
+    template <typename L, typename Op>
+    void binary(const double * a, std::size_t aStride, const double * b, std::size_t bStride,
+      double * out, std::size_t n) {
+
+      const std::size_t width = L::width;
+      std::size_t i = 0;
+      if (aStride != 0 && bStride != 0) {
+        for (; i + width <= n; i += width)
+          L::store(out + i, Op::template lanes<L>(L::load(a + i), L::load(b + i)));
+      }
+      else if (aStride != 0) {
+        const typename L::Vector y = L::broadcast(*b);
+        for (; i + width <= n; i += width)
+          L::store(out + i, Op::template lanes<L>(L::load(a + i), y));
+      }
+      else if (bStride != 0) {
+        const typename L::Vector x = L::broadcast(*a);
+        for (; i + width <= n; i += width)
+          L::store(out + i, Op::template lanes<L>(x, L::load(b + i)));
+      }
+      for (; i < n; ++i)
+        out[i] = Op::apply(a[i * aStride], b[i * bStride]);
+    }
+
+    // do the leading complex numbers of n in vectors, returning how many
+    // were done; lanes narrower than one complex number do none
+    template <typename L, typename Op, bool = (L::width >= 2)>
+    struct ComplexLanes {
+      static std::size_t run(const double * a, std::size_t aStride, const double * b,
+        std::size_t bStride, double * out, std::size_t n) {
+
+        const std::size_t width = L::width / 2;
+        std::size_t i = 0;
+        if (aStride != 0 && bStride != 0) {
+          for (; i + width <= n; i += width)
+            L::store(out + 2 * i, Op::template complexLanes<L>(L::load(a + 2 * i), L::load(b + 2 * i)));
+        }
+        else if (aStride != 0) {
+          const typename L::Vector y = L::broadcastComplex(b);
+          for (; i + width <= n; i += width)
+            L::store(out + 2 * i, Op::template complexLanes<L>(L::load(a + 2 * i), y));
+        }
+        else if (bStride != 0) {
+          const typename L::Vector x = L::broadcastComplex(a);
+          for (; i + width <= n; i += width)
+            L::store(out + 2 * i, Op::template complexLanes<L>(x, L::load(b + 2 * i)));
+        }
+        return i;
+      }
+    };
+
+    template <typename L, typename Op>
+    struct ComplexLanes<L, Op, false> {
+      static std::size_t run(const double *, std::size_t, const double *, std::size_t,
+        double *, std::size_t) {
+        return 0;
+      }
+    };
+
+    template <typename L, typename Op>
+    void binaryComplex(const double * a, std::size_t aStride, const double * b, std::size_t bStride,
+      double * out, std::size_t n) {
+
+      std::size_t i = ComplexLanes<L, Op>::run(a, aStride, b, bStride, out, n);
+      for (; i < n; ++i)
+        Op::complex(a + 2 * i * aStride, b + 2 * i * bStride, out + 2 * i);
+    }
+
+    template <typename L>
+    void negate(const double * a, double * out, std::size_t n) {
+
+      std::size_t i = 0;
+      for (; i + L::width <= n; i += L::width)
+        L::store(out + i, L::negate(L::load(a + i)));
+      for (; i < n; ++i)
+        out[i] = -a[i];
+    }
+
+    template <typename L>
+    void sqrt(const double * a, double * out, std::size_t n) {
+
+      std::size_t i = 0;
+      for (; i + L::width <= n; i += L::width)
+        L::store(out + i, L::sqrt(L::load(a + i)));
+      for (; i < n; ++i)
+        out[i] = std::sqrt(a[i]);
+    }
+
+    template <typename L>
+    bool nonNegative(const double * a, std::size_t n) {
+
+      std::size_t i = 0;
+      for (; i + L::width <= n; i += L::width) {
+        if (!L::nonNegative(L::load(a + i)))
+          return false;
+      }
+      for (; i < n; ++i) {
+        if (!(a[i] >= 0))
+          return false;
+      }
+      return true;
+    }
+
+    // two vectors a round, so that every lane of each holds the same part
+    // of the pairs, whatever the width
+    template <typename L>
+    void pairBounds(const double * a, std::size_t n, double * low, double * high) {
+
+      const std::size_t width = L::width;
+      const std::size_t count = 2 * n;
+      low[0] = low[1] = DBL_MAX;
+      high[0] = high[1] = -DBL_MAX;
+      typename L::Vector lowLanes[2], highLanes[2];
+      for (int k = 0; k < 2; ++k) {
+        lowLanes[k] = L::broadcast(low[0]);
+        highLanes[k] = L::broadcast(high[0]);
+      }
+
+      std::size_t i = 0;
+      for (; i + 2 * width <= count; i += 2 * width) {
+        for (int k = 0; k < 2; ++k) {
+          typename L::Vector v = L::load(a + i + k * width);
+          lowLanes[k] = L::min(v, lowLanes[k]);
+          highLanes[k] = L::max(v, highLanes[k]);
+        }
+      }
+
+      double lanes[2 * L::width];
+      for (int k = 0; k < 2; ++k) {
+        L::store(lanes, lowLanes[k]);
+        L::store(lanes + width, highLanes[k]);
+        for (std::size_t j = 0; j < width; ++j) {
+          std::size_t part = (k * width + j) % 2;
+          if (lanes[j] < low[part])
+            low[part] = lanes[j];
+          if (lanes[width + j] > high[part])
+            high[part] = lanes[width + j];
+        }
+      }
+
+      for (; i < count; ++i) {
+        if (a[i] < low[i % 2])
+          low[i % 2] = a[i];
+        if (a[i] > high[i % 2])
+          high[i % 2] = a[i];
+      }
+    }
+
+    // the table of the kernels for lanes L
+    template <typename L>
+    struct KernelTable {
+      static const Kernels kernels;
+    };
+
+    template <typename L>
+    const Kernels KernelTable<L>::kernels = {
+      {&binary<L, AddOp>, &binary<L, SubtractOp>, &binary<L, MultiplyOp>, &binary<L, DivideOp>},
+      {&binaryComplex<L, AddOp>, &binaryComplex<L, SubtractOp>, &binaryComplex<L, MultiplyOp>},
+      &negate<L>, &sqrt<L>, &nonNegative<L>, &pairBounds<L>
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,211 @@
+#include "vector_math.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <complex>
+
+#include "vector_kernels.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VECTOR_MATH_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace VectorMath {
+
+  namespace {
+
+    struct PortableLanes {
+      typedef double Vector;
+      static const std::size_t width = 1;
+
+      static Vector load(const double * p) { return *p; }
+      static Vector broadcast(double x) { return x; }
+      static void store(double * p, Vector v) { *p = v; }
+      static Vector add(Vector a, Vector b) { return a + b; }
+      static Vector subtract(Vector a, Vector b) { return a - b; }
+      static Vector multiply(Vector a, Vector b) { return a * b; }
+      static Vector divide(Vector a, Vector b) { return a / b; }
+      static Vector negate(Vector a) { return -a; }
+      static Vector sqrt(Vector a) { return std::sqrt(a); }
+      static bool nonNegative(Vector a) { return a >= 0; }
+      static Vector min(Vector a, Vector b) { return a < b ? a : b; }
+      static Vector max(Vector a, Vector b) { return a > b ? a : b; }
+    };
+
+#ifdef VECTOR_MATH_SSE2
+    struct Sse2Lanes {
+      typedef __m128d Vector;
+      static const std::size_t width = 2;
+
+      static Vector load(const double * p) { return _mm_loadu_pd(p); }
+      static Vector broadcast(double x) { return _mm_set1_pd(x); }
+      static Vector broadcastComplex(const double * p) { return _mm_loadu_pd(p); }
+      static void store(double * p, Vector v) { _mm_storeu_pd(p, v); }
+      static Vector add(Vector a, Vector b) { return _mm_add_pd(a, b); }
+      static Vector subtract(Vector a, Vector b) { return _mm_sub_pd(a, b); }
+      static Vector multiply(Vector a, Vector b) { return _mm_mul_pd(a, b); }
+      static Vector divide(Vector a, Vector b) { return _mm_div_pd(a, b); }
+      static Vector negate(Vector a) { return _mm_xor_pd(a, _mm_set1_pd(-0.0)); }
+      static Vector sqrt(Vector a) { return _mm_sqrt_pd(a); }
+      static Vector min(Vector a, Vector b) { return _mm_min_pd(a, b); }
+      static Vector max(Vector a, Vector b) { return _mm_max_pd(a, b); }
+
+      static bool nonNegative(Vector a) {
+        return _mm_movemask_pd(_mm_cmpge_pd(a, _mm_setzero_pd())) == 3;
+      }
+
+      // (ar br - ai bi, ar bi + ai br), subtracting by adding the negation
+      static Vector multiplyComplex(Vector a, Vector b) {
+        Vector real = _mm_mul_pd(_mm_unpacklo_pd(a, a), b);
+        Vector imag = _mm_mul_pd(_mm_unpackhi_pd(a, a), _mm_shuffle_pd(b, b, 1));
+        return _mm_add_pd(real, _mm_xor_pd(imag, _mm_set_pd(0.0, -0.0)));
+      }
+    };
+#endif
+
+    std::atomic<int> chosen(-1);
+
+    bool cpuHasAvx2() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#else
+      return false;
+#endif
+    }
+
+    const Kernels & kernels() noexcept {
+
+      switch (active()) {
+      case AVX2:
+        return *avx2Kernels();
+#ifdef VECTOR_MATH_SSE2
+      case SSE2:
+        return KernelTable<Sse2Lanes>::kernels;
+#endif
+      default:
+        return KernelTable<PortableLanes>::kernels;
+      }
+    }
+  }
+
+  Isa detect(bool (*cpuHasAvx2)(), const Kernels * (*avx2)()) noexcept {
+
+    if (cpuHasAvx2() && avx2() != nullptr)
+      return AVX2;
+#ifdef VECTOR_MATH_SSE2
+    return SSE2;
+#else
+    return Portable;
+#endif
+  }
+
+  Isa supported() noexcept {
+    static const Isa isa = detect(cpuHasAvx2, avx2Kernels);
+    return isa;
+  }
+
+  Isa active() noexcept {
+    int isa = chosen.load(std::memory_order_relaxed);
+    if (isa < 0) {
+      isa = supported();
+      chosen.store(isa, std::memory_order_relaxed);
+    }
+    return static_cast<Isa>(isa);
+  }
+
+  Isa use(Isa isa) noexcept {
+    if (isa > supported())
+      isa = supported();
+    chosen.store(isa, std::memory_order_relaxed);
+    return isa;
+  }
+
+  const char * name(Isa isa) noexcept {
+    switch (isa) {
+    case AVX2:
+      return "AVX2";
+    case SSE2:
+      return "SSE2";
+    default:
+      return "portable";
+    }
+  }
+
+  void apply(Operation op, const double * a, std::size_t aStride,
+    const double * b, std::size_t bStride, double * out, std::size_t n) noexcept {
+
+    kernels().binary[op](a, aStride, b, bStride, out, n);
+  }
+
+  void applyComplex(Operation op, const double * a, std::size_t aStride,
+    const double * b, std::size_t bStride, double * out, std::size_t n) noexcept {
+
+    typedef std::complex<double> Complex;
+
+    if (op == Divide) {
+      for (std::size_t i = 0; i < n; ++i) {
+        const double * x = a + 2 * i * aStride;
+        const double * y = b + 2 * i * bStride;
+        Complex z = Complex(x[0], x[1]) / Complex(y[0], y[1]);
+        out[2 * i] = z.real();
+        out[2 * i + 1] = z.imag();
+      }
+      return;
+    }
+
+    kernels().binaryComplex[op](a, aStride, b, bStride, out, n);
+
+    if (op != Multiply)
+      return;
+
+    // a product whose parts are both NaN may be an infinity std::complex
+    // recovers; look for one without branching first, as there rarely is
+    bool recover = false;
+    for (std::size_t i = 0; i < n; ++i)
+      recover |= (out[2 * i] != out[2 * i]) & (out[2 * i + 1] != out[2 * i + 1]);
+
+    if (recover) {
+      for (std::size_t i = 0; i < n; ++i) {
+        if (std::isnan(out[2 * i]) && std::isnan(out[2 * i + 1])) {
+          const double * x = a + 2 * i * aStride;
+          const double * y = b + 2 * i * bStride;
+          Complex z = Complex(x[0], x[1]) * Complex(y[0], y[1]);
+          out[2 * i] = z.real();
+          out[2 * i + 1] = z.imag();
+        }
+      }
+    }
+  }
+
+  void negate(const double * a, double * out, std::size_t n) noexcept {
+    kernels().negate(a, out, n);
+  }
+
+  void sqrt(const double * a, double * out, std::size_t n) noexcept {
+    kernels().sqrt(a, out, n);
+  }
+
+  bool nonNegative(const double * a, std::size_t n) noexcept {
+    return kernels().nonNegative(a, n);
+  }
+
+  void pairBounds(const double * a, std::size_t n, double * low, double * high) noexcept {
+
+    kernels().pairBounds(a, n, low, high);
+
+    // the lanes met their zeros in another order than a scalar search, so
+    // 0 and -0 may be swapped; the first zero of the part settles it
+    for (int part = 0; part < 2; ++part) {
+      for (double * bound : {low + part, high + part}) {
+        if (*bound != 0)
+          continue;
+        std::size_t i = 0;
+        while (a[2 * i + part] != 0)
+          ++i;
+        *bound = a[2 * i + part];
+      }
+    }
+  }
+}
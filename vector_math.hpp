@@ -0,0 +1,97 @@
+/*! \file vector_math.hpp
+Defines the kernels applying arithmetic to contiguous arrays of numbers,
+as held by packed lists.
+ */
+#ifndef VECTOR_MATH_HPP
+#define VECTOR_MATH_HPP
+
+#include <cstddef>
+
+/*! \namespace VectorMath
+\brief Elementwise arithmetic over arrays of doubles, vectorized for the
+instruction set of the processor.
+
+Each kernel exists in a portable version and, on x86, in SSE2 and AVX2
+versions. The best version the processor supports is chosen on first use;
+use() can choose a lesser one, to compare them. Every version rounds each
+element exactly as the portable one does, so results do not depend on the
+processor.
+
+Complex numbers are stored as their real then imaginary part, as in a
+packed list. An operand is either an array, read with a stride of 1, or a
+single number repeated for every element, read with a stride of 0. The
+output must not overlap an operand.
+ */
+namespace VectorMath {
+
+  /// the instruction sets kernels are written for, from least to best
+  enum Isa {
+    Portable, ///< plain C++
+    SSE2,     ///< two doubles at a time
+    AVX2      ///< four doubles at a time
+  };
+
+  /// the arithmetic operations
+  enum Operation { Add, Subtract, Multiply, Divide };
+
+  /// the best instruction set both the processor and the build support
+  Isa supported() noexcept;
+
+  /// the instruction set the kernels run on
+  Isa active() noexcept;
+
+  /*! Choose the instruction set the kernels run on, for every thread.
+    \param isa the instruction set wanted
+    \return the instruction set chosen: isa, or supported() if lesser
+  */
+  Isa use(Isa isa) noexcept;
+
+  /// the name of an instruction set
+  const char * name(Isa isa) noexcept;
+
+  /*! Apply an operation to n pairs of Numbers: out[i] = a[i] op b[i].
+    \param op the operation
+    \param a the left operands
+    \param aStride 1 to read a as an array, 0 to repeat a[0]
+    \param b the right operands
+    \param bStride 1 to read b as an array, 0 to repeat b[0]
+    \param out the n results
+    \param n the number of elements
+  */
+  void apply(Operation op, const double * a, std::size_t aStride,
+    const double * b, std::size_t bStride, double * out, std::size_t n) noexcept;
+
+  /*! Apply an operation to n pairs of Complex Numbers, as std::complex
+    does. Division is not vectorized.
+    \param op the operation
+    \param a the left operands, two doubles each
+    \param aStride 1 to read a as an array, 0 to repeat its first number
+    \param b the right operands, two doubles each
+    \param bStride 1 to read b as an array, 0 to repeat its first number
+    \param out the n results, two doubles each
+    \param n the number of elements
+  */
+  void applyComplex(Operation op, const double * a, std::size_t aStride,
+    const double * b, std::size_t bStride, double * out, std::size_t n) noexcept;
+
+  /// out[i] = -a[i] for n doubles
+  void negate(const double * a, double * out, std::size_t n) noexcept;
+
+  /// out[i] = the square root of a[i] for n doubles
+  void sqrt(const double * a, double * out, std::size_t n) noexcept;
+
+  /// true if a[i] >= 0 for each of n doubles, so false if any is NaN
+  bool nonNegative(const double * a, std::size_t n) noexcept;
+
+  /*! Find the bounds of each part of n pairs of doubles, as coordinates
+    x, y are held by a packed list, ignoring NaN. Where a bound is zero it
+    has the sign of the first zero in its part, as a scalar search would.
+    \param a the pairs, two doubles each
+    \param n the number of pairs
+    \param low the least x and y, the largest double if there are none
+    \param high the greatest x and y, the lowest double if there are none
+  */
+  void pairBounds(const double * a, std::size_t n, double * low, double * high) noexcept;
+}
+
+#endif
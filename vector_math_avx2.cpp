@@ -0,0 +1,56 @@
+// Compiled for AVX2 when the compiler supports it (see CMakeLists.txt); the
+// kernels only run where VectorMath finds the processor has it.
+#include "vector_kernels.hpp"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace VectorMath {
+
+#ifdef __AVX2__
+  namespace {
+
+    struct Avx2Lanes {
+      typedef __m256d Vector;
+      static const std::size_t width = 4;
+
+      static Vector load(const double * p) { return _mm256_loadu_pd(p); }
+      static Vector broadcast(double x) { return _mm256_set1_pd(x); }
+      static void store(double * p, Vector v) { _mm256_storeu_pd(p, v); }
+      static Vector add(Vector a, Vector b) { return _mm256_add_pd(a, b); }
+      static Vector subtract(Vector a, Vector b) { return _mm256_sub_pd(a, b); }
+      static Vector multiply(Vector a, Vector b) { return _mm256_mul_pd(a, b); }
+      static Vector divide(Vector a, Vector b) { return _mm256_div_pd(a, b); }
+      static Vector negate(Vector a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+      static Vector sqrt(Vector a) { return _mm256_sqrt_pd(a); }
+      static Vector min(Vector a, Vector b) { return _mm256_min_pd(a, b); }
+      static Vector max(Vector a, Vector b) { return _mm256_max_pd(a, b); }
+
+      static bool nonNegative(Vector a) {
+        return _mm256_movemask_pd(_mm256_cmp_pd(a, _mm256_setzero_pd(), _CMP_GE_OQ)) == 0xF;
+      }
+
+      static Vector broadcastComplex(const double * p) {
+        return _mm256_broadcast_pd(reinterpret_cast<const __m128d *>(p));
+      }
+
+      // (ar br - ai bi, ar bi + ai br) for two complex numbers, multiplying
+      // and adding separately as the portable kernel does, never fused
+      static Vector multiplyComplex(Vector a, Vector b) {
+        Vector real = _mm256_mul_pd(_mm256_movedup_pd(a), b);
+        Vector imag = _mm256_mul_pd(_mm256_permute_pd(a, 0xF), _mm256_permute_pd(b, 0x5));
+        return _mm256_addsub_pd(real, imag);
+      }
+    };
+  }
+
+  const Kernels * avx2Kernels() noexcept {
+    return &KernelTable<Avx2Lanes>::kernels;
+  }
+#else
+  const Kernels * avx2Kernels() noexcept {
+    return nullptr;
+  }
+#endif
+}
@@ -0,0 +1,199 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "vector_kernels.hpp"
+#include "vector_math.hpp"
+
+// the same number, or both NaN
+static bool same(double a, double b) {
+  return (std::isnan(a) && std::isnan(b))
+    || (a == b && std::signbit(a) == std::signbit(b));
+}
+
+static bool same(const std::vector<double> & a, const std::vector<double> & b) {
+  if (a.size() != b.size())
+    return false;
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    if (!same(a[i], b[i]))
+      return false;
+  }
+  return true;
+}
+
+// n random numbers, led by the special values and of a length that leaves
+// a remainder after every vector width
+static std::vector<double> numbers(std::size_t n, unsigned seed) {
+
+  const double inf = std::numeric_limits<double>::infinity();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  std::vector<double> values = {0., -0., 1., -1., inf, -inf, nan, 1e-310, 1e308};
+
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> dist(-100, 100);
+  while (values.size() < n)
+    values.push_back(dist(gen));
+  values.resize(n);
+  return values;
+}
+
+// pairs whose bounds are zeros of either sign, the first zero of x being 0
+// and of y being -0
+static std::vector<double> zeros() {
+  return {5, -1, 0, -0., 7, -3, -0., 0, 2, -0., 0, -2, 9, 0, 1, -7, -0., -0., 4, -7, 3, 0};
+}
+
+// the results of every kernel on the same operands
+static std::vector<std::vector<double> > results(const std::vector<double> & a,
+  const std::vector<double> & b) {
+
+  using namespace VectorMath;
+
+  const std::size_t n = a.size();
+  std::vector<std::vector<double> > out;
+  auto result = [&](std::size_t size) -> double * {
+    out.emplace_back(size);
+    return out.back().data();
+  };
+
+  for (Operation op : {Add, Subtract, Multiply, Divide}) {
+    apply(op, a.data(), 1, b.data(), 1, result(n), n);
+    apply(op, a.data(), 1, b.data(), 0, result(n), n);
+    apply(op, a.data(), 0, b.data(), 1, result(n), n);
+    applyComplex(op, a.data(), 1, b.data(), 1, result(n), n / 2);
+    applyComplex(op, a.data(), 1, b.data() + 4, 0, result(n), n / 2);
+    applyComplex(op, a.data() + 2, 0, b.data(), 1, result(n), n / 2);
+  }
+  negate(a.data(), result(n), n);
+  sqrt(a.data(), result(n), n);
+  for (std::size_t offset : {0, 1, 9}) {
+    double * bounds = result(4);
+    pairBounds(a.data() + offset, (n - offset) / 2, bounds, bounds + 2);
+  }
+  double * none = result(4);
+  pairBounds(a.data(), 0, none, none + 2);
+  double * zero = result(4);
+  pairBounds(zeros().data(), zeros().size() / 2, zero, zero + 2);
+  out.push_back({double(nonNegative(a.data(), n)), double(nonNegative(a.data() + 9, n - 9)),
+    double(nonNegative(b.data() + 9, 5))});
+  return out;
+}
+
+TEST_CASE( "Test vector math kernels", "[vector_math]" ) {
+
+  using namespace VectorMath;
+
+  const std::size_t n = 2 * 19;
+  std::vector<double> a = numbers(n, 1);
+  std::vector<double> b = numbers(n, 2);
+  std::reverse(b.begin(), b.begin() + 9);
+  for (std::size_t i = 9; i < n; ++i)
+    b[i] = std::abs(b[i]);
+
+  const Isa best = supported();
+
+  {
+    INFO("the portable kernels follow scalar and std::complex arithmetic");
+    REQUIRE(use(Portable) == Portable);
+    REQUIRE(active() == Portable);
+
+    std::vector<double> sum(n), product(n), quotient(n), root(n);
+    apply(Add, a.data(), 1, b.data(), 0, sum.data(), n);
+    applyComplex(Multiply, a.data(), 1, b.data(), 1, product.data(), n / 2);
+    applyComplex(Divide, a.data(), 0, b.data(), 1, quotient.data(), n / 2);
+    sqrt(b.data(), root.data(), n);
+    for (std::size_t i = 0; i < n; ++i) {
+      INFO(i);
+      REQUIRE(same(sum[i], a[i] + b[0]));
+      REQUIRE(same(root[i], std::sqrt(b[i])));
+    }
+
+    double low[2], high[2];
+    pairBounds(a.data() + 1, n / 2 - 1, low, high);
+    for (int part = 0; part < 2; ++part) {
+      double least = std::numeric_limits<double>::max();
+      double greatest = std::numeric_limits<double>::lowest();
+      for (std::size_t i = 1 + part; i + 1 < n; i += 2) {
+        if (a[i] < least)
+          least = a[i];
+        if (a[i] > greatest)
+          greatest = a[i];
+      }
+      REQUIRE(same(low[part], least));
+      REQUIRE(same(high[part], greatest));
+    }
+
+    pairBounds(zeros().data(), zeros().size() / 2, low, high);
+    REQUIRE(same(low[0], 0.));
+    REQUIRE(same(high[0], 9.));
+    REQUIRE(same(low[1], -7.));
+    REQUIRE(same(high[1], -0.));
+    for (std::size_t i = 0; i < n / 2; ++i) {
+      INFO(i);
+      std::complex<double> x(a[2 * i], a[2 * i + 1]), y(b[2 * i], b[2 * i + 1]);
+      REQUIRE(same(product[2 * i], (x * y).real()));
+      REQUIRE(same(product[2 * i + 1], (x * y).imag()));
+      std::complex<double> z = std::complex<double>(a[0], a[1]) / y;
+      REQUIRE(same(quotient[2 * i], z.real()));
+      REQUIRE(same(quotient[2 * i + 1], z.imag()));
+    }
+  }
+
+  std::vector<std::vector<double> > expected = results(a, b);
+
+  for (Isa isa : {SSE2, AVX2}) {
+    if (isa > best)
+      continue;
+    INFO(name(isa));
+    REQUIRE(use(isa) == isa);
+    std::vector<std::vector<double> > actual = results(a, b);
+    REQUIRE(actual.size() == expected.size());
+    for (std::size_t k = 0; k < expected.size(); ++k) {
+      INFO("kernel " << k);
+      REQUIRE(same(actual[k], expected[k]));
+    }
+  }
+
+  {
+    INFO("an instruction set the processor lacks is not chosen");
+    REQUIRE(use(AVX2) == best);
+    REQUIRE(active() == best);
+  }
+}
+
+// how the detection of the instruction set went
+static int avx2Lookups = 0;
+
+static bool withoutAvx2() { return false; }
+static bool withAvx2() { return true; }
+
+static const VectorMath::Kernels * countedAvx2Kernels() {
+  ++avx2Lookups;
+  return VectorMath::avx2Kernels();
+}
+
+TEST_CASE( "Test vector math asks the processor before running AVX2 code", "[vector_math]" ) {
+
+  using namespace VectorMath;
+
+  {
+    INFO("a processor without AVX2 never reaches the AVX2 kernels");
+    avx2Lookups = 0;
+    REQUIRE(detect(withoutAvx2, countedAvx2Kernels) < AVX2);
+    REQUIRE(avx2Lookups == 0);
+  }
+
+  {
+    INFO("a processor with AVX2 gets them if the build has them");
+    avx2Lookups = 0;
+    Isa isa = detect(withAvx2, countedAvx2Kernels);
+    REQUIRE(avx2Lookups == 1);
+    REQUIRE((isa == AVX2) == (avx2Kernels() != nullptr));
+  }
+}
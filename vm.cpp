@@ -0,0 +1,240 @@
+#include "vm.hpp"
+
+#include <functional>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#include "semantic_error.hpp"
+
+namespace {
+
+// upper bound on the number of compiled lambdas kept around
+const std::size_t MAX_CACHED_FUNCTIONS = 1024;
+
+std::size_t hashCombine(std::size_t seed, std::size_t value) {
+  return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+std::size_t hashAtom(const Atom & a) {
+
+  if (a.isNumber())
+    return std::hash<double>()(a.asNumber());
+  if (a.isSymbol())
+    return a.symbolId();
+  if (a.isComplexNumber())
+    return hashCombine(std::hash<double>()(a.asComplexNumber().real()),
+      std::hash<double>()(a.asComplexNumber().imag()));
+  if (a.isStringLiteral())
+    return std::hash<std::string>()(a.asStringLiteral());
+  return 0;
+}
+
+std::size_t hashExpression(const Expression & exp) {
+
+  std::size_t seed = hashAtom(exp.head());
+  for (auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e)
+    seed = hashCombine(seed, hashExpression(*e));
+  return seed;
+}
+
+} // namespace
+
+const Expression * VirtualMachine::lookup(SymbolId id) const {
+
+  for (auto frame = m_frames.rbegin(); frame != m_frames.rend(); ++frame) {
+    const std::vector<SymbolId> & names = frame->function->slotNames;
+    for (std::size_t i = names.size(); i > 0; --i) {
+      std::size_t slot = frame->slotBase + i - 1;
+      if (names[i - 1] == id && m_bound[slot])
+        return &m_slots[slot];
+    }
+  }
+
+  return m_env->find_exp(Atom::fromSymbolId(id));
+}
+
+std::shared_ptr<Function> VirtualMachine::functionFor(const Expression & lambda) {
+
+  const void * id = lambda.tailId();
+  auto same = m_byStorage.find(id);
+  if (same != m_byStorage.end())
+    return same->second.second;
+
+  if (m_cache.size() >= MAX_CACHED_FUNCTIONS) {
+    m_cache.clear();
+    m_byStorage.clear();
+  }
+
+  std::shared_ptr<Function> fn;
+  std::size_t key = hashExpression(lambda);
+
+  auto range = m_cache.equal_range(key);
+  for (auto it = range.first; it != range.second && !fn; ++it) {
+    if (it->second.first == lambda)
+      fn = it->second.second;
+  }
+
+  if (!fn) {
+    fn = compileLambda(lambda, *m_env);
+    m_cache.emplace(key, CacheEntry(lambda.heapCopy(), fn));
+  }
+
+  if (id != nullptr)
+    m_byStorage.emplace(id, CacheEntry(lambda, fn));
+
+  return fn;
+}
+
+Expression VirtualMachine::callTree(const Function & fn, std::vector<Expression> & args) {
+
+  // make the locals of the active frames visible, outermost first
+  Environment visible(m_env);
+  for (const Frame & frame : m_frames) {
+    const std::vector<SymbolId> & names = frame.function->slotNames;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+      if (m_bound[frame.slotBase + i])
+        visible.add_exp(Atom::fromSymbolId(names[i]), m_slots[frame.slotBase + i]);
+    }
+  }
+
+  Environment frame(&visible);
+  for (std::size_t i = 0; i < args.size(); ++i)
+    frame.add_exp(fn.params[i], std::move(args[i]));
+
+  return fn.body.eval(frame);
+}
+
+void VirtualMachine::popArgs(std::size_t n, std::vector<Expression> & args) {
+
+  std::size_t first = m_stack.size() - n;
+  args.assign(std::make_move_iterator(m_stack.begin() + first),
+              std::make_move_iterator(m_stack.end()));
+  m_stack.resize(first);
+}
+
+Expression VirtualMachine::run(const std::shared_ptr<Function> & program, Environment & env) {
+
+  m_env = &env;
+  m_stack.clear();
+  m_slots.clear();
+  m_bound.clear();
+  m_frames.clear();
+  m_callees.clear();
+
+  // lambdas found by identity may live in the arena of a past evaluation
+  m_byStorage.clear();
+
+  m_frames.push_back(Frame{program, 0, 0});
+
+  std::vector<Expression> args;
+  while (true) {
+
+    Frame & frame = m_frames.back();
+    Function & fn = *frame.function;
+    const Instruction ins = fn.code[frame.pc++];
+
+    switch (ins.op) {
+    case PUSH_CONST:
+      m_stack.push_back(fn.constants[ins.a]);
+      break;
+
+    case LOAD_NAME:
+    case LOAD_LOCAL:
+    {
+      std::size_t slot = frame.slotBase + ins.a;
+      if (ins.op == LOAD_LOCAL && m_bound[slot]) {
+        m_stack.push_back(m_slots[slot]);
+        break;
+      }
+
+      SymbolId id = (ins.op == LOAD_LOCAL) ? fn.slotNames[ins.a] : ins.a;
+      const Expression * value = lookup(id);
+      if (value == nullptr)
+        throw SemanticError("Error during evaluation: unknown symbol");
+      m_stack.push_back(*value);
+      break;
+    }
+
+    case DEFINE_NAME:
+      m_env->add_exp(Atom::fromSymbolId(ins.a), m_stack.back());
+      break;
+
+    case DEFINE_LOCAL:
+      m_slots[frame.slotBase + ins.a] = m_stack.back();
+      m_bound[frame.slotBase + ins.a] = 1;
+      break;
+
+    case POP:
+      m_stack.pop_back();
+      break;
+
+    case CALL_PROC:
+      popArgs(ins.b, args);
+      m_stack.push_back(fn.procedures[ins.a](std::move(args)));
+      break;
+
+    case PREPARE_CALL:
+    {
+      Callee callee;
+      const Expression * value = lookup(ins.a);
+      if (value != nullptr && value->head().symbolId() == Symbols::Lambda) {
+        callee = functionFor(*value);
+        if (ins.b > callee->params.size())
+          throw SemanticError("Error in call to lambda: invalid number of arguments");
+      }
+      m_callees.push_back(callee);
+      break;
+    }
+
+    case CALL:
+    {
+      Callee callee = std::move(m_callees.back());
+      m_callees.pop_back();
+
+      if (!callee)
+        throw SemanticError("Error during evaluation: symbol does not name a procedure");
+
+      if (callee->treeOnly) {
+        popArgs(ins.b, args);
+        m_stack.push_back(callTree(*callee, args));
+        break;
+      }
+
+      // bind the arguments to the first slots of a new frame
+      std::size_t slotBase = m_slots.size();
+      m_slots.resize(slotBase + callee->slotNames.size());
+      m_bound.resize(slotBase + callee->slotNames.size(), 0);
+
+      std::size_t first = m_stack.size() - ins.b;
+      for (std::size_t i = 0; i < ins.b; ++i) {
+        m_slots[slotBase + i] = std::move(m_stack[first + i]);
+        m_bound[slotBase + i] = 1;
+      }
+      m_stack.resize(first);
+
+      m_frames.push_back(Frame{callee, 0, slotBase});
+      break;
+    }
+
+    case EVAL_TREE:
+      m_stack.push_back(fn.constants[ins.a].eval(*m_env));
+      break;
+
+    case RETURN:
+    {
+      Expression result = std::move(m_stack.back());
+      m_stack.pop_back();
+
+      if (m_frames.size() == 1)
+        return result;
+
+      m_slots.resize(frame.slotBase);
+      m_bound.resize(frame.slotBase);
+      m_frames.pop_back();
+      m_stack.push_back(std::move(result));
+      break;
+    }
+    }
+  }
+}
@@ -0,0 +1,90 @@
+/*! \file vm.hpp
+Defines the stack machine executing the bytecode of bytecode.hpp.
+ */
+#ifndef VM_HPP
+#define VM_HPP
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "bytecode.hpp"
+#include "environment.hpp"
+#include "expression.hpp"
+
+/*! \class VirtualMachine
+\brief A stack machine producing the same results as Expression::eval.
+
+Calls between compiled lambdas push a frame on an explicit stack instead of
+recursing in C++. Lambda parameters and local definitions live in numbered
+slots; a symbol without a slot is resolved through the slots of the active
+frames, innermost first, and then the environment, which is exactly the set
+of bindings the tree walker would see.
+
+Compiled lambdas are cached by their value, so evaluating the same lambda
+over many points compiles it once. Calling a lambda bound in the
+environment finds it by the identity of its shared storage in O(1).
+ */
+class VirtualMachine {
+public:
+
+  /*! Execute a compiled program.
+    \param program the result of compileProgram
+    \param env the environment to look symbols up and define them in
+    \return the value of the program
+    \throws SemanticError when a semantic error is encountered
+   */
+  Expression run(const std::shared_ptr<Function> & program, Environment & env);
+
+private:
+
+  // an active call
+  struct Frame {
+    std::shared_ptr<Function> function;
+    std::size_t pc;        // next instruction
+    std::size_t slotBase;  // first slot of the frame in m_slots
+  };
+
+  // the result of a PREPARE_CALL, nullptr if the symbol is not a lambda
+  typedef std::shared_ptr<Function> Callee;
+
+  // value stack
+  std::vector<Expression> m_stack;
+
+  // local slots of all active frames, and whether each one is bound
+  std::vector<Expression> m_slots;
+  std::vector<char> m_bound;
+
+  // call stack and pending callees
+  std::vector<Frame> m_frames;
+  std::vector<Callee> m_callees;
+
+  // the environment of the current run
+  Environment * m_env = nullptr;
+
+  // a lambda value with its compiled form
+  typedef std::pair<Expression, std::shared_ptr<Function> > CacheEntry;
+
+  // compiled lambdas by hash of their value
+  std::unordered_multimap<std::size_t, CacheEntry> m_cache;
+
+  // compiled lambdas by the identity of their shared tail during one run;
+  // an entry keeps its lambda alive, so a matching id means the very same
+  // value
+  std::unordered_map<const void *, CacheEntry> m_byStorage;
+
+  // the binding of id in the active frames or the environment, or nullptr
+  const Expression * lookup(SymbolId id) const;
+
+  // the compiled form of a lambda value
+  std::shared_ptr<Function> functionFor(const Expression & lambda);
+
+  // evaluate a treeOnly function with the tree walker
+  Expression callTree(const Function & fn, std::vector<Expression> & args);
+
+  // pop the top n values of the stack into args
+  void popArgs(std::size_t n, std::vector<Expression> & args);
+};
+
+#endif